@@ -0,0 +1,263 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ESIDL_COMPILER_H_INCLUDED
+#define ESIDL_COMPILER_H_INCLUDED
+
+#include "esidl.h"
+#include "dependency.h"
+
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Compiler is the library interface of esidl. A compilation takes three
+// steps:
+//
+//     Compiler compiler(options);
+//     compiler.parse(files);      // preprocess and parse the IDL files
+//     compiler.resolve();         // process extended attributes, meta data
+//     compiler.generate(Compiler::MessengerTarget, &outputs);
+//
+// The parsed specification stays resident in the Compiler, so generate()
+// can be called repeatedly for the targets that share the same options,
+// e.g., the four messenger targets, or once for all of them with a list of
+// jobs to generate them concurrently. Every Compiler has its own Context;
+// separate Compiler objects can be used on separate threads concurrently.
+class Compiler
+{
+public:
+    enum Target
+    {
+        CxxTarget,              // -cxx, C++ header files (default)
+        MessengerTarget,        // -messenger
+        MessengerSrcTarget,     // -messenger-src
+        MessengerImpTarget,     // -messenger-imp
+        MessengerImpSrcTarget,  // -messenger-imp-src
+        JavaTarget,             // -java
+        SheetTarget,            // -sheet
+        CxxModuleTarget         // -cxx-module
+    };
+
+    struct Options
+    {
+        std::vector<std::string> cppOptions;    // -I, -include and -isystem options for cpp
+        std::string includePath;                // stripped from the output file names
+        bool isystem;
+        bool useExceptions;
+        bool useVirtualBase;
+        bool useMultipleInheritance;            // must be false for the messenger targets
+        bool useSpan;                           // messenger targets only
+        bool useMove;                           // messenger targets only
+        bool useMinimalIncludes;                // messenger targets only
+        bool useDispatchTable;                  // messenger targets only
+        bool useMemberTable;                    // messenger targets only
+        bool collectSizes;                      // for printSizeReport()
+        bool keepUnchanged;                     // not to rewrite the files having the same contents
+        int unitySize;                          // messenger source targets only; -1 for a file per interface
+        std::string stringTypeName;
+        std::string stringViewTypeName;         // CxxTarget only; empty to pass strings by stringTypeName
+        std::string stringPoolName;             // CxxTarget and MessengerTarget only; empty to embed the reflection data in each interface
+        std::string modulePrelude;              // CxxModuleTarget only; the header included before each module unit
+        std::string objectTypeName;
+        std::string indent;
+        std::string namespaceName;              // flat namespace name if not empty
+        std::string prefix;
+        std::string ctorScope;                  // must be "_" for the Java and sheet targets
+        std::string outputRoot;                 // the directory the files are written under if not empty
+        bool skeleton;                          // CxxTarget only
+        bool generic;                           // CxxTarget only
+
+        Options();
+    };
+
+    typedef std::map<std::string, std::string> Outputs;
+
+    // A target to be generated by generate(Jobs*). The files are written
+    // under outputRoot, or under Options::outputRoot if it is empty, unless
+    // outputs is not zero.
+    struct Job
+    {
+        Target target;
+        std::string outputRoot;
+        Outputs* outputs;
+        bool succeeded;
+
+        explicit Job(Target target = CxxTarget, const std::string& outputRoot = "", Outputs* outputs = 0);
+    };
+    typedef std::vector<Job> Jobs;
+
+    // The wall clock time and the CPU time spent in a phase, in seconds.
+    // The CPU time of cpp is that of the child process running it.
+    struct Time
+    {
+        double wall;
+        double cpu;
+
+        Time();
+    };
+
+    struct Timings
+    {
+        Time cpp;
+        Time parse;
+        Time processExtendedAttributes;
+        Time adjustMethodCount;
+        Time meta;
+        Time dependencyGraph;
+        Time generate;                          // of the last generate()
+    };
+
+    // What generate() has produced for a target, summed over the calls.
+    struct GeneratorStatistics
+    {
+        Time time;
+        unsigned long files;
+        unsigned long written;                  // to the file system, stdout or the outputs map
+        unsigned long skipped;                  // left untouched with keepUnchanged as they had not changed
+        unsigned long long bytes;
+
+        GeneratorStatistics();
+    };
+
+private:
+    Options options;
+    Context context;
+    std::vector<std::string> files;
+    DependencyGraph dependencyGraph;
+    Timings timings;
+    std::map<Target, GeneratorStatistics> generatorStatistics;
+
+    struct JobState;
+
+    Compiler(const Compiler&);
+    Compiler& operator=(const Compiler&);
+
+    void setUp(Context* context) const;
+    bool load(const std::vector<std::string>& files);
+    bool run(Target target) const;
+    void count(Target target, const Time& time, const Context::Statistics& before, const Context::Statistics& after);
+    static void* runJob(void* param);
+
+public:
+    explicit Compiler(const Options& options = Options());
+    ~Compiler();
+
+    const Options& getOptions() const
+    {
+        return options;
+    }
+
+    Node* getSpecification() const
+    {
+        return context.specification;
+    }
+
+    const Timings& getTimings() const
+    {
+        return timings;
+    }
+
+    const std::map<Target, GeneratorStatistics>& getGeneratorStatistics() const
+    {
+        return generatorStatistics;
+    }
+
+    // The counters of the nodes, the name lookups and the generated files.
+    const Context::Statistics& getStatistics() const
+    {
+        return context.statistics;
+    }
+
+    // Prints the timings and the statistics as a JSON object.
+    void printStatistics(FILE* file) const;
+
+    // Prints how many files each of the generated outputs includes, and how
+    // many of the other outputs include it directly and transitively, i.e.,
+    // are to be recompiled when it changes.
+    static void printIncludeReport(const Outputs& outputs, FILE* file);
+
+    // Prints as a JSON array the bytes generate() has written for each
+    // interface by each generator, with the selector cases of the
+    // dispatchers, the operations and the C++ functions they are expanded
+    // to, the length of the meta data, and the number of the supplemental
+    // interfaces. The interfaces are listed from the largest. Requires
+    // Options::collectSizes.
+    void printSizeReport(FILE* file) const;
+
+    // The dependency graph is available after resolve().
+    const DependencyGraph& getDependencyGraph() const
+    {
+        return dependencyGraph;
+    }
+
+    // Preprocesses the specified IDL files with cpp and parses them. parse()
+    // must be called only once for each Compiler.
+    bool parse(const std::vector<std::string>& files);
+
+    // Processes the extended attributes, adjusts the method counts and
+    // computes the meta data of the parsed specification.
+    bool resolve();
+
+    // Generates the files for target. If outputs is not zero, the generated
+    // files are stored in outputs by file name instead of being written to
+    // the file system; the sheet target is stored as "-". Otherwise the files
+    // are written, except those whose contents have not changed if
+    // Options::keepUnchanged is set.
+    bool generate(Target target, Outputs* outputs = 0);
+
+    // Updates the resolved specification after the specified IDL files have
+    // been modified, and generates again only the files of target that may
+    // have changed: each modified file is parsed alone, and its definitions
+    // replace the current ones in the specification. The interfaces the old
+    // and the new definitions impact according to the dependency graph are
+    // linked, linearized and given their meta data again, and the files made
+    // from them, from the other definitions using the modified definitions,
+    // and from the modified files are generated. outputs is to hold the files
+    // of the last generation; the generated files replace theirs, and the
+    // files of the removed definitions are erased from it.
+    //
+    // Returns false without changing the specification if a modified file
+    // is included by another file, changes the files it includes, or gives
+    // extended attributes to a module, and if it cannot be parsed; a full
+    // compilation with a new Compiler is then needed. Once the specification
+    // has been changed, a false result means the Compiler can no longer be
+    // used.
+    bool update(const std::vector<std::string>& modified, Target target, Outputs* outputs);
+
+    // Generates the targets of jobs concurrently, each on its own thread.
+    // The threads share the resolved specification, which the generators
+    // do not modify, and write the files through their own Contexts. The
+    // C++ target, which adds the forward declarations to the specification,
+    // is generated after the others on the calling thread; as the added
+    // declarations change its output, jobs should have at most one C++
+    // target. Returns true if every job has succeeded.
+    bool generate(Jobs* jobs);
+
+    // Collects the names of the IDL files read by parse(): the specified
+    // files and the files they include directly or indirectly, except the
+    // system headers.
+    void getSources(std::set<std::string>* sources) const;
+
+    // Collects the names of the files generated by the last generate() that
+    // may change when the named interface changes. Returns false if there
+    // is no such interface.
+    bool getImpact(const std::string& interfaceName, std::set<std::string>* filenames) const;
+};
+
+#endif  // ESIDL_COMPILER_H_INCLUDED
@@ -32,6 +32,7 @@ protected:
     const char* source;
 
     std::string stringTypeName;
+    std::string stringViewTypeName;
     std::string objectTypeName;
     bool useExceptions;
 
@@ -100,12 +101,41 @@ protected:
         return stringTypeName != "char*";
     }
 
+    // Returns true if the in DOMString parameters are passed by the string
+    // view type, and the attribute setters take the strings by rvalue
+    // references so that they can be moved into the implementation.
+    bool useStringView() const
+    {
+        return hasCustomStringType() && !stringViewTypeName.empty();
+    }
+
+    // Returns the type of the value given to the setter of the attribute.
+    static Node* getSetterSpec(const Attribute* node)
+    {
+        static Type replaceable("any");
+        Node* spec = node->getSpec();
+        if (node->isReplaceable())
+        {
+            spec = &replaceable;
+        }
+        else if (node->isPutForwards())
+        {
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(node->getParent()));
+            assert(target);
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
+            assert(forwards);
+            spec = forwards->getSpec();
+        }
+        return spec;
+    }
+
 public:
     Cxx(const char* source, FILE* file, const char* stringTypeName = "char*", const char* objectTypeName = "object",
-        bool useExceptions = true, const char* indent = "es") :
+        bool useExceptions = true, const char* indent = "es", const char* stringViewTypeName = "") :
         Formatter(file, indent),
         source(source),
         stringTypeName(stringTypeName),
+        stringViewTypeName(stringViewTypeName),
         objectTypeName(objectTypeName),
         useExceptions(useExceptions),
         constructorMode(false),
@@ -300,22 +330,9 @@ public:
             return false;
         }
 
-        static Type replaceable("any");
         std::string cap = node->getName().c_str();
         cap[0] = toupper(cap[0]);   // XXX
-        Node* spec = node->getSpec();
-        if (node->isReplaceable())
-        {
-            spec = &replaceable;
-        }
-        else if (node->isPutForwards())
-        {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(node->getParent()));
-            assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
-            assert(forwards);
-            spec = forwards->getSpec();
-        }
+        Node* spec = getSetterSpec(node);
         SequenceType* seq = const_cast<SequenceType*>(spec->isSequence(node->getParent()));
         std::string name = getBufferName(node);
 
@@ -335,6 +352,12 @@ public:
                 write(", int %sLength)", name.c_str());
             }
         }
+        else if (spec->isString(node->getParent()) && useStringView())
+        {
+            write("void set%s(", cap.c_str());
+            spec->accept(this);
+            write("&& %s)", name.c_str());
+        }
         else if (spec->isString(node->getParent()))
         {
             write("void set%s(const ", cap.c_str());
@@ -450,7 +473,7 @@ public:
         variadicParam = 0;
         for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
         {
-            ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+            ParamDcl* param = dyn_cast<ParamDcl>(*i);
             assert(param);
             if (param->isOptional())
             {
@@ -479,7 +502,7 @@ public:
 
     virtual void at(const ParamDcl* node)
     {
-        static SequenceType variadicSequence(0);
+        SequenceType variadicSequence(0);
 
         Node* spec = node->getSpec();
         SequenceType* seq = const_cast<SequenceType*>(spec->isSequence(node->getParent()));
@@ -490,6 +513,12 @@ public:
             seq = &variadicSequence;
         }
 
+        if (!node->isVariadic() && spec->isString(node->getParent()) && useStringView())
+        {
+            write("%s %s", stringViewTypeName.c_str(), node->getName().c_str());
+            return;
+        }
+
         if (seq && !seq->getSpec()->isInterface(currentNode) ||
             spec->isString(node->getParent()) ||
             spec->isArray(node->getParent()))
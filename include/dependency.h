@@ -0,0 +1,83 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ESIDL_DEPENDENCY_H_INCLUDED
+#define ESIDL_DEPENDENCY_H_INCLUDED
+
+#include "esidl.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// DependencyGraph records how the interfaces in a specification depend on
+// each other. It is built once after the specification has been resolved,
+// i.e., after ProcessExtendedAttributes and AdjustMethodCount.
+class DependencyGraph
+{
+public:
+    enum Kind
+    {
+        Extends = 1,        // interface A : B
+        Implements = 2,     // A implements B
+        Supplemental = 4,   // B is supplemental to A, e.g., partial interface A
+        Uses = 8            // B is used as a type in A
+    };
+
+    // The interfaces at the other end of the edges, with the bitwise OR of
+    // the kinds of the edges.
+    typedef std::map<const Interface*, unsigned> Edges;
+
+private:
+    std::vector<const Interface*> interfaces;       // in the order of definition
+    std::map<const Interface*, Edges> dependencies;  // A -> the interfaces A depends on
+    std::map<const Interface*, Edges> dependents;    // B -> the interfaces depending on B
+
+    void addUses(const Interface* interface, const Node* spec, const Node* scope);
+
+public:
+    void clear();
+    void build(Node* specification);
+
+    void add(const Interface* interface);
+    void addEdge(const Interface* from, const Interface* to, Kind kind);
+
+    const std::vector<const Interface*>& getInterfaces() const
+    {
+        return interfaces;
+    }
+
+    // Returns 0 if the interface does not depend on any other interface.
+    const Edges* getDependencies(const Interface* interface) const;
+
+    // Returns 0 if no other interface depends on the interface.
+    const Edges* getDependents(const Interface* interface) const;
+
+    // Finds an interface by its qualified name like "::dom::Node", or by its
+    // name alone. If the interface is defined more than once, the last
+    // definition is returned as ScopedName::search() does.
+    const Interface* find(const std::string& name) const;
+
+    // Collects the interfaces whose generated code may change when the
+    // specified interface changes: the interface itself, the interfaces
+    // deriving from it, implementing it or absorbing it as a supplemental
+    // interface, transitively, and the interfaces using any of them as a
+    // type. The result is conservative.
+    void getImpact(const Interface* interface, std::set<const Interface*>* impact) const;
+};
+
+#endif  // ESIDL_DEPENDENCY_H_INCLUDED
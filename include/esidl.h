@@ -27,6 +27,7 @@
 #include <string.h>
 #include <list>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -62,9 +63,213 @@ class Node;
         class ParamDcl;
     class ExtendedAttribute;
 class Visitor;
+class SizeProbe;
 
 typedef std::list<Node*> NodeList;
 
+// A view of a meta data string kept in a MetaArena. The string is not
+// terminated by '\0' when it is a part of another one.
+class MetaString
+{
+    const char* data;
+    size_t size;
+
+public:
+    MetaString() :
+        data(""),
+        size(0)
+    {
+    }
+
+    MetaString(const char* data, size_t size) :
+        data(data),
+        size(size)
+    {
+    }
+
+    const char* begin() const
+    {
+        return data;
+    }
+
+    const char* end() const
+    {
+        return data + size;
+    }
+
+    size_t length() const
+    {
+        return size;
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    char operator[](size_t i) const
+    {
+        assert(i < size);
+        return data[i];
+    }
+
+    std::string str() const
+    {
+        return std::string(data, size);
+    }
+};
+
+// MetaArena keeps the meta data strings of a specification in blocks which
+// are never moved or freed until the arena is destroyed, so that the nodes
+// can refer to the strings by MetaString without owning a copy.
+class MetaArena
+{
+    std::vector<char*> blocks;
+    char* next;
+    size_t left;
+    size_t size;
+
+    MetaArena(const MetaArena&);
+    MetaArena& operator=(const MetaArena&);
+
+public:
+    MetaArena();
+    ~MetaArena();
+
+    // Allocates a block of at least capacity bytes for the strings to come.
+    void reserve(size_t capacity);
+
+    // Copies s into the arena with a terminating '\0'.
+    MetaString store(const std::string& s);
+
+    // The bytes stored so far, excluding the terminating '\0's.
+    size_t getSize() const
+    {
+        return size;
+    }
+};
+
+// Context holds the state of a compilation: the specification being built
+// and the options affecting it. The functions below operate on the context
+// of the calling thread, so that independent IDL sets can be compiled
+// concurrently on separate threads.
+class Context
+{
+public:
+    Node*               specification;
+    Node*               current;        // current name space
+    const char*         includePath;
+    std::string         javadoc;
+    std::string         savedJavadoc;
+    std::string         baseFilename;
+    std::string         filename;
+    int                 level;          // current include level
+    const char*         namespaceName;  // flat namespace name if non zero
+    const char*         defaultPrefix;  // ::org::w3c::dom
+    const char*         ctorScope;      // "::" by default. could be "_"
+    bool                useMultipleInheritance;
+    bool                useVirtualBase;
+    bool                useSpan;        // pass sequences of primitive types as a pointer and a length
+    bool                useMove;        // move the arguments into and out of Any in the messenger targets
+    bool                useMinimalIncludes;  // forward declare the classes the messenger headers do not need to be complete
+    bool                useDispatchTable;  // call the implementation classes through member tables from non-template dispatchers
+    bool                useMemberTable; // emit the flattened member table of each interface into the messenger headers
+    int                 unitySize;      // the most interfaces per amalgamated messenger source; 0 for one per module, -1 for none
+    unsigned            supplementalCount;
+
+    // Scanner and parser state
+    bool                poundMode;
+    long                stdinOffset;
+    long                stdinLine;
+
+    // If non zero, the generated files are kept in this map by file name
+    // instead of being written to the file system.
+    std::map<std::string, std::string>* outputs;
+
+    // The directory the generated files are written under; the current
+    // directory if empty.
+    std::string outputRoot;
+
+    // If true, a file already having the generated contents is left
+    // untouched; see closeOutput().
+    bool keepUnchanged;
+
+    struct OutputBuffer
+    {
+        std::string filename;
+        char* data;
+        size_t size;
+    };
+    std::map<FILE*, OutputBuffer*> outputBuffers;
+
+    // If selective is set, only the files in selectedFiles, the files made
+    // from the definitions in selectedNodes or from the IDL files in
+    // selectedSources, and the files made from neither are generated; see
+    // openOutput().
+    bool selective;
+    std::set<std::string> selectedFiles;
+    std::set<const Node*> selectedNodes;
+    std::set<std::string> selectedSources;
+
+    // The forward declarations the C++ target has added to the specification.
+    std::vector<Node*> forwardDeclarations;
+
+    // The definition or the IDL file each generated file has been made from.
+    struct OutputOrigin
+    {
+        const Node* node;
+        std::string source;
+        std::vector<const Node*> nodes;     // all the definitions in an amalgamated file
+    };
+    std::map<std::string, OutputOrigin> outputOrigins;
+
+    // Counters reported by 'esidl --stats'.
+    struct Statistics
+    {
+        unsigned long nodes;                // Node objects created
+        unsigned long resolveCalls;
+        unsigned resolveDepth;              // current nesting of resolve()
+        unsigned maxResolveDepth;
+        unsigned long searchCalls;          // Node::search() including its recursive calls
+        unsigned long searchComparisons;    // names compared by Node::search()
+        unsigned long filesWritten;
+        unsigned long filesSkipped;         // unchanged on disk, hence left untouched with keepUnchanged
+        unsigned long long bytes;           // generated, whether written or skipped
+
+        Statistics();
+    };
+    Statistics statistics;
+
+    MetaArena           metaArena;      // the meta data strings of the specification
+
+    // The sizes reported by 'esidl --size-report', collected by SizeProbe
+    // for each interface and generator while collectSizes is set.
+    struct GeneratorSize
+    {
+        unsigned long long bytes;           // excluding those of the nested generators
+        unsigned long cases;                // selector cases of the dispatchers
+
+        GeneratorSize();
+    };
+    typedef std::map<std::string, GeneratorSize> GeneratorSizes;
+    bool collectSizes;
+    std::map<const Interface*, GeneratorSizes> sizes;
+    SizeProbe* sizeProbe;                   // the innermost one in scope
+
+    Context();
+};
+
+// Thrown when the compilation cannot continue. The error has been reported
+// to stderr already.
+class CompilationError
+{
+};
+
+// Returns the context of the calling thread. A thread that has not set its
+// own context shares the default one.
+Context* getContext();
+Context* setContext(Context* context);
+
 Node* getSpecification();
 Node* setSpecification(Node* node);
 Node* getCurrent();
@@ -96,7 +301,42 @@ inline uint32_t one_at_a_time(const char* key, size_t len)
 
 class Node
 {
+public:
+    // The kind of a node tells its class without RTTI. The kinds of the
+    // classes derived from a class follow the kind of the class, so that
+    // classof() of the class checks a range of kinds.
+    enum Kind
+    {
+        NodeKind,
+        IncludeKind,
+        ScopedNameKind,
+        ModuleKind,
+        StructTypeKind,
+            ExceptDclKind,
+        UnionTypeKind,
+        ImplementsKind,
+        InterfaceKind,
+            DictionaryKind,
+        TypeKind,
+            NativeTypeKind,
+            EnumKind,
+        SequenceTypeKind,
+        VariadicTypeKind,
+        ArrayTypeKind,
+        BinaryExprKind,
+        UnaryExprKind,
+        GroupingExpressionKind,
+        LiteralKind,
+        MemberKind,
+            AttributeKind,
+            ConstDclKind,
+            OpDclKind,
+            ParamDclKind,
+        ExtendedAttributeKind
+    };
+
 protected:
+    Kind                kind;           // set by the constructor of each class
     uint32_t            attr;
     Node*               parent;
     NodeList*           children;
@@ -112,14 +352,11 @@ protected:
     int                 lastLine;
     int                 lastColumn;
 
-    mutable std::string meta;           // TODO: meta should not be mutable. fix later.
+    mutable MetaString  meta;           // in the MetaArena of the context; set by Meta
     mutable uint32_t    hash;
+    unsigned long       serial;         // the order of creation in the context
 
-    static int          level;          // current include level
     static const char*  baseObjectName; // default base object name
-    static const char*  namespaceName;  // flat namespace name if non zero
-    static const char*  defaultPrefix;  // ::org::w3c::dom
-    static const char*  ctorScope;      // "::" by default. could be "_"
 
     static std::map<uint32_t, std::string> hashMap;
 
@@ -212,57 +449,65 @@ public:
         vreport(message, ap);
         va_end(ap);
 
-        exit(EXIT_FAILURE);
+        throw CompilationError();
         return false;
     }
 
     Node() :
+        kind(NodeKind),
         attr(0),
         parent(0),
         children(0),
         offset(0),
-        rank(level),
+        rank(getContext()->level),
         extendedAttributes(0),
         source(getFilename()),
         hash(0)
     {
+        serial = ++getContext()->statistics.nodes;
     }
 
     Node(std::string name) :
+        kind(NodeKind),
         attr(0),
         parent(0),
         children(0),
         name(name),
         offset(0),
-        rank(level),
+        rank(getContext()->level),
         extendedAttributes(0),
         source(getFilename()),
         hash(0)
     {
+        serial = ++getContext()->statistics.nodes;
     }
 
     Node(NodeList* children) :
+        kind(NodeKind),
         attr(0),
         parent(0),
         offset(0),
-        rank(level),
+        rank(getContext()->level),
         extendedAttributes(0),
         source(getFilename()),
         hash(0)
     {
+        serial = ++getContext()->statistics.nodes;
         setChildren(children);
     }
 
     Node(std::string name, NodeList* children) :
+        kind(NodeKind),
         attr(0),
         parent(0),
         name(name),
         offset(0),
-        rank(level),
+        rank(getContext()->level),
         extendedAttributes(0),
         source(getFilename()),
         hash(0)
     {
+        serial = ++getContext()->statistics.nodes;
         setChildren(children);
     }
 
@@ -292,16 +537,44 @@ public:
         }
     }
 
+    Kind getKind() const
+    {
+        return kind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return true;
+    }
+
     const std::string& getSource() const
     {
         return source;
     }
 
-    std::string& getMeta() const
+    // The nodes created earlier have smaller serial numbers.
+    unsigned long getSerial() const
+    {
+        return serial;
+    }
+    void setSerial(unsigned long serial)
+    {
+        this->serial = serial;
+    }
+
+    // The meta data of an interface, which starts with its I, X and M names,
+    // or of a constant. An attribute keeps its meta data in getMetaGetter()
+    // and getMetaSetter(), and an operation in getMetaOp().
+    const MetaString& getMeta() const
     {
         return meta;
     }
 
+    void setMeta(const MetaString& meta) const
+    {
+        this->meta = meta;
+    }
+
     uint32_t getHash() const
     {
         return hash;
@@ -373,7 +646,23 @@ public:
         node->setParent(this);
     }
 
-    void remove(Node* node)
+    // Adds node in front of the child next, or at the end if next is 0.
+    void insert(Node* node, Node* next)
+    {
+        add(node);
+        if (next)
+        {
+            children->pop_back();
+            NodeList::iterator i = children->begin();
+            while (i != children->end() && *i != next)
+            {
+                ++i;
+            }
+            children->insert(i, node);
+        }
+    }
+
+    virtual void remove(Node* node)
     {
         assert(children);
         node->setParent(0);
@@ -652,12 +941,12 @@ public:
 
     static int incLevel()
     {
-        return ++level;
+        return ++getContext()->level;
     }
 
     static int decLevel()
     {
-        return --level;
+        return --getContext()->level;
     }
 
     static const char* getBaseObjectName()
@@ -672,35 +961,71 @@ public:
 
     static void setFlatNamespace(const char* name)
     {
-        namespaceName = name;
+        getContext()->namespaceName = name;
     }
 
     static const char* getFlatNamespace()
     {
-        return namespaceName ;
+        return getContext()->namespaceName;
     }
 
     static void setDefaultPrefix(const char* name)
     {
-        defaultPrefix = name;
+        getContext()->defaultPrefix = name;
     }
 
     static const char* getDefaultPrefix()
     {
-        return defaultPrefix;
+        return getContext()->defaultPrefix;
     }
 
     static void setCtorScope(const char* name)
     {
-        ctorScope = name;
+        getContext()->ctorScope = name;
     }
 
     static const char* getCtorScope()
     {
-        return ctorScope;
+        return getContext()->ctorScope;
     }
 };
 
+// isa<T>(node) tests whether node is a T by the kind of the node.
+template <class T>
+inline bool isa(const Node* node)
+{
+    return T::classof(node);
+}
+
+// cast<T>(node) converts node to T*; node must be a T.
+template <class T>
+inline T* cast(Node* node)
+{
+    assert(isa<T>(node));
+    return static_cast<T*>(node);
+}
+
+template <class T>
+inline const T* cast(const Node* node)
+{
+    assert(isa<T>(node));
+    return static_cast<const T*>(node);
+}
+
+// dyn_cast<T>(node) converts node to T* if node is a T, or returns 0
+// otherwise. node can be 0.
+template <class T>
+inline T* dyn_cast(Node* node)
+{
+    return (node && isa<T>(node)) ? static_cast<T*>(node) : 0;
+}
+
+template <class T>
+inline const T* dyn_cast(const Node* node)
+{
+    return (node && isa<T>(node)) ? static_cast<const T*>(node) : 0;
+}
+
 class Include : public Node
 {
     bool system;
@@ -710,12 +1035,18 @@ public:
         Node(identifier),
         system(system)
     {
+        kind = IncludeKind;
         if (name[0] == '"')
         {
             name = name.substr(1, name.size() - 2);
         }
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == IncludeKind;
+    }
+
     bool isSystem() const
     {
         return system;
@@ -730,6 +1061,12 @@ public:
     ScopedName(std::string identifier) :
         Node(identifier)
     {
+        kind = ScopedNameKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ScopedNameKind;
     }
 
     Node* search(const Node* scope) const;
@@ -864,11 +1201,18 @@ public:
         constCount(0),
         moduleCount(0)
     {
+        kind = ModuleKind;
         rank = 1;   // 'cause namespace is open.
         javadoc = ::getJavadoc();
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ModuleKind;
+    }
+
     virtual void add(Node* node);
+    virtual void remove(Node* node);
 
     int getInterfaceCount() const
     {
@@ -913,7 +1257,7 @@ public:
         }
         if (0 < prefix.length())
         {
-            if (Module* parent = dynamic_cast<Module*>(getParent()))
+            if (Module* parent = dyn_cast<Module>(getParent()))
             {
                 return parent->getPrefixedName() + "::" + prefix + body;
             }
@@ -921,17 +1265,17 @@ public:
         }
         if (getQualifiedName() == "::dom")
         {
-            return defaultPrefix;
+            return getDefaultPrefix();
         }
-        if (Module* parent = dynamic_cast<Module*>(getParent()))
+        if (Module* parent = dyn_cast<Module>(getParent()))
         {
             return parent->getPrefixedName() + body;
         }
-        if (!strcmp(defaultPrefix, "::"))
+        if (!strcmp(getDefaultPrefix(), "::"))
         {
             return body;
         }
-        return defaultPrefix + body;
+        return getDefaultPrefix() + body;
     }
 
     virtual Module* isModule(const Node* scope) const
@@ -953,9 +1297,15 @@ public:
         extends(extends),
         memberCount(0)
     {
+        kind = StructTypeKind;
         javadoc = ::getJavadoc();
     }
 
+    static bool classof(const Node* node)
+    {
+        return StructTypeKind <= node->getKind() && node->getKind() <= ExceptDclKind;
+    }
+
     virtual void add(Node* node);
 
     Node* getExtends() const
@@ -982,9 +1332,15 @@ public:
     ExceptDcl(std::string identifier, Node* extends = 0) :
         StructType(identifier, extends)
     {
+        kind = ExceptDclKind;
         javadoc = ::getJavadoc();
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ExceptDclKind;
+    }
+
     virtual void accept(Visitor* visitor);
 };
 
@@ -993,9 +1349,15 @@ class UnionType : public Node
 public:
     UnionType ()
     {
+        kind = UnionTypeKind;
         javadoc = ::getJavadoc();
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == UnionTypeKind;
+    }
+
     virtual UnionType* isUnion(const Node* scope) const
     {
         return const_cast<UnionType*>(this);
@@ -1013,6 +1375,12 @@ public:
         first(first),
         second(second)
     {
+        kind = ImplementsKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ImplementsKind;
     }
 
     ScopedName* getFirst()
@@ -1032,19 +1400,49 @@ public:
 class Interface : public Node
 {
 public:
-    static bool useMultipleInheritance;
+    // An entry of the flattened member table of an interface.
+    struct MemberEntry
+    {
+        const Node* member;         // Attribute, OpDcl or ConstDcl
+        const Interface* owner;     // the interface whose class declares the member
+        unsigned depth;             // 0 if owner is this interface, 1 if it is the super interface, ...
+        unsigned number;            // the member number counted from the root interface
+    };
+    typedef std::map<std::string, MemberEntry> MemberTable;
+
+    // A definition in this interface or in one of its supplemental
+    // interfaces, with the interface it is defined in.
+    struct MergedMember
+    {
+        const Interface* interface;
+        Node* node;
+    };
+    typedef std::vector<MergedMember> MergedMembers;
 
 private:
     Node* extends;
     size_t constCount;
     size_t methodCount;
     size_t staticMethodCount;
-    mutable size_t interfaceCount;  // total number of non-supplemental interfaces this interface will implement excluding Object.
+    size_t interfaceCount;  // total number of non-supplemental interfaces this interface will implement excluding Object.
     Interface* constructor;
     std::list<const Interface*> supplementalList;
     std::list<const Interface*> implementList;
     std::list<const Interface*> superList;
 
+    // Linearized from the lists above by linearize(), together with
+    // interfaceCount. The generators only read them, possibly on several
+    // threads at once.
+    bool linearized;
+    std::vector<const Interface*> interfaceList;
+    std::vector<const Interface*> mixinList;
+    std::vector<const Interface*> expandedSupplementals;
+    MergedMembers mergedMembers;
+    MemberTable memberTable;
+    unsigned memberCount;   // including the inherited members
+
+    void linearize();
+
 public:
     Interface(std::string identifier, Node* extends = 0, bool forward = false) :
         Node(identifier),
@@ -1053,8 +1451,11 @@ public:
         methodCount(0),
         staticMethodCount(0),
         interfaceCount(0),
-        constructor(0)
+        constructor(0),
+        linearized(false),
+        memberCount(0)
     {
+        kind = InterfaceKind;
         if (!forward)
         {
             children = new NodeList;
@@ -1062,6 +1463,11 @@ public:
         javadoc = ::getJavadoc();
     }
 
+    static bool classof(const Node* node)
+    {
+        return InterfaceKind <= node->getKind() && node->getKind() <= DictionaryKind;
+    }
+
     ~Interface()
     {
         if (extends)
@@ -1142,8 +1548,68 @@ public:
         return staticMethodCount;
     }
 
-    size_t getInterfaceCount() const;
-    void getInterfaceList(std::list<const Interface*>* list) const;
+    size_t getInterfaceCount() const
+    {
+        assert(linearized);
+        return interfaceCount;
+    }
+
+    // The following three vectors, the member table and the interface count
+    // are computed once, by the Linearize visitor after AdjustMethodCount
+    // has completed the inheritance, the mixin and the supplemental lists,
+    // and are shared by every generator.
+
+    // This interface followed by the non-supplemental interfaces it derives
+    // from or implements, depth first.
+    const std::vector<const Interface*>& getInterfaceList() const
+    {
+        assert(linearized);
+        return interfaceList;
+    }
+
+    // The non-supplemental mixins of this interface and of its base
+    // interfaces; empty unless multiple inheritance is used.
+    const std::vector<const Interface*>& getMixinList() const
+    {
+        assert(linearized);
+        return mixinList;
+    }
+
+    // This interface followed by its supplemental interfaces, recursively.
+    const std::vector<const Interface*>& getExpandedSupplementals() const
+    {
+        assert(linearized);
+        return expandedSupplementals;
+    }
+
+    // The definitions of getExpandedSupplementals() in order, so that the
+    // generators can visit the members of this interface and of its
+    // supplemental interfaces in a single loop.
+    const MergedMembers& getMergedMembers() const
+    {
+        assert(linearized);
+        return mergedMembers;
+    }
+
+    // Every named member visible in this interface by name, including the
+    // inherited members and the members of the supplemental interfaces. The
+    // members are numbered in the order MessengerMeta lists them, starting
+    // from the root interface.
+    const MemberTable& getMemberTable() const
+    {
+        assert(linearized);
+        return memberTable;
+    }
+
+    unsigned getMemberCount() const
+    {
+        assert(linearized);
+        return memberCount;
+    }
+
+    // Returns the member that a member of this interface with the specified
+    // name would override, or 0 if there is none.
+    const MemberEntry* findInheritedMember(const std::string& name) const;
 
     size_t getSuperCount() const
     {
@@ -1164,11 +1630,11 @@ public:
             {
                 ScopedName* scoped = static_cast<ScopedName*>(*i);
                 Node* base = scoped->search(this);
-                super = dynamic_cast<Interface*>(base);
+                super = dyn_cast<Interface>(base);
                 if (!super)
                 {
                     fprintf(stderr, "%s not found\n", scoped->getName().c_str());
-                    exit(EXIT_FAILURE);
+                    throw CompilationError();
                 }
                 break;  // XXX Needs to support multiple inheritance is not allowed.
             }
@@ -1178,7 +1644,7 @@ public:
 
     virtual bool isConstructor() const
     {
-        return dynamic_cast<const Interface*>(getParent());
+        return dyn_cast<Interface>(getParent());
     }
 
     Interface* getConstructor() const
@@ -1222,22 +1688,24 @@ public:
         }
     }
 
-    void collectSupplementals(std::list<const Interface*>* interfaceList) const
-    {
-        for (std::list<const Interface*>::const_reverse_iterator i = getSupplementals()->rbegin();
-             i != getSupplementals()->rend();
-             ++i)
-        {
-            assert(!(*i)->isLeaf());
-            assert((*i) != this);
-            (*i)->collectSupplementals(interfaceList);
-        }
-        interfaceList->push_front(this);
-    }
+    void adjustMethodCount();
 
-    void collectMixins(std::list<const Interface*>* interfaceList) const;
+    // Adds the interfaces this interface extends to its super list.
+    void resolveSuperList();
 
-    void adjustMethodCount();
+    // Collects the interfaces this supplemental interface is merged into.
+    void getSupplementalTargets(std::vector<Interface*>* targets) const;
+
+    // Numbers this supplemental interface again with the next supplemental
+    // count. Returns true if its name has changed; see Compiler::update().
+    bool renumber();
+
+    // Forgets the lists and the caches computed from the other interfaces
+    // by AdjustMethodCount and Linearize, so that they can be computed again
+    // after the specification has been updated; see Compiler::update().
+    void unlink();
+
+    friend class Linearize;
 };
 
 class Dictionary : public Interface
@@ -1246,6 +1714,12 @@ public:
     Dictionary(std::string identifier, Node* extends = 0) :
         Interface(identifier, extends)
     {
+        kind = DictionaryKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == DictionaryKind;
     }
 
     virtual void accept(Visitor* visitor);
@@ -1257,6 +1731,12 @@ public:
     Type(std::string identifier) :
         Node(identifier)
     {
+        kind = TypeKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return TypeKind <= node->getKind() && node->getKind() <= EnumKind;
     }
 
     virtual void accept(Visitor* visitor);
@@ -1268,6 +1748,12 @@ public:
     NativeType(std::string identifier) :
         Type(identifier)
     {
+        kind = NativeTypeKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == NativeTypeKind;
     }
 
     virtual NativeType* isNative(const Node* scope) const
@@ -1284,6 +1770,12 @@ public:
     Enum(std::string identifier) :
         Type(identifier)
     {
+        kind = EnumKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == EnumKind;
     }
 
     virtual Enum* isEnum(const Node* scope) const
@@ -1305,6 +1797,12 @@ public:
         spec(spec),
         max(max)
     {
+        kind = SequenceTypeKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == SequenceTypeKind;
     }
 
     ~SequenceType()
@@ -1350,6 +1848,12 @@ public:
         Node("variadic"),  // Default name
         spec(spec)
     {
+        kind = VariadicTypeKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == VariadicTypeKind;
     }
 
     ~VariadicType()
@@ -1380,6 +1884,12 @@ public:
         spec(0),
         max(max)
     {
+        kind = ArrayTypeKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ArrayTypeKind;
     }
 
     ~ArrayType()
@@ -1398,7 +1908,7 @@ public:
 
     void setSpec(Node* spec)
     {
-        if (ArrayType* array = dynamic_cast<ArrayType*>(this->spec))
+        if (ArrayType* array = dyn_cast<ArrayType>(this->spec))
         {
             array->setSpec(spec);
         }
@@ -1434,10 +1944,16 @@ public:
     BinaryExpr(const char* op, Node* left, Node* right) :
         Node(op)
     {
+        kind = BinaryExprKind;
         add(left);
         add(right);
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == BinaryExprKind;
+    }
+
     Node* getLeft() const
     {
         return children->front();
@@ -1457,9 +1973,15 @@ public:
     UnaryExpr(const char* op, Node* exp) :
         Node(op)
     {
+        kind = UnaryExprKind;
         add(exp);
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == UnaryExprKind;
+    }
+
     virtual void accept(Visitor* visitor);
 };
 
@@ -1468,9 +1990,15 @@ class GroupingExpression : public Node
 public:
     GroupingExpression(Node* exp)
     {
+        kind = GroupingExpressionKind;
         add(exp);
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == GroupingExpressionKind;
+    }
+
     virtual void accept(Visitor* visitor);
 };
 
@@ -1480,6 +2008,12 @@ public:
     Literal(const char* literal) :
         Node(literal)
     {
+        kind = LiteralKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == LiteralKind;
     }
 
     operator bool() const;
@@ -1510,6 +2044,7 @@ public:
         spec(spec),
         type(false)
     {
+        kind = MemberKind;
         javadoc = ::getJavadoc();
         setAttr(attr);
     }
@@ -1519,9 +2054,15 @@ public:
         spec(m.spec),
         type(m.type)
     {
+        kind = m.kind;
         setAttr(m.attr);
     }
 
+    static bool classof(const Node* node)
+    {
+        return MemberKind <= node->getKind() && node->getKind() <= ParamDclKind;
+    }
+
     ~Member()
     {
         delete spec;
@@ -1647,8 +2188,8 @@ class Attribute : public Member
     Node* setraises;
     std::string putForwards;
 
-    mutable std::string metaGetter;
-    mutable std::string metaSetter;
+    mutable MetaString metaGetter;
+    mutable MetaString metaSetter;
 
     Node* defualtValue;   // for dictionary
 
@@ -1660,18 +2201,34 @@ public:
         setraises(0),
         defualtValue(0)
     {
+        kind = AttributeKind;
     }
 
-    std::string& getMetaGetter() const
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == AttributeKind;
+    }
+
+    const MetaString& getMetaGetter() const
     {
         return metaGetter;
     }
 
-    std::string& getMetaSetter() const
+    void setMetaGetter(const MetaString& meta) const
+    {
+        metaGetter = meta;
+    }
+
+    const MetaString& getMetaSetter() const
     {
         return metaSetter;
     }
 
+    void setMetaSetter(const MetaString& meta) const
+    {
+        metaSetter = meta;
+    }
+
     bool isReadonly() const
     {
         return readonly;
@@ -1760,6 +2317,12 @@ public:
         Member(identifier, spec),
         exp(exp)
     {
+        kind = ConstDclKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ConstDclKind;
     }
 
     ~ConstDcl()
@@ -1786,11 +2349,11 @@ public:
     Type* getType() const
     {
         Node* type = getSpec();
-        if (ScopedName* scopedName = dynamic_cast<ScopedName*>(type))
+        if (ScopedName* scopedName = dyn_cast<ScopedName>(type))
         {
             type = scopedName->search(getParent());
         }
-        assert(dynamic_cast<Type*>(type));
+        assert(dyn_cast<Type>(type));
         return static_cast<Type*>(type);
     }
 
@@ -1804,7 +2367,7 @@ class OpDcl : public Member
     size_t methodCount;
     std::vector<size_t> paramCounts;  // for each method
 
-    mutable std::vector<std::string> metaOps;
+    mutable std::vector<MetaString> metaOps;
 
 public:
     OpDcl(std::string identifier, Node* spec, uint32_t attr = 0) :
@@ -1813,6 +2376,7 @@ public:
         paramCount(0),
         methodCount(1)
     {
+        kind = OpDclKind;
         children = new NodeList;
         if (identifier == "")
         {
@@ -1820,10 +2384,15 @@ public:
         }
     }
 
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == OpDclKind;
+    }
+
     virtual void add(Node* node);
     void processExtendedAttributes();
 
-    std::string& getMetaOp(size_t i) const
+    const MetaString& getMetaOp(size_t i) const
     {
         assert(i < methodCount);
         if (metaOps.size() < methodCount)
@@ -1833,6 +2402,16 @@ public:
         return metaOps.at(i);
     }
 
+    void setMetaOp(size_t i, const MetaString& meta) const
+    {
+        assert(i < methodCount);
+        if (metaOps.size() < methodCount)
+        {
+            metaOps.resize(methodCount);
+        }
+        metaOps[i] = meta;
+    }
+
     Node* getRaises() const
     {
         return raises;
@@ -1856,6 +2435,10 @@ public:
     // Need to be called after the source file is completely read.
     void adjustMethodCount();
 
+    // Marks the operation this operation overrides with a covariant return
+    // type, and its interface, with HasCovariant.
+    void checkCovariance();
+
     size_t getParamCount() const
     {
         return paramCount;
@@ -1876,16 +2459,16 @@ public:
     {
         Interface* interface = static_cast<Interface*>(getParent());
         assert(interface);
-        if (!resolveInBase(interface, getName()))
+        if (!interface->findInheritedMember(getName()))
         {
             return 0;
         }
         // This node possibly overrides a base class operation.
-        if (ScopedName* name = dynamic_cast<ScopedName*>(getSpec()))
+        if (ScopedName* name = dyn_cast<ScopedName>(getSpec()))
         {
             Node* spec = name->search(interface);
             check(spec, "could not resolved %s.", name->getName().c_str());
-            if (dynamic_cast<Interface*>(spec) && !spec->isBaseObject())
+            if (dyn_cast<Interface>(spec) && !spec->isBaseObject())
             {
                 return spec;
             }
@@ -1904,6 +2487,12 @@ public:
     ParamDcl(std::string identifier, Node* spec, uint32_t attr) :
         Member(identifier, spec, attr)
     {
+        kind = ParamDclKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ParamDclKind;
     }
 
     bool isOptional() const
@@ -1916,6 +2505,11 @@ public:
         return getAttr() & Variadic;
     }
 
+    // Returns the element type if this parameter is passed as a span, i.e.,
+    // a pointer to the elements and the number of them: a sequence of a
+    // primitive type with -span. Returns 0 otherwise.
+    Node* getSpanType() const;
+
     void processExtendedAttributes();
 
     virtual void accept(Visitor* visitor);
@@ -1930,6 +2524,12 @@ public:
         Node(name),
         details(details)
     {
+        kind = ExtendedAttributeKind;
+    }
+
+    static bool classof(const Node* node)
+    {
+        return node->getKind() == ExtendedAttributeKind;
     }
 
     Node* getDetails() const
@@ -2259,11 +2859,11 @@ public:
             for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
             {
                 (*i)->accept(this);
-                if (OpDcl* op = dynamic_cast<OpDcl*>(*i))
+                if (OpDcl* op = dyn_cast<OpDcl>(*i))
                 {
                     const_cast<Interface*>(node)->processExtendedAttributes(op);
                 }
-                else if (Attribute* attr = dynamic_cast<Attribute*>(*i))
+                else if (Attribute* attr = dyn_cast<Attribute>(*i))
                 {
                     const_cast<Interface*>(node)->processExtendedAttributes(attr);
                 }
@@ -2321,8 +2921,35 @@ public:
     }
 };
 
+// Linearizes the inheritance, the mixin and the supplemental lists, and
+// flattens the member table of every interface not linearized yet, i.e.,
+// of every interface, or of those unlinked by Compiler::update(). Apply
+// this visitor right after AdjustMethodCount.
+class Linearize : public Visitor
+{
+public:
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        const_cast<Interface*>(node)->linearize();
+        visitChildren(node);
+    }
+
+    virtual void at(const OpDcl* node)
+    {
+        const_cast<OpDcl*>(node)->checkCovariance();
+    }
+};
+
+class StringPool;
+
 int printMessenger(const char* stringTypeName, const char* objectTypeName,
-                   bool useExceptions, bool useVirtualBase, const char* indent);
+                   bool useExceptions, bool useVirtualBase, const char* indent, const StringPool* stringPool = 0);
+void buildMessengerStringPool(StringPool* stringPool);
 int printMessengerSrc(const char* stringTypeName, const char* objectTypeName,
                       bool useExceptions, bool useVirtualBase, const char* indent);
 int printMessengerImp(const char* stringTypeName, const char* objectTypeName,
@@ -2338,15 +2965,52 @@ int printCPlusPlusSrc(const char* stringTypeName, const char* objectTypeName,
                       bool useExceptions, bool useVirtualBase, const char* indent);
 
 void print();
-void printCxx(const char* source, const char* stringTypeName, const char* objectTypeName,
-              bool useExceptions, bool useVirtualBase, const char* indent);
+void printCxx(const char* source, const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName,
+              bool useExceptions, bool useVirtualBase, const char* indent, const StringPool* stringPool = 0);
+void buildStringPool(StringPool* stringPool, const std::vector<std::string>& sources);
+int printCxxModules(const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName,
+                    bool useVirtualBase, const char* indent, const char* prelude);
+void printStringPool(const StringPool* stringPool);
 void printSkeleton(const char* source, bool isystem, const char* indent);
-void printTemplate(const char* source, const char* stringTypeName, const char* objectTypeName,
+void printTemplate(const char* source, const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName,
                    bool useExceptions, bool isystem, const char* indent);
 
 std::string getOutputFilename(std::string, const char* suffix);
+FILE* openOutput(const std::string& filename, const Node* node = 0);
+FILE* openOutput(const std::string& filename, const char* source);
+bool isSelected(const Node* node);
+void closeOutput(FILE* file);
+bool removeOutput(const std::string& filename);
+void logOutput(const char* format, ...);
 std::string getIncludedName(const std::string& header);
 
+// Attributes the bytes written to file while in scope to the generator of
+// the interface, if the current context collects the sizes. The bytes
+// written by a nested SizeProbe count for its own generator only.
+class SizeProbe
+{
+    FILE* file;
+    Context::GeneratorSize* size;
+    long start;
+    long nested;
+    SizeProbe* outer;
+
+    SizeProbe(const SizeProbe&);
+    SizeProbe& operator=(const SizeProbe&);
+
+public:
+    SizeProbe(FILE* file, const Interface* interface, const char* generator);
+    ~SizeProbe();
+
+    void addCases(unsigned long count)
+    {
+        if (size)
+        {
+            size->cases += count;
+        }
+    }
+};
+
 std::string getScopedName(std::string moduleName, std::string absoluteName);
 
 const char* getIncludePath();
@@ -2356,9 +3020,10 @@ int input(int fd, bool isystem, bool useExceptions, const char* stringTypeName);
 
 int output(const char* filename,
            bool isystem, bool useExceptions, bool useMultipleInheritance,
-           const char* stringTypeName, const char* objectTypeName, const char* indent,
+           const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName, const char* indent,
            bool skeleton,
-           bool generic);
+           bool generic,
+           const StringPool* stringPool = 0);
 
 void help();
 void version();
@@ -40,7 +40,7 @@ inline Literal::operator bool() const
 
     // syntax error
     report("Syntax error: %s.", name.c_str());
-    exit(EXIT_FAILURE);
+    throw CompilationError();
 }
 
 inline Literal::operator char() const
@@ -172,7 +172,7 @@ public:
 
     virtual void at(const ScopedName* node)
     {
-        if (ConstDcl* c = dynamic_cast<ConstDcl*>(node->search(scope)))
+        if (ConstDcl* c = dyn_cast<ConstDcl>(node->search(scope)))
         {
             c->getExp()->accept(this);
         }
@@ -265,7 +265,7 @@ public:
 
     virtual void at(const ScopedName* node)
     {
-        if (ConstDcl* c = dynamic_cast<ConstDcl*>(node->search(scope)))
+        if (ConstDcl* c = dyn_cast<ConstDcl>(node->search(scope)))
         {
             c->getExp()->accept(this);
         }
@@ -329,7 +329,7 @@ public:
 
     virtual void at(const ScopedName* node)
     {
-        if (ConstDcl* c = dynamic_cast<ConstDcl*>(node->search(scope)))
+        if (ConstDcl* c = dyn_cast<ConstDcl>(node->search(scope)))
         {
             c->getExp()->accept(this);
         }
@@ -131,6 +131,11 @@ public:
     {
     }
 
+    FILE* getFile() const
+    {
+        return file;
+    }
+
     void indent()
     {
         indentString += std::string(indentLevel, ' ');
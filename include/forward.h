@@ -67,7 +67,7 @@ class Forward : public Visitor
     void addNotDeclared(const Node* node)
     {
         Node* resolved = resolve(currentNode, node->getName());
-        Member* m = dynamic_cast<Member*>(resolved);
+        Member* m = dyn_cast<Member>(resolved);
         if (m && m->isTypedef(m->getParent()))
         {
             m->getSpec()->accept(this);
@@ -136,9 +136,9 @@ public:
         Node* spec = node->getSpec();
         if (node->isPutForwards())
         {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(node->getParent()));
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(node->getParent()));
             assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
             assert(forwards);
             spec = forwards->getSpec();
         }
@@ -193,16 +193,10 @@ public:
 
         currentNode = node;
 
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
-            {
-                visitInterfaceElement(*i, *j);
-            }
+            visitInterfaceElement(i->interface, i->node);
         }
 
         if (Interface* constructor = node->getConstructor())
@@ -285,7 +279,7 @@ public:
         else
         {
             fprintf(stderr, "Inv. const type.\n");
-            exit(EXIT_FAILURE);
+            throw CompilationError();
         }
     }
 
@@ -310,15 +304,18 @@ public:
              ++i)
         {
             Node* node = *i;
-            Member* m = dynamic_cast<Member*>(node);
+            Member* m = dyn_cast<Member>(node);
             if (m && m->isTypedef(node->getParent()))
             {
                 Member* t = new Member(*m);
                 node->getParent()->addFront(t);
+                getContext()->forwardDeclarations.push_back(t);
             }
             else if (!(node->getAttr() & Interface::Supplemental))
             {
-                node->getParent()->addFront(new Interface(node->getName().c_str(), 0, true));
+                Interface* forward = new Interface(node->getName().c_str(), 0, true);
+                node->getParent()->addFront(forward);
+                getContext()->forwardDeclarations.push_back(forward);
             }
         }
         setBaseFilename("");
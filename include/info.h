@@ -20,17 +20,116 @@
 #define ESIDL_INFO_H_INCLUDED
 
 #include <string>
+#include <vector>
 #include "esidl.h"
 #include "expr.h"
 #include "formatter.h"
 #include "reflect.h"
+#include "stringPool.h"
 
-// Generate the string-encoded interface information for reflection
-class Info : public Visitor, public Formatter
+// Collect the string-encoded records of an interface for reflection
+class InfoRecords : public Visitor
 {
-    const Node* currentNode;
+public:
+    // A record refers to the meta data of a node in place. The operations of
+    // a constructor are encoded as Reflect::kConstructor instead of
+    // Reflect::kOperation.
+    struct Record
+    {
+        MetaString meta;
+        bool constructor;
+
+        Record(const MetaString& meta, bool constructor = false) :
+            meta(meta),
+            constructor(constructor)
+        {
+        }
+
+        char getKind() const
+        {
+            return constructor ? Reflect::kConstructor : meta[0];
+        }
+
+        // The encoding following the kind
+        int getTailLength() const
+        {
+            return static_cast<int>(meta.length() - 1);
+        }
+
+        const char* getTail() const
+        {
+            return meta.begin() + 1;
+        }
+
+        std::string str() const
+        {
+            return getKind() + std::string(getTail(), getTailLength());
+        }
+
+        // Gets the record in the form kept in a StringPool.
+        StringPool::Record getPoolRecord() const
+        {
+            StringPool::Record record;
+            record.text = str();
+            const char* text = record.text.c_str();
+            const char* p = text;
+            switch (*p)
+            {
+            case Reflect::kInterface:
+            case Reflect::kExtends:
+            case Reflect::kImplements:
+                record.names.push_back(p + 1 - text);
+                break;
+            case Reflect::kConstant:
+                p = findTypeName(&record, p + 1);
+                record.names.push_back(p - text);
+                break;
+            case Reflect::kOperation:
+            case Reflect::kGetter:
+            case Reflect::kSetter:
+            case Reflect::kConstructor:
+                {
+                    unsigned count;
+                    p = Reflect::skipDigits(Reflect::Method::skipSpecial(p + 1), &count);
+                    for (unsigned i = 0; i <= count; ++i)  // the return value and the parameters
+                    {
+                        p = findTypeName(&record, p);
+                        record.names.push_back(p - text);
+                        p = Reflect::skipName(p);
+                    }
+                    while (*p == Reflect::kRaises)
+                    {
+                        record.names.push_back(p + 1 - text);
+                        p = Reflect::skipName(p + 1);
+                    }
+                }
+                break;
+            }
+            return record;
+        }
+
+    private:
+        // Adds the position of the interface name in the type at type to
+        // record, and returns the end of the type.
+        static const char* findTypeName(StringPool::Record* record, const char* type)
+        {
+            const char* p = type;
+            while (*p == Reflect::kSequence || *p == Reflect::kArray)
+            {
+                p = Reflect::skipDigits((*p == Reflect::kSequence) ? Reflect::skipSpan(p + 1) : p + 1);
+            }
+            if (*p == Reflect::kObject)
+            {
+                record->names.push_back(p + 1 - record->text.c_str());
+            }
+            return Reflect::skipType(type);
+        }
+    };
+
+private:
     bool constructorMode;
-    unsigned offset;
+    std::vector<Record> records;
+    size_t headerCount;
 
     void visitInterfaceElement(const Interface* interface, Node* element)
     {
@@ -41,38 +140,38 @@ class Info : public Visitor, public Formatter
         {
             return;
         }
-        writeln("");
-        writetab();
-        write("/* %u */ ", offset);
         element->accept(this);
     }
 
 public:
-    Info(Formatter* f) :
-        Formatter(f),
-        currentNode(0),
+    InfoRecords() :
         constructorMode(false),
-        offset(0)
+        headerCount(0)
     {
-        flush();
+    }
+
+    const std::vector<Record>& getRecords() const
+    {
+        return records;
+    }
+
+    // The number of the records for the I, X and M names at the beginning
+    size_t getHeaderCount() const
+    {
+        return headerCount;
     }
 
     virtual void at(const Module* node)
     {
-        // Info{} visiter should be applied for interfaces.
+        // InfoRecords{} visiter should be applied for interfaces.
     }
 
     virtual void at(const Attribute* node)
     {
-        write("\"%s\"", node->getMetaGetter().c_str());
-        offset += node->getMetaGetter().length();
+        records.push_back(node->getMetaGetter());
         if (!node->isReadonly() || node->isPutForwards() || node->isReplaceable())
         {
-            writeln("");
-            writetab();
-            write("/* %u */ ", offset);
-            write("\"%s\"", node->getMetaSetter().c_str());
-            offset += node->getMetaSetter().length();
+            records.push_back(node->getMetaSetter());
         }
     }
 
@@ -80,21 +179,7 @@ public:
     {
         for (size_t i = 0; i < node->getMethodCount(); ++i)
         {
-            if (i != 0)
-            {
-                writeln("");
-                writetab();
-                write("/* %u */ ", offset);
-            }
-            if (constructorMode)
-            {
-                write("\"%c%s\"", Reflect::kConstructor, node->getMetaOp(i).c_str() + 1);
-            }
-            else
-            {
-                write("\"%c%s\"", Reflect::kOperation, node->getMetaOp(i).c_str() + 1);
-            }
-            offset += node->getMetaOp(i).length();
+            records.push_back(Record(node->getMetaOp(i), constructorMode));
         }
     }
 
@@ -105,30 +190,23 @@ public:
             return;
         }
 
-        currentNode = node;
-        offset = 0;
+        records.clear();
 
-        writeln("");
-        writetab();
-        write("/* %u */ ", offset);
-        write("\"%s\"", node->getMeta().c_str());
-
-        offset += node->getMeta().length();
+        // Split the meta data of the interface into the I, X and M names.
+        const MetaString& meta = node->getMeta();
+        for (const char* p = meta.begin(); p < meta.end(); )
+        {
+            const char* next = Reflect::skipName(p + 1);
+            records.push_back(MetaString(p, next - p));
+            p = next;
+        }
+        headerCount = records.size();
 
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
-        {
-            const Node* saved = currentNode;
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
-            {
-                currentNode = *i;
-                visitInterfaceElement(*i, *j);
-            }
-            currentNode = saved;
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
+        {
+            visitInterfaceElement(i->interface, i->node);
         }
 
         if (Interface* constructor = node->getConstructor())
@@ -143,14 +221,11 @@ public:
             }
             constructorMode = false;
         }
-
-        flush();
     }
 
     virtual void at(const ConstDcl* node)
     {
-        write("\"%s\"", node->getMeta().c_str());
-        offset += node->getMeta().length();
+        records.push_back(node->getMeta());
     }
 
     virtual void at(const Member* node)
@@ -160,4 +235,100 @@ public:
     }
 };
 
+// Add the reflection data of the interfaces defined in source to a pool
+class StringPoolBuilder : public Visitor
+{
+    StringPool* pool;
+    const char* source;
+
+    void addRecords(const Interface* node)
+    {
+        InfoRecords info;
+        info.at(node);
+        const std::vector<InfoRecords::Record>& records = info.getRecords();
+        StringPool::Records pooled;
+        for (std::vector<InfoRecords::Record>::const_iterator i = records.begin(); i != records.end(); ++i)
+        {
+            pooled.push_back(i->getPoolRecord());
+        }
+        pool->add(node, pooled);
+    }
+
+public:
+    StringPoolBuilder(StringPool* pool, const char* source) :
+        pool(pool),
+        source(source)
+    {
+    }
+
+    virtual void at(const Module* node)
+    {
+        // Follow Cxx::printChildren(), which skips the modules defined in
+        // the other files.
+        if (node != getSpecification() && !node->isDefinedIn(source))
+        {
+            return;
+        }
+        visitChildren(node);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        if (!node->isDefinedIn(source) || (node->getAttr() & Interface::Supplemental) || node->isLeaf())
+        {
+            return;
+        }
+        addRecords(node);
+        if (Interface* constructor = node->getConstructor())
+        {
+            addRecords(constructor);
+        }
+    }
+};
+
+// Generate the string-encoded interface information for reflection
+class Info : public Visitor, public Formatter
+{
+public:
+    Info(Formatter* f) :
+        Formatter(f)
+    {
+        flush();
+    }
+
+    virtual void at(const Module* node)
+    {
+        // Info{} visiter should be applied for interfaces.
+    }
+
+    virtual void at(const Interface* node)
+    {
+        if (node->isLeaf())
+        {
+            return;
+        }
+
+        InfoRecords info;
+        info.at(node);
+        const std::vector<InfoRecords::Record>& records = info.getRecords();
+        unsigned offset = 0;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (i == 0 || info.getHeaderCount() <= i)
+            {
+                writeln("");
+                writetab();
+                write("/* %u */ \"", offset);
+            }
+            write("%c%.*s", records[i].getKind(), records[i].getTailLength(), records[i].getTail());
+            offset += records[i].meta.length();
+            if (i + 1 == records.size() || info.getHeaderCount() <= i + 1)
+            {
+                write("\"");
+            }
+        }
+        flush();
+    }
+};
+
 #endif  // ESIDL_INFO_H_INCLUDED
@@ -114,7 +114,7 @@ public:
         {
             currentNode = resolved->getParent();
         }
-        if (!dynamic_cast<Interface*>(resolved) && !dynamic_cast<ExceptDcl*>(resolved))
+        if (!dyn_cast<Interface>(resolved) && !dyn_cast<ExceptDcl>(resolved))
         {
             resolved->accept(this);
         }
@@ -215,11 +215,11 @@ public:
     virtual void at(const ArrayType* node)
     {
         Node* spec = node->getSpec();
-        if (ScopedName* name = dynamic_cast<ScopedName*>(spec))
+        if (ScopedName* name = dyn_cast<ScopedName>(spec))
         {
             spec = name->search(currentNode);
         }
-        Type* type = dynamic_cast<Type*>(spec);
+        Type* type = dyn_cast<Type>(spec);
         if (type && !(type->getAttr() & Node::Nullable))
         {
             if (type->getName() == "boolean")
@@ -333,9 +333,9 @@ public:
         }
         else if (node->isPutForwards())
         {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(node->getParent()));
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(node->getParent()));
             assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
             assert(forwards);
             spec = forwards->getSpec();
         }
@@ -382,7 +382,7 @@ public:
         variadicParam = 0;
         for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
         {
-            ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+            ParamDcl* param = dyn_cast<ParamDcl>(*i);
             assert(param);
             if (param->isOptional())
             {
@@ -25,14 +25,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <vector>
 #include "esidl.h"
 #include "formatter.h"
 
 class Messenger : public Visitor, public Formatter
 {
-public:
-    static bool useVirtualBase;
-
 protected:
     std::string stringTypeName;
     std::string objectTypeName;
@@ -108,7 +106,7 @@ protected:
 
     void visitInterfaceElement(const Interface* interface, Node* element)
     {
-        if (dynamic_cast<Interface*>(element))
+        if (dyn_cast<Interface>(element))
         {
             // Do not process Constructor.
             return;
@@ -123,6 +121,19 @@ protected:
         } while (optionalStage <= optionalCount);
     }
 
+    // Returns true if a value of the type is passed by value and owns its
+    // contents, so that it is moved into an Any with -fmove. Strings are
+    // passed by const reference, or as char*.
+    static bool isMovable(const Node* spec, const Node* scope)
+    {
+        if (!getContext()->useMove || spec->isString(scope) || spec->isEnum(scope))
+        {
+            return false;
+        }
+        return spec->isInterface(scope) || spec->isSequence(scope) || spec->isArray(scope) ||
+               spec->isAny(scope) || spec->isUnion(scope) || (spec->getAttr() & Node::Nullable);
+    }
+
 public:
     Messenger(FILE* file, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
         Formatter(file, indent),
@@ -173,8 +184,8 @@ public:
         {
             currentNode = resolved->getParent();
         }
-        if (!dynamic_cast<Interface*>(resolved) &&
-            !dynamic_cast<ExceptDcl*>(resolved) &&
+        if (!dyn_cast<Interface>(resolved) &&
+            !dyn_cast<ExceptDcl>(resolved) &&
             !resolved->isTypedef(resolved->getParent()) &&
             !resolved->isEnum(resolved->getParent()))
         {
@@ -320,16 +331,10 @@ public:
         }
     }
 
-    bool setter(const Attribute* node, const std::string& className = "")
+    // Returns the type of the value given to the setter of the attribute.
+    static Node* getSetterSpec(const Attribute* node)
     {
-        if (node->isReadonly() && !node->isPutForwards() && !node->isReplaceable())
-        {
-            return false;
-        }
-
         static Type replaceable("any");
-        std::string cap = node->getName().c_str();
-        cap[0] = toupper(cap[0]);
         Node* spec = node->getSpec();
         if (node->isReplaceable())
         {
@@ -337,12 +342,25 @@ public:
         }
         else if (node->isPutForwards())
         {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(node->getParent()));
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(node->getParent()));
             assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
             assert(forwards);
             spec = forwards->getSpec();
         }
+        return spec;
+    }
+
+    bool setter(const Attribute* node, const std::string& className = "")
+    {
+        if (node->isReadonly() && !node->isPutForwards() && !node->isReplaceable())
+        {
+            return false;
+        }
+
+        std::string cap = node->getName().c_str();
+        cap[0] = toupper(cap[0]);
+        Node* spec = getSetterSpec(node);
         bool useConstString = (spec->isString(node->getParent()) || spec->isEnum(node->getParent())) && hasCustomStringType();
         std::string name = getBufferName(node);
 
@@ -379,7 +397,7 @@ public:
         int count = 0;
         for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
         {
-            ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+            ParamDcl* param = dyn_cast<ParamDcl>(*i);
             assert(param);
             if (param->isOptional())
             {
@@ -389,7 +407,7 @@ public:
                     break;
                 }
             }
-            ++count;
+            count += param->getSpanType() ? 2 : 1;
             if (param->isVariadic())
             {
                 variadicParam = param;
@@ -405,7 +423,7 @@ public:
         variadicParam = 0;
         for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
         {
-            ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+            ParamDcl* param = dyn_cast<ParamDcl>(*i);
             assert(param);
             if (param->isOptional())
             {
@@ -475,7 +493,16 @@ public:
 
     virtual void at(const ParamDcl* node)
     {
-        static VariadicType variadic(0);
+        VariadicType variadic(0);
+
+        if (Node* element = node->getSpanType())
+        {
+            std::string name = getEscapedName(node->getName());
+            write("const ");
+            element->accept(this);
+            write("* %s, unsigned int %sLength", name.c_str(), name.c_str());
+            return;
+        }
 
         Node* spec = node->getSpec();
         bool useConstString = (spec->isString(node->getParent()) || spec->isEnum(node->getParent())) && hasCustomStringType() && !node->isVariadic();
@@ -21,12 +21,127 @@
 
 #include "messenger.h"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <vector>
 
 class MessengerDispatch : public Messenger
 {
     bool overloaded;
     bool asSpecial;
+    unsigned caseCount;  // of the selectors
+
+    void writeSelectorCase(uint32_t selector)
+    {
+        writeln("case 0x%x:", selector);
+        ++caseCount;
+    }
+
+    // With -fdispatch-table, the dispatcher is not a template, and calls the
+    // members of the implementation class through a table of pointers to
+    // them, which is all that is instantiated for each implementation class.
+    enum
+    {
+        OperationMember,
+        GetterMember,
+        SetterMember
+    };
+    struct MemberEntry
+    {
+        int kind;
+        const Node* node;
+        const Node* scope;  // the currentNode to write the type in
+        int stage;          // the optionalStage to write the type with
+    };
+    std::vector<MemberEntry> members;
+
+    // Returns the expression to call the member of the implementation class
+    // named name with.
+    std::string getCallee(int kind, const Node* node, const std::string& name)
+    {
+        if (!getContext()->useDispatchTable)
+        {
+            return "self->" + name;
+        }
+        MemberEntry entry = { kind, node, currentNode, optionalStage };
+        char callee[40];
+        sprintf(callee, "(self->*members->member%u)", static_cast<unsigned>(members.size()));
+        members.push_back(entry);
+        return callee;
+    }
+
+    static std::string getMemberName(const MemberEntry& entry)
+    {
+        if (entry.kind == OperationMember)
+        {
+            const std::string& name = entry.node->getName();
+            return name.empty() ? "operator()" : getEscapedName(name);
+        }
+        std::string cap = entry.node->getName();
+        cap[0] = toupper(cap[0]);
+        return ((entry.kind == GetterMember) ? "get" : "set") + cap;
+    }
+
+    // Writes the type of the member as the function type MemberN, in the way
+    // the member is declared in the implementation class except for the
+    // exception specification.
+    void writeMemberType(const MemberEntry& entry, unsigned n)
+    {
+        static Type replaceable("any");
+        const Node* scope = entry.node->getParent();
+        currentNode = entry.scope;
+        optionalStage = entry.stage;
+        writetab();
+        write("typedef ");
+        if (entry.kind == SetterMember)
+        {
+            Node* spec = getSetterSpec(static_cast<const Attribute*>(entry.node));
+            write("void Member%u(", n);
+            if ((spec->isString(scope) || spec->isEnum(scope)) && hasCustomStringType())
+            {
+                write("const ");
+                spec->accept(this);
+                write("&");
+            }
+            else
+            {
+                spec->accept(this);
+            }
+            write(" %s)", getBufferName(entry.node).c_str());
+        }
+        else if (entry.kind == GetterMember)
+        {
+            const Attribute* attribute = static_cast<const Attribute*>(entry.node);
+            Node* spec = attribute->isReplaceable() ? &replaceable : attribute->getSpec();
+            spec->accept(this);
+            write(" Member%u()", n);
+        }
+        else
+        {
+            const OpDcl* op = static_cast<const OpDcl*>(entry.node);
+            op->getSpec()->accept(this);
+            write(" Member%u(", n);
+            int optional = 0;
+            noDefaultArgument = true;
+            for (NodeList::iterator i = op->begin(); i != op->end(); ++i)
+            {
+                const ParamDcl* param = static_cast<const ParamDcl*>(*i);
+                if (param->isOptional() && optionalStage < ++optional)
+                {
+                    break;
+                }
+                if (i != op->begin())
+                {
+                    write(", ");
+                }
+                Messenger::at(param);
+            }
+            noDefaultArgument = false;
+            write(")");
+        }
+        write(";\n");
+    }
 
     void writeSelectorZero(Node* stringifier)
     {
@@ -42,28 +157,344 @@ class MessengerDispatch : public Messenger
         }
         writeln("if (argumentCount == STRINGIFY_)");
         indent();
-            if (dynamic_cast<class OpDcl*>(stringifier))
+            if (dyn_cast<OpDcl>(stringifier))
             {
-                writeln("return self->%s();", getEscapedName(stringifier->getName()).c_str());
+                writeln("return %s();", getCallee(OperationMember, stringifier, getEscapedName(stringifier->getName())).c_str());
             }
             else
             {
                 std::string cap = stringifier->getName();
                 cap[0] = toupper(cap[0]);
-                writeln("return self->get%s();", cap.c_str());
+                writeln("return %s();", getCallee(GetterMember, stringifier, "get" + cap).c_str());
             }
         unindent();
     }
 
+    // An entry of the effective overload set of an operation, i.e., one of
+    // the overloaded operations with some of its optional arguments omitted.
+    struct Overload
+    {
+        const OpDcl* op;
+        int stage;          // the optionalStage to call op with
+        int argumentCount;
+    };
+    typedef std::vector<Overload> OverloadSet;
+
+    static int getOptionalCount(const OpDcl* op)
+    {
+        int count = 0;
+        for (NodeList::iterator i = op->begin(); i != op->end(); ++i)
+        {
+            if (static_cast<ParamDcl*>(*i)->isOptional())
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    static bool hasSpan(const OpDcl* op)
+    {
+        for (NodeList::iterator i = op->begin(); i != op->end(); ++i)
+        {
+            if (static_cast<ParamDcl*>(*i)->getSpanType())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Collects the effective overload set of the count operations starting
+    // at i in the order of declaration. Returns false if any of the
+    // operations is variadic or takes a span.
+    bool getEffectiveOverloadSet(std::multimap<uint32_t, OpDcl*>::iterator i, int count, OverloadSet* set)
+    {
+        for (; 0 < count; --count, ++i)
+        {
+            const OpDcl* op = i->second;
+            int optional = getOptionalCount(op);
+            for (optionalStage = 0; optionalStage <= optional; ++optionalStage)
+            {
+                Overload overload;
+                overload.op = op;
+                overload.stage = optionalStage;
+                overload.argumentCount = getParamCount(op);
+                if (getVariadic() || hasSpan(op))
+                {
+                    return false;
+                }
+                set->push_back(overload);
+            }
+        }
+        return true;
+    }
+
+    static const ParamDcl* getParam(const OpDcl* op, int n)
+    {
+        NodeList::iterator i = op->begin();
+        std::advance(i, n);
+        return static_cast<const ParamDcl*>(*i);
+    }
+
+    // Returns a string that is the same for the argument types that
+    // writeTypeTest() cannot tell apart. The empty string is returned for
+    // the types that accept any value.
+    static std::string getTypeKey(const OpDcl* op, int n)
+    {
+        const ParamDcl* param = getParam(op, n);
+        Node* spec = param->getSpec();
+        const Node* scope = op->getParent();
+        if ((param->getAttr() & ParamDcl::AllowAny) || spec->isAny(scope))
+        {
+            return "";
+        }
+        std::string key;
+        if (spec->isInterface(scope))
+        {
+            key = "I";
+            if (!spec->isObject(scope))
+            {
+                ScopedName* name = dyn_cast<ScopedName>(spec);
+                Node* resolved = name ? name->search(scope) : 0;
+                key += resolved ? resolved->getQualifiedName() : spec->getName();
+            }
+        }
+        else if (spec->isString(scope) || spec->isEnum(scope))
+        {
+            key = "S";
+        }
+        else if (spec->isSequence(scope))
+        {
+            key = "Q";
+        }
+        else
+        {
+            key = "P";
+        }
+        if ((spec->getAttr() & Node::Nullable) || (param->getAttr() & ParamDcl::NullIsEmpty))
+        {
+            key += '?';
+        }
+        return key;
+    }
+
+    // Returns the order in which the test of the type keyed by key is
+    // emitted. The tests of the interfaces, which match only their own
+    // instances, come first, then those of the sequences and then of
+    // object, which match any object, as in the WebIDL overload resolution
+    // algorithm. Strings and primitive values cannot be mistaken for
+    // objects, so their tests keep their places.
+    static int getTestOrder(const std::string& key)
+    {
+        if (key[0] == 'Q')
+        {
+            return 1;
+        }
+        if (key == "I" || key == "I?")
+        {
+            return 2;
+        }
+        return 0;
+    }
+
+    static bool isTestedBefore(const std::string& a, const std::string& b)
+    {
+        return getTestOrder(a) < getTestOrder(b);
+    }
+
+    // Writes the test of arguments[index] against the type of the n-th
+    // parameter of op. index differs from n if a preceding parameter is
+    // passed as a span.
+    void writeTypeTest(const OpDcl* op, int n, int index)
+    {
+        const ParamDcl* param = getParam(op, n);
+        Node* spec = param->getSpec();
+        const Node* scope = op->getParent();
+        bool nullable = (spec->getAttr() & Node::Nullable) || (param->getAttr() & ParamDcl::NullIsEmpty);
+        if (nullable)
+        {
+            write("!arguments[%u].hasValue() || ", index);
+        }
+        if (spec->isInterface(scope))
+        {
+            if (spec->isObject(scope))
+            {
+                write("arguments[%u].isObject()", index);
+            }
+            else
+            {
+                write(nullable ? "(arguments[%u].isObject() && " : "arguments[%u].isObject() && ", index);
+                spec->accept(this);
+                write(nullable ? "::hasInstance(arguments[%u].toObject()))" : "::hasInstance(arguments[%u].toObject())", index);
+            }
+        }
+        else if (spec->isString(scope) || spec->isEnum(scope))
+        {
+            write("arguments[%u].isString()", index);
+        }
+        else if (spec->isSequence(scope))
+        {
+            write("arguments[%u].isObject()", index);
+        }
+        else
+        {
+            // Now arguments[n] should be a primitive value
+            write("arguments[%u].isPrimitive()", index);
+        }
+    }
+
+    // Writes arguments[n]. With -fmove, the argument is moved out as the
+    // dispatcher is its last user.
+    void writeArgument(unsigned n)
+    {
+        if (getContext()->useMove)
+        {
+            write("std::move(arguments[%u])", n);
+        }
+        else
+        {
+            write("arguments[%u]", n);
+        }
+    }
+
+    void writeCall(const OpDcl* node)
+    {
+        Interface* interface = dyn_cast<Interface>(node->getParent());
+        writetab();
+        Node* spec = node->getSpec();
+        if (!spec->isVoid(interface))
+        {
+            write("return ");
+        }
+        if (getContext()->useDispatchTable)
+            write("%s(", getCallee(OperationMember, node, "").c_str());
+        else if (!node->getName().empty())
+            write("self->%s(", getEscapedName(node->getName()).c_str());
+        else
+            write("(*self)(");
+        writeParameters(node);
+        write(");\n");
+        if (spec->isVoid(interface))
+        {
+            writeln("return Any();");
+        }
+    }
+
+    void writeCall(const Overload& overload)
+    {
+        const Node* saved = currentNode;
+        currentNode = overload.op->getParent();
+        optionalStage = overload.stage;
+        optionalCount = 0;
+        writeCall(overload.op);
+        currentNode = saved;
+    }
+
+    // Emits the decision tree of the WebIDL overload resolution algorithm
+    // for the entries taking the same number of arguments: the entries are
+    // told apart by the type of the first argument at or after index whose
+    // type differs between them. The types are tested in the order given by
+    // getTestOrder(), and the entries whose argument accepts any value are
+    // tried last. Returns true if the emitted code always returns.
+    bool writeDecisionTree(const OverloadSet& set, int index)
+    {
+        int argumentCount = set.front().argumentCount;
+        for (; index < argumentCount; ++index)
+        {
+            std::string key = getTypeKey(set.front().op, index);
+            OverloadSet::const_iterator i = set.begin();
+            while (i != set.end() && getTypeKey(i->op, index) == key)
+            {
+                ++i;
+            }
+            if (i != set.end())
+            {
+                break;
+            }
+        }
+        if (set.size() == 1 || index == argumentCount)
+        {
+            // The first entry wins if the rest cannot be told apart from it.
+            writeCall(set.front());
+            return true;
+        }
+
+        std::vector<std::string> keys;
+        std::map<std::string, OverloadSet> partitions;
+        for (OverloadSet::const_iterator i = set.begin(); i != set.end(); ++i)
+        {
+            std::string key = getTypeKey(i->op, index);
+            if (partitions.find(key) == partitions.end() && !key.empty())
+            {
+                keys.push_back(key);
+            }
+            partitions[key].push_back(*i);
+        }
+        std::stable_sort(keys.begin(), keys.end(), isTestedBefore);
+        for (std::vector<std::string>::const_iterator i = keys.begin(); i != keys.end(); ++i)
+        {
+            const OverloadSet& partition = partitions[*i];
+            const Node* saved = currentNode;
+            currentNode = partition.front().op->getParent();
+            writetab();
+            write("if (");
+            writeTypeTest(partition.front().op, index, index);
+            write(") {\n");
+            currentNode = saved;
+                writeDecisionTree(partition, index + 1);
+            writeln("}");
+        }
+        std::map<std::string, OverloadSet>::const_iterator any = partitions.find("");
+        if (any != partitions.end())
+        {
+            return writeDecisionTree(any->second, index + 1);
+        }
+        return false;
+    }
+
+    // Dispatches the effective overload set by the number of arguments
+    // first instead of testing the entries one by one.
+    void writeOverloadSet(const OverloadSet& set)
+    {
+        std::map<int, OverloadSet> table;
+        for (OverloadSet::const_iterator i = set.begin(); i != set.end(); ++i)
+        {
+            table[i->argumentCount].push_back(*i);
+        }
+        writeln("switch (argumentCount) {");
+        unindent();
+        for (std::map<int, OverloadSet>::const_iterator i = table.begin(); i != table.end(); ++i)
+        {
+            writeln("case %d:", i->first);
+            indent();
+            if (!writeDecisionTree(i->second, 0))
+            {
+                writeln("break;");
+            }
+            unindent();
+        }
+        writeln("default:");
+        indent();
+            writeln("break;");
+        writeln("}");
+    }
+
 public:
     MessengerDispatch(Formatter* formatter, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions) :
         Messenger(formatter, stringTypeName, objectTypeName, useExceptions),
         overloaded(false),
-        asSpecial(false)
+        asSpecial(false),
+        caseCount(0)
     {
         currentNode = 0;
     }
 
+    unsigned getCaseCount() const
+    {
+        return caseCount;
+    }
+
     virtual void at(const Enum* node)
     {
     }
@@ -74,7 +505,7 @@ public:
 
     virtual void at(const ConstDcl* node)
     {
-        writeln("case 0x%x:", node->getHash());
+        writeSelectorCase(node->getHash());
         indent();
             writeln("if (argumentCount == GETTER_)");
             indent();
@@ -97,15 +528,29 @@ public:
         assert(!(node->getAttr() & Interface::Supplemental) && !node->isLeaf());
 
         unsigned interfaceNumber;
-        std::list<const Interface*> list;
-        node->getInterfaceList(&list);
-        std::list<const Interface*> mixinList;
-        node->collectMixins(&mixinList);
+        const std::vector<const Interface*>& list = node->getInterfaceList();
+        const std::vector<const Interface*>& mixinList = node->getMixinList();
 
         std::multimap<uint32_t, OpDcl*> operations;
 
-        writeln("template <class IMP>");
-        writeln("static Any dispatch(IMP* self, unsigned selector, const char* id, int argumentCount, Any* arguments) {");
+        Node* base = 0;
+        if (node->getExtends() && !(*node->getExtends()->begin())->isBaseObject())
+        {
+            base = *node->getExtends()->begin();
+        }
+
+        bool useDispatchTable = getContext()->useDispatchTable;
+        if (useDispatchTable)
+        {
+            members.clear();
+            writeln("struct Members;");
+            writeln("static Any dispatch(Imp* self, const Members* members, unsigned selector, const char* id, int argumentCount, Any* arguments) {");
+        }
+        else
+        {
+            writeln("template <class IMP>");
+            writeln("static Any dispatch(IMP* self, unsigned selector, const char* id, int argumentCount, Any* arguments) {");
+        }
         {
             bool doneSelectorZero = false;
 
@@ -117,55 +562,62 @@ public:
             }
             writeln("switch (selector) {");
             unindent();
-            std::list<const Interface*> interfaceList;
-            node->collectSupplementals(&interfaceList);
+            const Interface::MergedMembers& members = node->getMergedMembers();
             Node* stringifier = 0;
-            for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-                i != interfaceList.end();
-                ++i)
+            for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
             {
-                const Node* saved = currentNode;
-                currentNode = *i;
-                for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
+                Node* member = i->node;
+                if (!stringifier && (member->getAttr() & Node::Stringifier))
+                {
+                    stringifier = member;
+                }
+                switch (member->getKind())
+                {
+                case Node::OpDclKind:
                 {
-                    if (!stringifier && ((*j)->getAttr() & Node::Stringifier))
-                    {
-                        stringifier = *j;
-                    }
-                    if (OpDcl* op = dynamic_cast<OpDcl*>(*j))
-                    {
-                        if (op->getAttr() & OpDcl::Static)
-                            continue;
-                        if (!(op->getAttr() & OpDcl::UnnamedProperty))
-                            operations.insert(std::pair<uint32_t, OpDcl*>(op->getHash(), op));
-                        if (op->getAttr() & (OpDcl::UnnamedProperty | OpDcl::Omittable | OpDcl::IndexMask | OpDcl::Caller))
-                            operations.insert(std::pair<uint32_t, OpDcl*>(0, op));
-                        continue;
-                    }
-                    if (Attribute* attr = dynamic_cast<Attribute*>(*j))
-                    {
-                         attr->accept(this);
-                    }
-                    if (ConstDcl* decl = dynamic_cast<ConstDcl*>(*j))
-                    {
-                         decl->accept(this);
-                    }
+                    OpDcl* op = cast<OpDcl>(member);
+                    if (op->getAttr() & OpDcl::Static)
+                        break;
+                    if (!(op->getAttr() & OpDcl::UnnamedProperty))
+                        operations.insert(std::pair<uint32_t, OpDcl*>(op->getHash(), op));
+                    if (op->getAttr() & (OpDcl::UnnamedProperty | OpDcl::Omittable | OpDcl::IndexMask | OpDcl::Caller))
+                        operations.insert(std::pair<uint32_t, OpDcl*>(0, op));
+                    break;
+                }
+                case Node::AttributeKind:
+                case Node::ConstDclKind:
+                {
+                    const Node* saved = currentNode;
+                    currentNode = i->interface;
+                    member->accept(this);
+                    currentNode = saved;
+                    break;
+                }
+                default:
+                    break;
                 }
-                currentNode = saved;
             }
             for (std::multimap<uint32_t, OpDcl*>::iterator i = operations.begin(); i != operations.end(); ++i)
             {
                 asSpecial = (i->first == 0);
-                writeln("case 0x%x:", i->first);
+                writeSelectorCase(i->first);
                 indent();
                 int count = operations.count(i->first);
-                if (count == 1)
+                OverloadSet set;
+                if (i->first != 0 && getEffectiveOverloadSet(i, count, &set) && 1 < set.size())
+                {
+                    // Process overloaded operations and operations with optional arguments
+                    overloaded = (1 < count);
+                    writeOverloadSet(set);
+                    std::advance(i, count - 1);
+                }
+                else if (count == 1)
                 {
                     // Process non-overloaded operations
                     overloaded = false;
                     const Node* saved = currentNode;
                     currentNode = i->second->getParent();
-                    visitInterfaceElement(dynamic_cast<const Interface*>(currentNode), i->second);
+                    visitInterfaceElement(dyn_cast<Interface>(currentNode), i->second);
                     currentNode = saved;
                 }
                 else
@@ -176,7 +628,7 @@ public:
                         OpDcl* op = i->second;
                         const Node* saved = currentNode;
                         currentNode = op->getParent();
-                        visitInterfaceElement(dynamic_cast<const Interface*>(currentNode), op);
+                        visitInterfaceElement(dyn_cast<Interface>(currentNode), op);
                         currentNode = saved;
                     };
                     --i;
@@ -197,7 +649,7 @@ public:
 
             if (!doneSelectorZero)
             {
-                writeln("case 0x0:");
+                writeSelectorCase(0);
                 indent();
                     writeSelectorZero(stringifier);
                 writeln("return Any();");
@@ -208,18 +660,17 @@ public:
             indent();
                 writeln("break;");
             writeln("}");
-            if (node->getExtends())
+            if (base)
             {
-                NodeList::iterator i = node->getExtends()->begin();
-                if ((*i)->isBaseObject())
+                writetab();
+                write("return ");
+                base->accept(this);
+                if (useDispatchTable)
                 {
-                    writeln("return Any();");  // TODO:  should raise an exception?
+                    write("::dispatch(self, members->base(), selector, id, argumentCount, arguments);\n");
                 }
                 else
                 {
-                    writetab();
-                    write("return ");
-                    (*i)->accept(this);
                     write("::dispatch(self, selector, id, argumentCount, arguments);\n");
                 }
             }
@@ -230,6 +681,11 @@ public:
         }
         writeln("}");
 
+        if (useDispatchTable)
+        {
+            writeMemberTable(base);
+        }
+
         if (!mixinList.empty())
         {
             writeln("");
@@ -238,7 +694,7 @@ public:
 
                 writeln("switch (interfaceNumber) {");
                 interfaceNumber = 0;
-                for (std::list<const Interface*>::const_iterator i = list.begin();
+                for (std::vector<const Interface*>::const_iterator i = list.begin();
                     i != list.end();
                     ++i, ++interfaceNumber)
                 {
@@ -257,6 +713,54 @@ public:
         }
     }
 
+    // Writes the table of the members called by the dispatcher, and the
+    // dispatcher for the implementation class IMP, which calls the
+    // dispatcher with the table for IMP.
+    void writeMemberTable(Node* base)
+    {
+        const Node* saved = currentNode;
+        writeln("struct Members {");
+            for (unsigned n = 0; n < members.size(); ++n)
+            {
+                writeMemberType(members[n], n);
+            }
+            currentNode = saved;
+            for (unsigned n = 0; n < members.size(); ++n)
+            {
+                writeln("Member%u Imp::* member%u;", n, n);
+            }
+            if (base)
+            {
+                writetab();
+                write("const ");
+                base->accept(this);
+                write("::Members* (*base)();\n");
+            }
+        writeln("};");
+        writeln("template <class IMP>");
+        writeln("static const Members* getMembers() {");
+            writeln("static const Members members = {");
+                for (unsigned n = 0; n < members.size(); ++n)
+                {
+                    writeln("static_cast<Members::Member%u Imp::*>(static_cast<Members::Member%u IMP::*>(&IMP::%s)),",
+                            n, n, getMemberName(members[n]).c_str());
+                }
+                if (base)
+                {
+                    writetab();
+                    write("&");
+                    base->accept(this);
+                    write("::getMembers<IMP>\n");
+                }
+            writeln("};");
+            writeln("return &members;");
+        writeln("}");
+        writeln("template <class IMP>");
+        writeln("static Any dispatch(IMP* self, unsigned selector, const char* id, int argumentCount, Any* arguments) {");
+            writeln("return dispatch(self, getMembers<IMP>(), selector, id, argumentCount, arguments);");
+        writeln("}");
+    }
+
     virtual void at(const Attribute* node)
     {
         std::string cap = node->getName();
@@ -271,7 +775,7 @@ public:
         std::string name = getBufferName(node);
 
         // getter
-        writeln("case 0x%x:", node->getHash());
+        writeSelectorCase(node->getHash());
         indent();
             writetab();
             write("if (argumentCount == GETTER_");
@@ -281,7 +785,7 @@ public:
             }
             write(")\n");
             indent();
-                writeln("return self->get%s();", cap.c_str());
+                writeln("return %s();", getCallee(GetterMember, node, "get" + cap).c_str());
             unindent();
 
 
@@ -289,26 +793,28 @@ public:
         if (!node->isReadonly() || node->isPutForwards() || node->isReplaceable()) {
             if (node->isPutForwards())
             {
-                Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(node->getParent()));
+                Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(node->getParent()));
                 assert(target);
-                Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+                Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
                 assert(forwards);
                 spec = forwards->getSpec();
             }
             writeln("if (argumentCount == SETTER_) {");
                 writetab();
-                write("self->set%s(", cap.c_str());
+                write("%s(", getCallee(SetterMember, node, "set" + cap).c_str());
                 if (spec->isAny(node->getParent()))
                 {
-                    write("arguments[0]");
+                    writeArgument(0);
                 }
                 else if (spec->isString(node->getParent()) || spec->isEnum(node->getParent()))
                 {
-                    write("arguments[0].toString()");
+                    writeArgument(0);
+                    write(".toString()");
                 }
                 else if (spec->isInterface(node->getParent()) || spec->isSequence(node->getParent()))
                 {
-                    write("arguments[0].toObject()");
+                    writeArgument(0);
+                    write(".toObject()");
                 }
                 else
                 {
@@ -332,7 +838,7 @@ public:
 
     virtual void at(const OpDcl* node)
     {
-        Interface* interface = dynamic_cast<Interface*>(node->getParent());
+        Interface* interface = dyn_cast<Interface>(node->getParent());
         assert(interface);
         size_t paramCount = getParamCount(node);
 
@@ -390,63 +896,29 @@ public:
         if (overloaded)
         {
             size_t n = 0;
-            for (NodeList::iterator i = node->begin(); n < paramCount && i != node->end(); ++i, ++n)
+            size_t index = 0;
+            for (NodeList::iterator i = node->begin(); index < paramCount && i != node->end(); ++i, ++n, ++index)
             {
-                ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+                ParamDcl* param = dyn_cast<ParamDcl>(*i);
                 assert(param);
-                if (!(param->getAttr() & ParamDcl::AllowAny))
+                if (param->getSpanType())
+                {
+                    // The pointer and the length cannot be told apart from
+                    // other primitive values.
+                    ++index;
+                }
+                else if (!(param->getAttr() & ParamDcl::AllowAny))
                 {
                     write(" &&\n");
                     writetab();
                     write("    (");
-                    if (param->getAttr() & (ParamDcl::Nullable || ParamDcl::NullIsEmpty))
-                    {
-                        write("!arguments[%u].hasValue() || ", n);
-                    }
-                    if (param->getSpec()->isInterface(node->getParent()))
-                    {
-                        write("arguments[%u].isObject()", n);
-                        if (!param->getSpec()->isObject(interface))
-                        {
-                            write(" && ");
-                            param->getSpec()->accept(this);
-                            write("::hasInstance(arguments[%u].toObject())", n);
-                        }
-                    }
-                    else if (param->getSpec()->isString(node->getParent()) || param->getSpec()->isEnum(node->getParent()))
-                    {
-                        write("arguments[%u].isString()", n);
-                    }
-                    else
-                    {
-                        // TODO: sequence
-                        assert(!param->getSpec()->isSequence(node->getParent()));
-                        // Now arguments[n] should be a primitive value
-                        write("arguments[%u].isPrimitive()", n);
-                    }
+                    writeTypeTest(node, n, index);
                     write(")");
                 }
             }
         }
         write(") {\n");
-
-            writetab();
-            Node* spec = node->getSpec();
-            if (!spec->isVoid(interface))
-            {
-                write("return ");
-            }
-            if (!node->getName().empty())
-                write("self->%s(", getEscapedName(node->getName()).c_str());
-            else
-                write("(*self)(", getEscapedName(node->getName()).c_str());
-            writeParameters(node);
-            write(");\n");
-            if (spec->isVoid(interface))
-            {
-                writeln("return Any();");
-            }
-
+            writeCall(node);
         writeln("}");
     }
 
@@ -459,13 +931,22 @@ public:
             spec->accept(this);
             write(" >(arguments + %d, argumentCount - %d)", getParamCount() - 1, getParamCount() - 1);
         }
+        else if (Node* element = node->getSpanType())
+        {
+            write("static_cast<const ");
+            element->accept(this);
+            write("*>(static_cast<void*>(arguments[%u])), ", getParamCount() - 1);
+            write("static_cast<unsigned int>(arguments[%u])", getParamCount());
+            ++paramCount;
+        }
         else if (spec->isAny(node->getParent()))
         {
-            write("arguments[%u]", getParamCount() - 1);
+            writeArgument(getParamCount() - 1);
         }
         else if (spec->isString(node->getParent()) || spec->isEnum(node->getParent()))
         {
-            write("arguments[%u].toString()", getParamCount() - 1);
+            writeArgument(getParamCount() - 1);
+            write(".toString()");
         }
         else if (spec->isInterface(node->getParent()) || spec->isSequence(node->getParent()))
         {
@@ -473,11 +954,14 @@ public:
             {
                 write("interface_cast<");
                 spec->accept(this);
-                write(">(arguments[%u].toObject())", getParamCount() - 1);
+                write(">(");
+                writeArgument(getParamCount() - 1);
+                write(".toObject())");
             }
             else
             {
-                write("arguments[%u].toObject()", getParamCount() - 1);
+                writeArgument(getParamCount() - 1);
+                write(".toObject()");
             }
         }
         else if ((node->getParent()->getAttr() & OpDcl::IndexMask) && getParamCount() - 1 == 0)
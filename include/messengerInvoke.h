@@ -72,6 +72,39 @@ class MessengerInvoke : public Messenger
         return post;
     }
 
+    void writeSpanArgument(int n, const std::string& name)
+    {
+        writeln("arguments_[%d] = const_cast<void*>(static_cast<const void*>(%s));", n, name.c_str());
+        writeln("arguments_[%d] = %sLength;", n + 1, name.c_str());
+    }
+
+    // Writes the arguments of the operation constructed in place for
+    // -fmove. The parameters owning their contents are moved.
+    void writeArgumentList(const OpDcl* node, int paramCount, int argumentCount)
+    {
+        writeln("Any arguments_[%u] = {", argumentCount);
+        NodeList::iterator it = node->begin();
+        for (int i = 0; i < paramCount; ++i, ++it)
+        {
+            ParamDcl* param = static_cast<ParamDcl*>(*it);
+            std::string name = getEscapedName(param->getName());
+            const char* separator = (i + 1 < paramCount) ? "," : "";
+            if (param->getSpanType())
+            {
+                writeln("const_cast<void*>(static_cast<const void*>(%s)), %sLength%s", name.c_str(), name.c_str(), separator);
+            }
+            else if (isMovable(param->getSpec(), node->getParent()))
+            {
+                writeln("std::move(%s)%s", name.c_str(), separator);
+            }
+            else
+            {
+                writeln("%s%s", name.c_str(), separator);
+            }
+        }
+        writeln("};");
+    }
+
 public:
     MessengerInvoke(FILE* file, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
         Messenger(file, stringTypeName, objectTypeName, useExceptions, indent)
@@ -108,18 +141,12 @@ public:
 
         methodNumber = 0;
         offset = node->getMeta().length();
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
             const Node* saved = currentNode;
-            currentNode = *i;
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
-            {
-                visitInterfaceElement(*i, *j);
-            }
+            currentNode = i->interface;
+            visitInterfaceElement(i->interface, i->node);
             currentNode = saved;
         }
     }
@@ -154,7 +181,14 @@ public:
         writetab();
         setter(node, className);
         writeln("{");
-            writeln("Any argument_ = %s;", name.c_str());
+            if (isMovable(getSetterSpec(node), node->getParent()))
+            {
+                writeln("Any argument_(std::move(%s));", name.c_str());
+            }
+            else
+            {
+                writeln("Any argument_ = %s;", name.c_str());
+            }
             writeln("message_(0x%x, \"%s\", SETTER_, &argument_);", node->getHash(), node->getName().c_str());
         writeln("}");
         offset += node->getMetaSetter().length();
@@ -164,7 +198,7 @@ public:
 
     virtual void at(const OpDcl* node)
     {
-        Interface* interface = dynamic_cast<Interface*>(node->getParent());
+        Interface* interface = dyn_cast<Interface>(node->getParent());
         assert(interface);
 
         noDefaultArgument = true;
@@ -175,31 +209,63 @@ public:
             // Invoke
             std::string variadicName;
             int paramCount = getParamCount();
+            int argumentCount = paramCount;
             if (0 < paramCount)
             {
-                if (!getVariadic())
-                {
-                    writeln("Any arguments_[%u];", paramCount);
-                }
-                else
+                if (getVariadic())
                 {
                     --paramCount;
-                    writeln("Any arguments_[%u + MAX_VARIADIC_];", paramCount);
+                    --argumentCount;
                 }
                 NodeList::iterator it = node->begin();
-                int i;
-                for (i = 0; i < paramCount; ++i, ++it)
+                for (int i = 0; i < paramCount; ++i, ++it)
                 {
-                    ParamDcl* param = static_cast<ParamDcl*>(*it);
-                    writeln("arguments_[%d] = %s;", i, getEscapedName(param->getName()).c_str());
+                    if (static_cast<ParamDcl*>(*it)->getSpanType())
+                    {
+                        ++argumentCount;
+                    }
                 }
-                if (getVariadic())
+                if (getContext()->useMove && !getVariadic())
+                {
+                    writeArgumentList(node, paramCount, argumentCount);
+                }
+                else
                 {
-                    ParamDcl* param = static_cast<ParamDcl*>(*it);
-                    variadicName = getEscapedName(param->getName());
-                    writeln("for (size_t i = 0; i < %s.size(); ++i) {", variadicName.c_str());
-                        writeln("arguments_[%d + i] = %s[i];", i, variadicName.c_str());
-                    writeln("}");
+                    if (!getVariadic())
+                    {
+                        writeln("Any arguments_[%u];", argumentCount);
+                    }
+                    else
+                    {
+                        writeln("Any arguments_[%u + MAX_VARIADIC_];", argumentCount);
+                    }
+                    it = node->begin();
+                    int n = 0;
+                    for (int i = 0; i < paramCount; ++i, ++it)
+                    {
+                        ParamDcl* param = static_cast<ParamDcl*>(*it);
+                        if (param->getSpanType())
+                        {
+                            writeSpanArgument(n, getEscapedName(param->getName()));
+                            n += 2;
+                        }
+                        else if (isMovable(param->getSpec(), node->getParent()))
+                        {
+                            writeln("arguments_[%d] = std::move(%s);", n++, getEscapedName(param->getName()).c_str());
+                        }
+                        else
+                        {
+                            writeln("arguments_[%d] = %s;", n++, getEscapedName(param->getName()).c_str());
+                        }
+                    }
+                    if (getVariadic())
+                    {
+                        ParamDcl* param = static_cast<ParamDcl*>(*it);
+                        variadicName = getEscapedName(param->getName());
+                        writeln("for (size_t i = 0; i < %s.size(); ++i) {", variadicName.c_str());
+                            writeln("arguments_[%d + i] = %s[i];", n, variadicName.c_str());
+                        writeln("}");
+                    }
                 }
             }
             const char* post = writeInvoke(node, node->getSpec());
@@ -235,11 +301,11 @@ public:
                 }
                 if (!getVariadic())
                 {
-                    write("%u", paramCount);
+                    write("%u", argumentCount);
                 }
                 else
                 {
-                    write("%u + %s.size()", paramCount, variadicName.c_str());
+                    write("%u + %s.size()", argumentCount, variadicName.c_str());
                 }
             }
             write((0 < getParamCount()) ? ", arguments_" : ", 0");
@@ -19,11 +19,15 @@
 #ifndef ESIDL_MESSENGER_META_H_INCLUDED
 #define ESIDL_MESSENGER_META_H_INCLUDED
 
+#include <stdarg.h>
+#include <stdio.h>
+
 #include <map>
 #include <string>
 #include "esidl.h"
 #include "expr.h"
 #include "messenger.h"
+#include "stringPool.h"
 
 /**
  *  name -> digits identifier  // digits represents the # of characters in the identifier
@@ -49,11 +53,19 @@
  *    t: stringifier
  *    o: omittable
  *    i: static
+ *
+ * With -string-pool, a name may refer to a name in the string pool as in
+ * Reflect:
+ *
+ *  name -> digits @  // digits represents the distance back to the name
  */
 
-// Generate the string-encoded interface information for reflection
-class MessengerMeta : public Messenger
+// Collect the string-encoded records of an interface for reflection
+class MessengerMetaRecords : public Visitor
 {
+    StringPool::Records records;
+    bool constructorMode;
+
     void visitInterfaceElement(const Interface* interface, Node* element)
     {
         if (element->isSequence(interface) ||
@@ -63,87 +75,97 @@ class MessengerMeta : public Messenger
         {
             return;
         }
-        writeln("");
-        writetab();
+        records.push_back(StringPool::Record());
         element->accept(this);
     }
 
+    // Appends a number to the current record.
+    void append(const char* format, ...)
+    {
+        char buffer[64];
+        va_list ap;
+        va_start(ap, format);
+        vsnprintf(buffer, sizeof buffer, format, ap);
+        va_end(ap);
+        records.back().append(buffer);
+    }
+
     void processSpecials(const Node* node)
     {
+        StringPool::Record& record = records.back();
         if (node->getAttr() & Node::Stringifier)
         {
-            write("t");
+            record.append("t");
         }
         if (node->getAttr() & Node::IndexCreator)
         {
-            write("c");
+            record.append("c");
         }
         if (node->getAttr() & Node::IndexDeleter)
         {
-            write("d");
+            record.append("d");
         }
         if (node->getAttr() & Node::IndexGetter)
         {
-            write("g");
+            record.append("g");
         }
         if (node->getAttr() & Node::IndexSetter)
         {
-            write("s");
+            record.append("s");
         }
         if (node->getAttr() & Node::Caller)
         {
-            write("f");
+            record.append("f");
         }
         if (node->getAttr() & Node::Omittable)
         {
-            write("o");
+            record.append("o");
         }
         if (node->getAttr() & Node::Static)
         {
-            write("i");
+            record.append("i");
         }
     }
 
 public:
-    MessengerMeta(Formatter* formatter, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions) :
-        Messenger(formatter, stringTypeName, objectTypeName, useExceptions)
+    MessengerMetaRecords() :
+        constructorMode(false)
     {
-        formatter->flush();
-        currentNode = 0;
+    }
+
+    // Gets the records: the I name, the X names, and a record for each
+    // member, which is empty for the members not listed.
+    const StringPool::Records& getRecords() const
+    {
+        return records;
     }
 
     virtual void at(const Module* node)
     {
-        // MessengerMeta{} visiter should be applied for interfaces.
+        // MessengerMetaRecords{} visiter should be applied for interfaces.
     }
 
     virtual void at(const Attribute* node)
     {
-
-        write("\"A");
+        StringPool::Record& record = records.back();
+        record.append("A");
         if (node->isReadonly() && !node->isPutForwards() && node->isReplaceable())
         {
-            write("r");
+            record.append("r");
         }
         processSpecials(node);
-        write("%u%s\"", node->getName().length(), node->getName().c_str());
+        record.appendName(node->getName());
     }
 
     virtual void at(const OpDcl* node)
     {
-        if (constructorMode)
-        {
-            write("\"C");
-        }
-        else
-        {
-            write("\"F");
-        }
+        StringPool::Record& record = records.back();
+        record.append(constructorMode ? "C" : "F");
         processSpecials(node);
         if (!(node->getAttr() & OpDcl::UnnamedProperty))
-            write("%u%s\"", node->getName().length(), node->getName().c_str());
+            record.appendName(node->getName());
         else
-            write("0\"");
+            record.append("0");
     }
 
     virtual void at(const Interface* node)
@@ -153,81 +175,49 @@ public:
             return;
         }
 
-        currentNode = node;
-
-        writeln("static const char* const getMetaData() {");
-            writeln("static const char* metaData =");
-            indent();
-            writetab();
-            write("\"I");
-
+        records.clear();
+        records.push_back(StringPool::Record());
+        records.back().append("I");
 #ifdef USE_CONSTRUCTOR
-            if (node->getConstructor())
-            {
-                write("c");
-            }
+        if (node->getConstructor())
+        {
+            records.back().append("c");
+        }
 #endif
-            write("%u%s\"", node->getPrefixedName().length(), node->getPrefixedName().c_str());
+        records.back().appendName(node->getPrefixedName());
 
-            if (node->getExtends())
-            {
-                for (NodeList::iterator i = node->getExtends()->begin();
-                    i != node->getExtends()->end();
-                    ++i)
-                {
-                    if (!(*i)->isBaseObject())
-                    {
-                        ScopedName* scopedName = static_cast<ScopedName*>(*i);
-                        Node* resolved = scopedName->search(node->getParent());
-                        scopedName->check(resolved, "could not resolve '%s'.", scopedName->getName().c_str());
-                        writeln("");
-                        writetab();
-                        write("\"X%u%s\"", resolved->getPrefixedName().length(), resolved->getPrefixedName().c_str());
-                    }
-                }
-            }
-
-            // Expand supplementals
-            std::list<const Interface*> interfaceList;
-            node->collectSupplementals(&interfaceList);
-            for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-                i != interfaceList.end();
+        if (node->getExtends())
+        {
+            for (NodeList::iterator i = node->getExtends()->begin();
+                i != node->getExtends()->end();
                 ++i)
             {
-                const Node* saved = currentNode;
-                constructorMode = node->isConstructor();
-                for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
+                if (!(*i)->isBaseObject())
                 {
-                    currentNode = *i;
-                    visitInterfaceElement(*i, *j);
+                    ScopedName* scopedName = static_cast<ScopedName*>(*i);
+                    Node* resolved = scopedName->search(node->getParent());
+                    scopedName->check(resolved, "could not resolve '%s'.", scopedName->getName().c_str());
+                    records.push_back(StringPool::Record());
+                    records.back().append("X");
+                    records.back().appendName(resolved->getPrefixedName());
                 }
-                constructorMode = false;
-                currentNode = saved;
             }
+        }
 
-            write(";\n");
-            unindent();
-            writeln("return metaData;");
-        writeln("}");
-
-        writeln("static const char* const getPrefixedName() {");
-            writeln("static const char* const prefixedName = \"%s\";", node->getPrefixedName().c_str());
-            writeln("return prefixedName;");
-        writeln("}");
-
-        writeln("static bool hasInstance(Object& object) {");
-            writeln("return static_cast<bool>(object.message_(0, getPrefixedName(), IS_KIND_OF_, 0));");
-        writeln("}");
-        writeln("static bool hasInstance(const std::shared_ptr<Imp>& pimpl) {");
-            writeln("return pimpl && static_cast<bool>(pimpl->message_(0, getPrefixedName(), IS_KIND_OF_, 0));");
-        writeln("}");
-
-        flush();
+        // Expand supplementals
+        const Interface::MergedMembers& merged = node->getMergedMembers();
+        constructorMode = node->isConstructor();
+        for (Interface::MergedMembers::const_iterator i = merged.begin(); i != merged.end(); ++i)
+        {
+            visitInterfaceElement(i->interface, i->node);
+        }
+        constructorMode = false;
     }
 
     virtual void at(const ConstDcl* node)
     {
-        write("\"K%u%s", node->getName().length(), node->getName().c_str());
+        records.back().append("K");
+        records.back().appendName(node->getName());
 
         Type* type = node->getType();
         assert(type);
@@ -235,81 +225,79 @@ public:
         {
             EvalInteger<bool> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("b%d ", eval.getValue());
+            append("b%d ", eval.getValue());
         }
         else if (type->getName() == "octet")
         {
             EvalInteger<uint8_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("h%u ", eval.getValue());
+            append("h%u ", eval.getValue());
         }
         else if (type->getName() == "byte")
         {
             EvalInteger<int8_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("g%d ", eval.getValue());
+            append("g%d ", eval.getValue());
         }
         else if (type->getName() == "unsigned byte")
         {
             EvalInteger<uint8_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("h%u ", eval.getValue());
+            append("h%u ", eval.getValue());
         }
         else if (type->getName() == "short")
         {
             EvalInteger<int16_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("s%d ", eval.getValue());
+            append("s%d ", eval.getValue());
         }
         else if (type->getName() == "unsigned short")
         {
             EvalInteger<uint16_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("t%u ", eval.getValue());
+            append("t%u ", eval.getValue());
         }
         else if (type->getName() == "long")
         {
             EvalInteger<int32_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("l%ld ", eval.getValue());
+            append("l%ld ", eval.getValue());
         }
         else if (type->getName() == "unsigned long")
         {
             EvalInteger<uint32_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("m%lu ", eval.getValue());
+            append("m%lu ", eval.getValue());
         }
         else if (type->getName() == "long long")
         {
             EvalInteger<int64_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("x%lld ", eval.getValue());
+            append("x%lld ", eval.getValue());
         }
         else if (type->getName() == "unsigned long long")
         {
             EvalInteger<uint64_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("y%llu ", eval.getValue());
+            append("y%llu ", eval.getValue());
         }
         else if (type->getName() == "float")
         {
             EvalFloat<float> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("f%a ", eval.getValue());
+            append("f%a ", eval.getValue());
         }
         else if (type->getName() == "double")
         {
             EvalFloat<double> eval(node->getParent());
             node->getExp()->accept(&eval);
-            write("d%a ", eval.getValue());
+            append("d%a ", eval.getValue());
         }
         else
         {
             node->report("Inv. const type.");
-            exit(EXIT_FAILURE);
+            throw CompilationError();
         }
-        // TODO: Support DOMString and Nullable
-        write("\"");
     }
 
     virtual void at(const Enum* node)
@@ -323,4 +311,129 @@ public:
     }
 };
 
+// Generate the string-encoded interface information for reflection, or refer
+// to it in the string pool if pool is not zero.
+class MessengerMeta : public Messenger
+{
+    const StringPool* pool;
+
+    // Writes the flattened member table with -fmember-table: a (selector,
+    // depth, number) triple for each named member visible in this interface,
+    // sorted by selector, so that an inherited member can be found without
+    // walking up the chain of the super interfaces. The table is keyed by
+    // the selector rather than by the name, so two members having the same
+    // selector are reported as an error. See Reflect::findMember().
+    void writeMemberTable(const Interface* node)
+    {
+        std::map<uint32_t, const Interface::MemberEntry*> members;
+        const Interface::MemberTable& table = node->getMemberTable();
+        for (Interface::MemberTable::const_iterator i = table.begin(); i != table.end(); ++i)
+        {
+            const Node* member = i->second.member;
+            std::pair<std::map<uint32_t, const Interface::MemberEntry*>::iterator, bool> inserted =
+                members.insert(std::pair<uint32_t, const Interface::MemberEntry*>(member->getHash(), &i->second));
+            node->check(inserted.second, "'%s' and '%s' of '%s' have the same selector 0x%x; the member table needs unique selectors.",
+                        inserted.first->second->member->getName().c_str(), member->getName().c_str(),
+                        node->getName().c_str(), member->getHash());
+        }
+        writeln("static const unsigned* getMemberTable(unsigned* count) {");
+        if (members.empty())
+        {
+            writeln("*count = 0;");
+            writeln("return 0;");
+        }
+        else
+        {
+            writeln("static const unsigned memberTable[] = {");
+            for (std::map<uint32_t, const Interface::MemberEntry*>::const_iterator i = members.begin();
+                 i != members.end();
+                 ++i)
+            {
+                writeln("0x%x, %u, %u,  // %s",
+                        i->first, i->second->depth, i->second->number, i->second->member->getName().c_str());
+            }
+            writeln("};");
+            writeln("*count = %u;", static_cast<unsigned>(members.size()));
+            writeln("return memberTable;");
+        }
+        writeln("}");
+    }
+
+public:
+    MessengerMeta(Formatter* formatter, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions,
+                  const StringPool* pool = 0) :
+        Messenger(formatter, stringTypeName, objectTypeName, useExceptions),
+        pool(pool)
+    {
+        formatter->flush();
+        currentNode = 0;
+    }
+
+    virtual void at(const Module* node)
+    {
+        // MessengerMeta{} visiter should be applied for interfaces.
+    }
+
+    virtual void at(const Interface* node)
+    {
+        if (node->isLeaf())
+        {
+            return;
+        }
+
+        currentNode = node;
+
+        writeln("static const char* const getMetaData() {");
+        unsigned offset;
+        if (pool && pool->getOffset(node, &offset))
+        {
+            writeln("return %s + %u;", pool->getName().c_str(), offset);
+        }
+        else
+        {
+            MessengerMetaRecords meta;
+            meta.at(node);
+            const StringPool::Records& records = meta.getRecords();
+            writeln("static const char* metaData =");
+            indent();
+            writetab();
+            for (StringPool::Records::const_iterator i = records.begin(); i != records.end(); ++i)
+            {
+                if (i != records.begin())
+                {
+                    writeln("");
+                    writetab();
+                }
+                if (!i->text.empty())
+                {
+                    write("\"%s\"", i->text.c_str());
+                }
+            }
+            write(";\n");
+            unindent();
+            writeln("return metaData;");
+        }
+        writeln("}");
+
+        if (getContext()->useMemberTable)
+        {
+            writeMemberTable(node);
+        }
+
+        writeln("static const char* const getPrefixedName() {");
+            writeln("static const char* const prefixedName = \"%s\";", node->getPrefixedName().c_str());
+            writeln("return prefixedName;");
+        writeln("}");
+
+        writeln("static bool hasInstance(Object& object) {");
+            writeln("return static_cast<bool>(object.message_(0, getPrefixedName(), IS_KIND_OF_, 0));");
+        writeln("}");
+        writeln("static bool hasInstance(const std::shared_ptr<Imp>& pimpl) {");
+            writeln("return pimpl && static_cast<bool>(pimpl->message_(0, getPrefixedName(), IS_KIND_OF_, 0));");
+        writeln("}");
+
+        flush();
+    }
+};
+
 #endif  // ESIDL_MESSENGER_META_H_INCLUDED
@@ -19,9 +19,9 @@
 #ifndef ESIDL_META_H_INCLUDED
 #define ESIDL_META_H_INCLUDED
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string>
-#include <sstream>
 #include "esidl.h"
 #include "expr.h"
 #include "reflect.h"
@@ -38,12 +38,48 @@ protected:
 
     int paramCount;  // The number of parameters of the previously evaluated operation
     const ParamDcl* variadicParam;  // Non-NULL if the last parameter of the previously evaluated operation is variadic
+    bool spanMode;  // true while writing the type of a parameter passed as a span
 
-    std::ostringstream output;
+    // The string being encoded, which is copied into the MetaArena of the
+    // context once complete. It is reused to keep its capacity.
+    std::string output;
+
+    void writeUnsigned(unsigned long long value)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof buffer, "%llu", value);
+        output += buffer;
+    }
+
+    void writeInteger(long long value)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof buffer, "%lld", value);
+        output += buffer;
+    }
+
+    // Writes value as std::ostream does by default.
+    void writeFloat(double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof buffer, "%g", value);
+        output += buffer;
+    }
+
+    void writeName(const std::string& name)
+    {
+        writeUnsigned(name.length());
+        output += name;
+    }
 
     void writeName(const Node* node)
     {
-        output << node->getName().length() << node->getName();
+        writeName(node->getName());
+    }
+
+    MetaString store()
+    {
+        return getContext()->metaArena.store(output);
     }
 
     int getParamCount() const
@@ -104,7 +140,8 @@ public:
         objectTypeName(objectTypeName),
         currentNode(getSpecification()),
         paramCount(0),
-        variadicParam(0)
+        variadicParam(0),
+        spanMode(false)
     {
     }
 
@@ -119,7 +156,7 @@ public:
             {
                 name = resolved->getQualifiedName();
             }
-            output << name.length() << name;
+            writeName(name);
         }
         else
         {
@@ -131,16 +168,17 @@ public:
     {
         Node* resolved = node->search(currentNode);
         node->check(resolved, "%s could not resolved.", node->getName().c_str());
-        if (dynamic_cast<ExceptDcl*>(resolved))
+        if (dyn_cast<ExceptDcl>(resolved))
         {
             std::string name = resolved->getQualifiedName();
-            output << name.length() << name;
+            writeName(name);
         }
-        else if (dynamic_cast<Interface*>(resolved))
+        else if (dyn_cast<Interface>(resolved))
         {
             std::string name = resolved->getQualifiedName();
             name = getInterfaceName(name);
-            output << Reflect::kObject << name.length() << name;
+            output += Reflect::kObject;
+            writeName(name);
         }
         else
         {
@@ -160,84 +198,84 @@ public:
     {
         if (node->getName() == "void")
         {
-            output << Reflect::kVoid;
+            output += Reflect::kVoid;
         }
         else if (node->getName() == "boolean")
         {
-            output << Reflect::kBoolean;
+            output += Reflect::kBoolean;
         }
         else if (node->getName() == "octet")
         {
-            output << Reflect::kOctet;
+            output += Reflect::kOctet;
         }
         else if (node->getName() == "byte")
         {
-            output << Reflect::kByte;
+            output += Reflect::kByte;
         }
         else if (node->getName() == "unsigned byte")
         {
-            output << Reflect::kUnsignedByte;
+            output += Reflect::kUnsignedByte;
         }
         else if (node->getName() == "short")
         {
-            output << Reflect::kShort;
+            output += Reflect::kShort;
         }
         else if (node->getName() == "unsigned short")
         {
-            output << Reflect::kUnsignedShort;
+            output += Reflect::kUnsignedShort;
         }
         else if (node->getName() == "long")
         {
-            output << Reflect::kLong;
+            output += Reflect::kLong;
         }
         else if (node->getName() == "unsigned long")
         {
-            output << Reflect::kUnsignedLong;
+            output += Reflect::kUnsignedLong;
         }
         else if (node->getName() == "long long")
         {
-            output << Reflect::kLongLong;
+            output += Reflect::kLongLong;
         }
         else if (node->getName() == "unsigned long long")
         {
-            output << Reflect::kUnsignedLongLong;
+            output += Reflect::kUnsignedLongLong;
         }
         else if (node->getName() == "float")
         {
-            output << Reflect::kFloat;
+            output += Reflect::kFloat;
         }
         else if (node->getName() == "unrestricted float")
         {
-            output << Reflect::kFloat;
+            output += Reflect::kFloat;
         }
         else if (node->getName() == "double")
         {
-            output << Reflect::kDouble;
+            output += Reflect::kDouble;
         }
         else if (node->getName() == "unrestricted double")
         {
-            output << Reflect::kDouble;
+            output += Reflect::kDouble;
         }
         else if (node->getName() == "any")
         {
-            output << Reflect::kAny;
+            output += Reflect::kAny;
         }
         else if (node->getName() == "string")
         {
-            output << Reflect::kString;
+            output += Reflect::kString;
         }
         else if (node->getName() == "Date")
         {
-            output << Reflect::kDate;
+            output += Reflect::kDate;
         }
         else
         {
             node->report("Unsupported type name: %s.", node->getName().c_str());
-            exit(EXIT_FAILURE);
+            throw CompilationError();
         }
         if (node->getAttr() & Node::Nullable)
         {
-            output << Reflect::kNullable;
+            output += Reflect::kNullable;
         }
     }
 
@@ -245,47 +283,51 @@ public:
     {
         if (node->getName() == "void_pointer")
         {
-            output << Reflect::kPointer;  // XXX To be unsupported
+            output += Reflect::kPointer;  // XXX To be unsupported
         }
         else
         {
             node->report("Unsupported type name: %s.", node->getName().c_str());
-            exit(EXIT_FAILURE);
+            throw CompilationError();
         }
     }
 
     virtual void at(const UnionType* node)
     {
         // TODO: Maybe we should treat union separately.
-        output << Reflect::kAny;
+        output += Reflect::kAny;
     }
 
     virtual void at(const Enum* node)
     {
-        output << Reflect::kString;
+        output += Reflect::kString;
     }
 
     virtual void at(const SequenceType* node)
     {
-        output << Reflect::kSequence;
+        output += Reflect::kSequence;
+        if (spanMode)
+        {
+            output += Reflect::kSpan;
+        }
         if (node->getMax())
         {
-            output << const_cast<SequenceType*>(node)->getLength(currentNode);
+            writeUnsigned(const_cast<SequenceType*>(node)->getLength(currentNode));
         }
         Node* spec = node->getSpec();
         spec->accept(this);
         if (node->getAttr() & Node::Nullable)
         {
-            output << Reflect::kNullable;
+            output += Reflect::kNullable;
         }
     }
 
     virtual void at(const ArrayType* node)
     {
-        output << Reflect::kArray;
+        output += Reflect::kArray;
         if (node->getMax())
         {
-            output << const_cast<ArrayType*>(node)->getLength(currentNode);
+            writeUnsigned(const_cast<ArrayType*>(node)->getLength(currentNode));
         }
         Node* spec = node->getSpec();
         spec->accept(this);
@@ -293,7 +335,7 @@ public:
 
     void getter(const Attribute* node)
     {
-        output.str("");
+        output.clear();
 
         static Type replaceable("any");
         Node* spec = node->getSpec();
@@ -303,12 +345,12 @@ public:
         }
         SequenceType* seq = const_cast<SequenceType*>(spec->isSequence(node->getParent()));
 
-        output << Reflect::kGetter;
+        output += Reflect::kGetter;
         if (node->isStringifier())
         {
-            output << Reflect::kSpecialStringifier;
+            output += Reflect::kSpecialStringifier;
         }
-        output << '0';
+        output += '0';
 
         if (seq)
         {
@@ -330,17 +372,17 @@ public:
                  i != node->getGetRaises()->end();
                  ++i)
             {
-                output << Reflect::kRaises;
+                output += Reflect::kRaises;
                 (*i)->accept(this);
             }
         }
 
-        node->getMetaGetter() = output.str();
+        node->setMetaGetter(store());
     }
 
     bool setter(const Attribute* node)
     {
-        output.str("");
+        output.clear();
 
         if (node->isReadonly() && !node->isPutForwards() && !node->isReplaceable())
         {
@@ -355,15 +397,17 @@ public:
         }
         else if (node->isPutForwards())
         {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(node->getParent()));
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(node->getParent()));
             assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
             assert(forwards);
             spec = forwards->getSpec();
         }
         SequenceType* seq = const_cast<SequenceType*>(spec->isSequence(node->getParent()));
 
-        output << Reflect::kSetter << '1' << Reflect::kVoid;
+        output += Reflect::kSetter;
+        output += '1';
+        output += Reflect::kVoid;
         writeName(node);
         if (seq)
         {
@@ -384,12 +428,12 @@ public:
                  i != node->getSetRaises()->end();
                  ++i)
             {
-                output << Reflect::kRaises;
+                output += Reflect::kRaises;
                 (*i)->accept(this);
             }
         }
 
-        node->getMetaSetter() = output.str();
+        node->setMetaSetter(store());
 
         return true;
     }
@@ -401,46 +445,45 @@ public:
         {
             setter(node);
         }
-        node->getMeta() = node->getMetaGetter() + node->getMetaSetter();
         node->setHash();
     }
 
     virtual void at(const OpDcl* node)
     {
-        output.str("");
-        output << Reflect::kOperation;
+        output.clear();
+        output += Reflect::kOperation;
 
         if (node->getAttr() & OpDcl::Omittable)
         {
-            output << Reflect::kSpecialOmittable;
+            output += Reflect::kSpecialOmittable;
         }
 
         if (node->getAttr() & OpDcl::IndexGetter)
         {
-            output << Reflect::kSpecialGetter;
+            output += Reflect::kSpecialGetter;
         }
         if (node->getAttr() & OpDcl::IndexSetter)
         {
-            output << Reflect::kSpecialSetter;
+            output += Reflect::kSpecialSetter;
         }
         if (node->getAttr() & OpDcl::IndexCreator)
         {
-            output << Reflect::kSpecialCreator;
+            output += Reflect::kSpecialCreator;
         }
         if (node->getAttr() & OpDcl::IndexDeleter)
         {
-            output << Reflect::kSpecialDeleter;
+            output += Reflect::kSpecialDeleter;
         }
         if (node->getAttr() & OpDcl::Caller)
         {
-            output << Reflect::kSpecialCaller;
+            output += Reflect::kSpecialCaller;
         }
         if (node->getAttr() & OpDcl::Stringifier)
         {
-            output << Reflect::kSpecialStringifier;
+            output += Reflect::kSpecialStringifier;
         }
 
-        output << node->getParamCount(optionalStage);
+        writeUnsigned(node->getParamCount(optionalStage));
 
         Node* spec = node->getSpec();
         spec->accept(this);
@@ -450,7 +493,7 @@ public:
         variadicParam = 0;
         for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
         {
-            ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+            ParamDcl* param = dyn_cast<ParamDcl>(*i);
             assert(param);
             if (param->isOptional())
             {
@@ -468,18 +511,17 @@ public:
         {
             for (NodeList::iterator i = node->getRaises()->begin(); i != node->getRaises()->end(); ++i)
             {
-                output << Reflect::kRaises;
+                output += Reflect::kRaises;
                 (*i)->accept(this);
             }
         }
 
-        node->getMetaOp(optionalStage) = output.str();
-
         if (variadicParam)
         {
             // Insert Reflect::kVariadic just after Reflect::kOperation.
-            node->getMetaOp(optionalStage).insert(1, 1, Reflect::kVariadic);
+            output.insert(1, 1, Reflect::kVariadic);
         }
+        node->setMetaOp(optionalStage, store());
         node->setHash();
     }
 
@@ -490,7 +532,9 @@ public:
         {
             variadicParam = node;
         }
+        spanMode = (node->getSpanType() != 0);
         spec->accept(this);
+        spanMode = false;
         writeName(node);
     }
 
@@ -503,11 +547,11 @@ public:
 
         currentNode = node;
 
-        output.str("");
-        output << Reflect::kInterface;
+        output.clear();
+        output += Reflect::kInterface;
         std::string name = node->getQualifiedName();
         name = getInterfaceName(name);
-        output << name.length() << name;
+        writeName(name);
 
         if (node->getExtends())
         {
@@ -518,10 +562,10 @@ public:
                 ScopedName* scopedName = static_cast<ScopedName*>(*i);
                 Node* resolved = scopedName->search(node->getParent());
                 scopedName->check(resolved, "could not resolve '%s'.", scopedName->getName().c_str());
-                output << Reflect::kExtends;
+                output += Reflect::kExtends;
                 std::string name = resolved->getQualifiedName();
                 name = getInterfaceName(name);
-                output << name.length() << name;
+                writeName(name);
             }
         }
 
@@ -529,12 +573,12 @@ public:
              i != node->getImplements()->end();
              ++i)
         {
-            output << Reflect::kImplements;
+            output += Reflect::kImplements;
             std::string name = (*i)->getQualifiedName();
             name = getInterfaceName(name);
-            output << name.length() << name;
+            writeName(name);
         }
-        node->getMeta() = output.str();
+        node->setMeta(store());
 
         for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
         {
@@ -542,18 +586,12 @@ public:
         }
 
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
             const Node* saved = currentNode;
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
-            {
-                currentNode = *i;
-                visitInterfaceElement(*i, *j);
-            }
+            currentNode = i->interface;
+            visitInterfaceElement(i->interface, i->node);
             currentNode = saved;
         }
 
@@ -568,89 +606,92 @@ public:
         Type* type = node->getType();
         assert(type);
 
-        output.str("");
-        output << Reflect::kConstant;
+        output.clear();
+        output += Reflect::kConstant;
         type->accept(this);
         writeName(node);
         if (type->getName() == "boolean")
         {
             EvalInteger<bool> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeUnsigned(eval.getValue());
         }
         else if (type->getName() == "octet")
         {
             EvalInteger<uint8_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            // std::ostream has written these as characters.
+            output += static_cast<char>(eval.getValue());
         }
         else if (type->getName() == "byte")
         {
             EvalInteger<int8_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            // std::ostream has written these as characters.
+            output += static_cast<char>(eval.getValue());
         }
         else if (type->getName() == "unsigned byte")
         {
             EvalInteger<uint8_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            // std::ostream has written these as characters.
+            output += static_cast<char>(eval.getValue());
         }
         else if (type->getName() == "short")
         {
             EvalInteger<int16_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeInteger(eval.getValue());
         }
         else if (type->getName() == "unsigned short")
         {
             EvalInteger<uint16_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeUnsigned(eval.getValue());
         }
         else if (type->getName() == "long")
         {
             EvalInteger<int32_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeInteger(eval.getValue());
         }
         else if (type->getName() == "unsigned long")
         {
             EvalInteger<uint32_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeUnsigned(eval.getValue());
         }
         else if (type->getName() == "long long")
         {
             EvalInteger<int64_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeInteger(eval.getValue());
         }
         else if (type->getName() == "unsigned long long")
         {
             EvalInteger<uint64_t> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeUnsigned(eval.getValue());
         }
         else if (type->getName() == "float")
         {
             EvalFloat<float> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeFloat(eval.getValue());
         }
         else if (type->getName() == "double")
         {
             EvalFloat<double> eval(node->getParent());
             node->getExp()->accept(&eval);
-            output << eval.getValue();
+            writeFloat(eval.getValue());
         }
         else
         {
             node->report("Inv. const type.");
-            exit(EXIT_FAILURE);
+            throw CompilationError();
         }
-        output << ' ';
-        node->getMeta() = output.str();
+        output += ' ';
+        node->setMeta(store());
         node->setHash();
     }
 
@@ -59,6 +59,7 @@
  *    D: DOMString
  *    Q type: sequence<type>
  *    Q n type: sequence<type, n>           // ES extension
+ *    Q * type: sequence<type> as a span    // ES extension; passed as a pointer and a length
  *    Y type: type[]
  *    Y n type: type[n]                     // ES extension
  *    O name: Object
@@ -80,6 +81,12 @@
  *  raises ->
  *    R name
  *
+ * With -string-pool, the reflection data of all the interfaces are kept in a
+ * single char array, where the names used more than once are stored once
+ * ahead of the interfaces. A name may then refer to one of them:
+ *
+ *  name -> digits @  // digits represents the distance back to the name
+ *
  *  TODO: embed other extended attributes in the meta-data.
  */
 class Reflect
@@ -103,6 +110,7 @@ public:
     static const char kAny = 'A';
     static const char kObject = 'O';
     static const char kSequence = 'Q';
+    static const char kSpan = '*';
     static const char kDate = 'T';
     // Misc.
     static const char kInterface = 'I';
@@ -127,6 +135,8 @@ public:
 
     static const char kNullable = '?';
 
+    static const char kNameReference = '@';
+
     static const char kUndefinedIsNull = 'n';
     static const char kUndefinedIsEmpty = 'e';
     static const char kNullIsEmpty = 'E';
@@ -187,9 +197,30 @@ public:
     {
         unsigned length;
         info = skipDigits(info, &length);
+        if (*info == kNameReference)
+        {
+            return ++info;
+        }
         return info + length;
     }
 
+    /**
+     * Gets the identifier of the name at info, following a reference to a
+     * name in the string pool.
+     * @param info the name in the string encoded reflection data.
+     * @param length the length of the identifier.
+     * @return the first character of the identifier.
+     */
+    static const char* resolveName(const char* info, unsigned* length)
+    {
+        const char* name = skipDigits(info, length);
+        if (*name == kNameReference)
+        {
+            name = skipDigits(info - *length, length);
+        }
+        return name;
+    }
+
     static const char* skipNullable(const char* info)
     {
         if (*info == kNullable)
@@ -199,6 +230,15 @@ public:
         return info;
     }
 
+    static const char* skipSpan(const char* info)
+    {
+        if (*info == kSpan)
+        {
+            ++info;
+        }
+        return info;
+    }
+
     static const char* skipType(const char* info)
     {
         switch (*info)
@@ -222,7 +262,7 @@ public:
         case kString:
             return skipNullable(++info);
         case kSequence:
-            return skipType(skipDigits(++info));
+            return skipType(skipDigits(skipSpan(++info)));
         case kObject:
             return skipName(++info);
         case kArray:
@@ -232,6 +272,33 @@ public:
         }
     }
 
+    /**
+     * Finds a member in the flattened member table of an interface.
+     * @param table the (selector, depth, number) triples sorted by selector,
+     *  as returned by getMemberTable() of the messenger classes generated
+     *  with -fmember-table. The selectors in a table are unique.
+     * @param count the number of the triples in the table.
+     * @param selector the selector of the member.
+     * @return the triple of the member, or 0 if the member is not found.
+     */
+    static const unsigned* findMember(const unsigned* table, unsigned count, uint32_t selector)
+    {
+        unsigned low = 0;
+        unsigned high = count;
+        while (low < high)
+        {
+            unsigned middle = low + (high - low) / 2;
+            const unsigned* entry = table + 3 * middle;
+            if (entry[0] < selector)
+                low = middle + 1;
+            else if (selector < entry[0])
+                high = middle;
+            else
+                return entry;
+        }
+        return 0;
+    }
+
     /**
      * This represents a type record from the specified reflection data.
      */
@@ -442,7 +509,7 @@ public:
                 return "";
             }
             unsigned length;
-            const char* name = skipDigits(info + 1, &length);
+            const char* name = resolveName(info + 1, &length);
             return std::string(name, length);
         }
     };
@@ -484,9 +551,8 @@ public:
          */
         const std::string getName() const
         {
-            const char* name = skipType(info);
             unsigned length;
-            name = skipDigits(name, &length);
+            const char* name = resolveName(skipType(info), &length);
             return std::string(name, length);
         }
 
@@ -568,9 +634,8 @@ public:
          */
         const std::string getName() const
         {
-            const char* name = skipType(skipDigits(skipSpecial(info + 1)));
             unsigned length;
-            name = skipDigits(name, &length);
+            const char* name = resolveName(skipType(skipDigits(skipSpecial(info + 1))), &length);
             return std::string(name, length);
         }
 
@@ -717,9 +782,8 @@ public:
          */
         const std::string getName() const
         {
-            const char* name = skipType(info + 1);
             unsigned length;
-            name = skipDigits(name, &length);
+            const char* name = resolveName(skipType(info + 1), &length);
             return std::string(name, length);
         }
 
@@ -881,7 +945,7 @@ public:
         std::string getQualifiedName() const
         {
             unsigned length;
-            const char* name = skipDigits(info + 1, &length);
+            const char* name = resolveName(info + 1, &length);
             return std::string(name, length);
         }
 
@@ -904,13 +968,12 @@ public:
          */
         std::string getQualifiedSuperName() const
         {
-            const char* super = skipName(info + 1);
-            if (*super != kExtends)
+            unsigned length;
+            const char* super = getQualifiedSuperName(&length);
+            if (!super)
             {
                 return "";
             }
-            unsigned length;
-            super = skipDigits(super + 1, &length);
             return std::string(super, length);
         }
 
@@ -921,7 +984,7 @@ public:
             {
                 return 0;
             }
-            return skipDigits(super + 1, length);
+            return resolveName(super + 1, length);
         }
 
         /**
@@ -1119,7 +1182,7 @@ public:
          */
         Type getType() const
         {
-            return Type(skipDigits(info + 1));
+            return Type(skipDigits(skipSpan(info + 1)));
         }
 
         /**
@@ -1128,9 +1191,18 @@ public:
         unsigned getMax() const
         {
             unsigned max;
-            skipDigits(info + 1, &max);
+            skipDigits(skipSpan(info + 1), &max);
             return max;
         }
+
+        /**
+         * Checks if this sequence is passed as a span, i.e., a pointer to
+         * the elements and the number of them.
+         */
+        bool isSpan() const
+        {
+            return (info[1] == kSpan) ? true : false;
+        }
     };
 
     struct SymbolData
@@ -25,16 +25,18 @@
 
 class Sheet : public Visitor
 {
+    FILE* file;
     const Node* currentModule;
     std::string className;
 
     void print(const Node* node = 0)
     {
-        printf("\"%s\",\"%s\",\"%s\"\n", currentModule->getName().c_str(), className.c_str(), node? node->getName().c_str() : "");
+        fprintf(file, "\"%s\",\"%s\",\"%s\"\n", currentModule->getName().c_str(), className.c_str(), node? node->getName().c_str() : "");
     }
 
 public:
-    Sheet() :
+    Sheet(FILE* file = stdout) :
+        file(file),
         currentModule(0)
     {
     }
@@ -81,19 +83,13 @@ public:
 
         // Expand supplementals
         bool hasMember = false;
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
+            if (!dyn_cast<Interface>(i->node))
             {
-                if (!dynamic_cast<Interface*>(*j))
-                {
-                    hasMember = true;
-                    (*j)->accept(this);
-                }
+                hasMember = true;
+                i->node->accept(this);
             }
         }
         if (!hasMember)
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ESIDL_STRING_POOL_H_INCLUDED
+#define ESIDL_STRING_POOL_H_INCLUDED
+
+#include <ctype.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esidl.h"
+#include "reflect.h"
+
+// StringPool keeps the reflection data of all the interfaces in an output in
+// a single char array. The names that occur more than once, i.e., the
+// identifiers and the interface names in the type signatures, are stored
+// once at the beginning of the pool. A record refers to such a name by its
+// distance back from the reference, written as "digits@" in place of
+// "digits identifier", where that is shorter than the name itself. The
+// reflection data of each interface follows the names as a null-terminated
+// string. See Reflect::resolveName().
+class StringPool
+{
+public:
+    // A record of the reflection data and the positions of the names in it.
+    // Each name is encoded as "digits identifier".
+    struct Record
+    {
+        std::string text;
+        std::vector<size_t> names;
+
+        void append(const std::string& s)
+        {
+            text += s;
+        }
+
+        void appendName(const std::string& name)
+        {
+            char length[16];
+            snprintf(length, sizeof length, "%u", static_cast<unsigned>(name.length()));
+            names.push_back(text.length());
+            text += length;
+            text += name;
+        }
+    };
+    typedef std::vector<Record> Records;
+
+private:
+    struct Entry
+    {
+        const Node* node;
+        Records records;
+
+        Entry(const Node* node, const Records& records) :
+            node(node),
+            records(records)
+        {
+        }
+    };
+
+    std::string name;
+    std::vector<Entry> entries;
+    std::map<std::string, unsigned> names;      // the number of the occurrences of each name
+    std::map<const Node*, unsigned> offsets;
+    std::string pool;
+    std::vector<size_t> lines;                  // the offsets of the names and the records in pool
+    size_t nameCount;
+
+    // Gets the name encoded at pos in text.
+    static std::string getName(const std::string& text, size_t pos)
+    {
+        size_t length = 0;
+        size_t i = pos;
+        for (; i < text.length() && isdigit(text[i]); ++i)
+        {
+            length = 10 * length + (text[i] - '0');
+        }
+        return text.substr(pos, i - pos + length);
+    }
+
+    static std::string toString(size_t n)
+    {
+        char digits[24];
+        snprintf(digits, sizeof digits, "%lu", static_cast<unsigned long>(n));
+        return digits;
+    }
+
+public:
+    StringPool(const std::string& name) :
+        name(name),
+        nameCount(0)
+    {
+    }
+
+    const std::string& getName() const
+    {
+        return name;
+    }
+
+    // Adds the reflection data of node.
+    void add(const Node* node, const Records& records)
+    {
+        entries.push_back(Entry(node, records));
+        for (Records::const_iterator i = records.begin(); i != records.end(); ++i)
+        {
+            for (std::vector<size_t>::const_iterator j = i->names.begin(); j != i->names.end(); ++j)
+            {
+                ++names[getName(i->text, *j)];
+            }
+        }
+    }
+
+    // Lays out the names and then the reflection data added so far. A name
+    // is pooled if its occurrences are longer in total than one copy of it
+    // and the references to it, estimating the length of a reference from
+    // the size of the reflection data without pooling.
+    void build()
+    {
+        size_t size = 0;
+        for (std::vector<Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i)
+        {
+            for (Records::const_iterator j = i->records.begin(); j != i->records.end(); ++j)
+            {
+                size += j->text.length();
+            }
+            ++size;
+        }
+        size_t referenceLength = toString(size).length() + 1;
+
+        pool.clear();
+        lines.clear();
+        offsets.clear();
+        std::map<std::string, size_t> located;
+        for (std::map<std::string, unsigned>::const_iterator i = names.begin(); i != names.end(); ++i)
+        {
+            if (i->first.length() * (i->second - 1) <= referenceLength * i->second)
+            {
+                continue;
+            }
+            located[i->first] = pool.length();
+            lines.push_back(pool.length());
+            pool += i->first;
+        }
+        nameCount = located.size();
+
+        for (std::vector<Entry>::const_iterator i = entries.begin(); i != entries.end(); ++i)
+        {
+            offsets[i->node] = pool.length();
+            for (Records::const_iterator j = i->records.begin(); j != i->records.end(); ++j)
+            {
+                if (j->text.empty())
+                {
+                    continue;
+                }
+                lines.push_back(pool.length());
+                size_t from = 0;
+                for (std::vector<size_t>::const_iterator k = j->names.begin(); k != j->names.end(); ++k)
+                {
+                    pool.append(j->text, from, *k - from);
+                    std::string name = getName(j->text, *k);
+                    from = *k + name.length();
+                    std::map<std::string, size_t>::const_iterator found = located.find(name);
+                    if (found != located.end())
+                    {
+                        std::string reference = toString(pool.length() - found->second) + Reflect::kNameReference;
+                        if (reference.length() < name.length())
+                        {
+                            pool += reference;
+                            continue;
+                        }
+                    }
+                    pool += name;
+                }
+                pool.append(j->text, from, std::string::npos);
+            }
+            pool += '\0';
+        }
+    }
+
+    // Gets the offset of the reflection data of node in the pool.
+    bool getOffset(const Node* node, unsigned* offset) const
+    {
+        std::map<const Node*, unsigned>::const_iterator i = offsets.find(node);
+        if (i == offsets.end())
+        {
+            return false;
+        }
+        *offset = i->second;
+        return true;
+    }
+
+    // The number of the pooled names
+    size_t getNameCount() const
+    {
+        return nameCount;
+    }
+
+    // The number of the interfaces
+    size_t getCount() const
+    {
+        return entries.size();
+    }
+
+    const std::string& getPool() const
+    {
+        return pool;
+    }
+
+    // Gets the offsets of the names and of the records in the pool, for
+    // printing the pool a record per line.
+    const std::vector<size_t>& getLines() const
+    {
+        return lines;
+    }
+};
+
+#endif  // ESIDL_STRING_POOL_H_INCLUDED
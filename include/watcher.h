@@ -0,0 +1,76 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ESIDL_WATCHER_H_INCLUDED
+#define ESIDL_WATCHER_H_INCLUDED
+
+#include "compiler.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Watcher implements 'esidl --watch', a compile server. It compiles the IDL
+// files, waits for them or the IDL files they include to be modified using
+// inotify, and then updates the outputs. Only the output files whose
+// contents have actually changed are rewritten, so that the sources
+// including the generated headers are not rebuilt needlessly.
+//
+// The resolved specification stays in memory between the updates. When
+// some of the IDL files named on the command line have been modified, only
+// these files are parsed again, and Compiler::update() splices their
+// definitions into the specification, resolves the interfaces the
+// dependency graph tells to be impacted, and generates the files made from
+// them. If a modified file is included by another file, changes the files
+// it includes, or cannot be updated for any other reason, everything is
+// compiled again from scratch with a new Compiler. As a syntax tree is
+// never freed, each of these full compilations leaves the previous tree
+// behind.
+class Watcher
+{
+    Compiler::Options options;
+    std::vector<std::string> files;
+    Compiler::Target target;
+    Compiler* compiler;                             // the last successful compilation, or 0
+    std::set<std::string> inputs;                   // files and the files they include as of the last compilation
+    std::map<std::string, std::string> sources;     // inputs as of the last compilation
+    Compiler::Outputs outputs;                      // outputs of the last successful compilation
+    std::set<std::pair<int, std::string> > watched; // inotify watch descriptors of the directories, and file names
+    std::set<std::string> tried;                    // inputs watched or failed to be watched
+
+    Watcher(const Watcher&);
+    Watcher& operator=(const Watcher&);
+
+    bool compile(Compiler::Outputs& result);
+    unsigned write(const Compiler::Outputs& result);
+    bool watch(int fd);
+
+public:
+    Watcher(const Compiler::Options& options, const std::vector<std::string>& files, Compiler::Target target);
+    ~Watcher();
+
+    // Updates the compilation with the IDL files modified since the last
+    // compilation, if any, and writes the changed outputs.
+    bool update();
+
+    // Compiles the IDL files, and keeps updating the outputs as the files
+    // are modified. run() returns only if inotify cannot be set up.
+    int run();
+};
+
+#endif  // ESIDL_WATCHER_H_INCLUDED
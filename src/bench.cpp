@@ -0,0 +1,228 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// esidlbench - measures the compiler over a set of IDL files.
+//
+// Usage: esidlbench [-label NAME] [-I DIR]... FILE...
+//        esidlbench -synthesize COUNT
+//
+// The first form compiles the files with every generator mode, each in a
+// separate process, and prints a tab separated line per mode: the wall
+// clock time of each phase in seconds, the number and the total size of the
+// generated files, and the peak resident set size in KiB. The generated files are
+// kept in memory and not written.
+//
+// The second form prints an IDL file with COUNT interfaces to the
+// standard output.
+
+#include "compiler.h"
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct Mode
+{
+    const char* name;
+    Compiler::Target target;
+    bool generic;       // -template -skeleton
+};
+
+const Mode modes[] =
+{
+    { "cxx", Compiler::CxxTarget, false },
+    { "cxx-template-skeleton", Compiler::CxxTarget, true },
+    { "messenger", Compiler::MessengerTarget, false },
+    { "messenger-src", Compiler::MessengerSrcTarget, false },
+    { "messenger-imp", Compiler::MessengerImpTarget, false },
+    { "messenger-imp-src", Compiler::MessengerImpSrcTarget, false },
+    { "java", Compiler::JavaTarget, false },
+    { "sheet", Compiler::SheetTarget, false },
+};
+
+// Compiles the files as esidl would with the options of the mode.
+bool run(const char* label, const Mode& mode, Compiler::Options options, const std::vector<std::string>& files)
+{
+    switch (mode.target)
+    {
+    case Compiler::MessengerTarget:
+    case Compiler::MessengerSrcTarget:
+    case Compiler::MessengerImpTarget:
+    case Compiler::MessengerImpSrcTarget:
+        options.useMultipleInheritance = false;
+        break;
+    case Compiler::JavaTarget:
+    case Compiler::SheetTarget:
+        options.ctorScope = "_";
+        break;
+    default:
+        options.skeleton = options.generic = mode.generic;
+        break;
+    }
+
+    Compiler compiler(options);
+    Compiler::Outputs outputs;
+    if (!compiler.parse(files) || !compiler.resolve() || !compiler.generate(mode.target, &outputs))
+    {
+        return false;
+    }
+
+    size_t bytes = 0;
+    for (Compiler::Outputs::const_iterator i = outputs.begin(); i != outputs.end(); ++i)
+    {
+        bytes += i->second.size();
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    const Compiler::Timings& timings = compiler.getTimings();
+    double total = timings.cpp.wall + timings.parse.wall + timings.processExtendedAttributes.wall +
+                   timings.adjustMethodCount.wall + timings.meta.wall + timings.dependencyGraph.wall +
+                   timings.generate.wall;
+    printf("%s\t%s\t%.4f\t%.4f\t%.4f\t%.4f\t%.4f\t%.4f\t%.4f\t%.4f\t%zu\t%zu\t%ld\n",
+           label, mode.name,
+           timings.cpp.wall, timings.parse.wall, timings.processExtendedAttributes.wall,
+           timings.adjustMethodCount.wall, timings.meta.wall, timings.dependencyGraph.wall, timings.generate.wall, total,
+           outputs.size(), bytes, usage.ru_maxrss);
+    return true;
+}
+
+// Prints count interfaces exercising inheritance, implements, supplemental
+// interfaces, constants, typedefs and sequences, spread over modules of a
+// hundred interfaces each.
+void synthesize(int count)
+{
+    printf("// Generated by esidlbench -synthesize %d.\n\n", count);
+    printf("module bench {\n\n");
+    printf("typedef sequence<DOMString> StringList;\n\n");
+    for (int i = 0; i < count; ++i)
+    {
+        if (i % 100 == 0)
+        {
+            if (0 < i)
+            {
+                printf("};\n\n");
+            }
+            printf("module m%d {\n\n", i / 100);
+        }
+        if (i % 10 == 9)
+        {
+            // A mixin implemented by the preceding interface.
+            printf("[NoInterfaceObject]\n");
+            printf("interface Interface%d {\n", i);
+            printf("    attribute DOMString mixin%d;\n", i);
+            printf("    void mixinMethod%d(in long value);\n", i);
+            printf("};\n");
+            printf("Interface%d implements Interface%d;\n\n", i - 1, i);
+            continue;
+        }
+        if (i % 10 == 0)
+        {
+            printf("interface Interface%d {\n", i);
+        }
+        else
+        {
+            printf("interface Interface%d : Interface%d {\n", i, i - 1);
+        }
+        printf("    const unsigned short CONSTANT%d = %d;\n", i, i % 65536);
+        printf("    attribute long number%d;\n", i);
+        printf("    readonly attribute DOMString string%d;\n", i);
+        printf("    attribute Interface%d reference%d;\n", i - i % 10, i);
+        printf("    sequence<Interface%d> list%d(in long index, optional DOMString name);\n", i - i % 10, i);
+        printf("    void method%d(in StringList names, in double value, in boolean flag);\n", i);
+        printf("};\n\n");
+        if (i % 10 == 5)
+        {
+            printf("[Supplemental]\n");
+            printf("interface Interface%d {\n", i);
+            printf("    attribute float supplemental%d;\n", i);
+            printf("};\n\n");
+        }
+    }
+    if (0 < count)
+    {
+        printf("};\n\n");
+    }
+    printf("};\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc == 3 && strcmp(argv[1], "-synthesize") == 0)
+    {
+        synthesize(atoi(argv[2]));
+        return EXIT_SUCCESS;
+    }
+
+    const char* label = "-";
+    Compiler::Options options;
+    options.stringTypeName = "std::u16string";
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-label") == 0 && i + 1 < argc)
+        {
+            label = argv[++i];
+        }
+        else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc)
+        {
+            options.cppOptions.push_back(argv[i]);
+            options.cppOptions.push_back(argv[++i]);
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty())
+    {
+        fprintf(stderr, "Usage: esidlbench [-label NAME] [-I DIR]... FILE...\n"
+                        "       esidlbench -synthesize COUNT\n");
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    printf("corpus\tmode\tcpp\tparse\tattributes\tmethods\tmeta\tdependencies\tgenerate\ttotal\tfiles\tbytes\tmaxrss\n");
+    fflush(stdout);
+    for (size_t i = 0; i < sizeof modes / sizeof modes[0]; ++i)
+    {
+        // Measure each mode in a fresh process; the syntax tree is never
+        // freed, and the peak RSS would accumulate otherwise.
+        pid_t id = fork();
+        if (id == 0)
+        {
+            bool succeeded = run(label, modes[i], options, files);
+            fflush(stdout);
+            _exit(succeeded ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        int status;
+        if (id == -1 || waitpid(id, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        {
+            fprintf(stderr, "esidlbench: %s failed\n", modes[i].name);
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,1929 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiler.h"
+#include "info.h"
+#include "meta.h"
+#include "sheet.h"
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace
+{
+
+// Makes context the current context of the calling thread while in scope.
+class ContextSwitch
+{
+    Context* saved;
+
+public:
+    ContextSwitch(Context* context) :
+        saved(setContext(context))
+    {
+    }
+
+    ~ContextSwitch()
+    {
+        setContext(saved);
+    }
+};
+
+// Measures the wall clock time and the CPU time of a phase. who is one of
+// RUSAGE_SELF, RUSAGE_CHILDREN and RUSAGE_THREAD.
+class Stopwatch
+{
+    int who;
+    double wall;
+    double cpu;
+
+    static double getWallTime()
+    {
+        timeval tv;
+        gettimeofday(&tv, 0);
+        return tv.tv_sec + tv.tv_usec / 1000000.0;
+    }
+
+    static double getCPUTime(int who)
+    {
+        rusage usage;
+        getrusage(who, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+               usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+    }
+
+public:
+    Stopwatch(int who = RUSAGE_SELF) :
+        who(who),
+        wall(getWallTime()),
+        cpu(getCPUTime(who))
+    {
+    }
+
+    void stop(Compiler::Time& time) const
+    {
+        time.wall = getWallTime() - wall;
+        time.cpu = getCPUTime(who) - cpu;
+    }
+};
+
+const char* getTargetName(Compiler::Target target)
+{
+    switch (target)
+    {
+    case Compiler::MessengerTarget:
+        return "messenger";
+    case Compiler::MessengerSrcTarget:
+        return "messenger-src";
+    case Compiler::MessengerImpTarget:
+        return "messenger-imp";
+    case Compiler::MessengerImpSrcTarget:
+        return "messenger-imp-src";
+    case Compiler::JavaTarget:
+        return "java";
+    case Compiler::SheetTarget:
+        return "sheet";
+    case Compiler::CxxModuleTarget:
+        return "cxx-module";
+    default:
+        return "cxx";
+    }
+}
+
+void printTime(FILE* file, int indent, const char* name, const Compiler::Time& time, const char* separator)
+{
+    fprintf(file, "%*s\"%s\": { \"wall\": %.6f, \"cpu\": %.6f }%s", indent, "", name, time.wall, time.cpu, separator);
+}
+
+// Adds the counters of a job run in its own context to those of the Compiler.
+void addStatistics(Context::Statistics* sum, const Context::Statistics& statistics)
+{
+    sum->nodes += statistics.nodes;
+    sum->resolveCalls += statistics.resolveCalls;
+    sum->maxResolveDepth = std::max(sum->maxResolveDepth, statistics.maxResolveDepth);
+    sum->searchCalls += statistics.searchCalls;
+    sum->searchComparisons += statistics.searchComparisons;
+    sum->filesWritten += statistics.filesWritten;
+    sum->filesSkipped += statistics.filesSkipped;
+    sum->bytes += statistics.bytes;
+}
+
+void addSizes(std::map<const Interface*, Context::GeneratorSizes>* sum,
+              const std::map<const Interface*, Context::GeneratorSizes>& sizes)
+{
+    for (std::map<const Interface*, Context::GeneratorSizes>::const_iterator i = sizes.begin(); i != sizes.end(); ++i)
+    {
+        Context::GeneratorSizes& generators = (*sum)[i->first];
+        for (Context::GeneratorSizes::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+        {
+            generators[j->first].bytes += j->second.bytes;
+            generators[j->first].cases += j->second.cases;
+        }
+    }
+}
+
+// Returns the descriptor of a new unlinked temporary file.
+int createTemporaryFile()
+{
+    const char* dir = getenv("TMPDIR");
+    std::string name = std::string((dir && *dir) ? dir : "/tmp") + "/esidlXXXXXX";
+    int fd = mkstemp(&name[0]);
+    if (fd == -1)
+    {
+        fprintf(stderr, "esidl: cannot create a temporary file: %s\n", strerror(errno));
+        return -1;
+    }
+    unlink(name.c_str());
+    return fd;
+}
+
+bool isIDL(const std::string& filename)
+{
+    size_t dot = filename.rfind('.');
+    return dot == std::string::npos || strcasecmp(filename.c_str() + dot + 1, "idl") == 0;
+}
+
+// Concatenates the IDL files into an unlinked temporary file with a
+// '#pragma source' line in front of each file, and returns its descriptor.
+int concatenate(const std::vector<std::string>& files)
+{
+    int fd = createTemporaryFile();
+    if (fd == -1)
+    {
+        return -1;
+    }
+
+    FILE* out = fdopen(dup(fd), "w");
+    if (!out)
+    {
+        close(fd);
+        return -1;
+    }
+    for (std::vector<std::string>::const_iterator i = files.begin(); i != files.end(); ++i)
+    {
+        if (!isIDL(*i))
+        {
+            continue;
+        }
+        FILE* in = fopen(i->c_str(), "r");
+        if (!in)
+        {
+            fprintf(stderr, "esidl: cannot open '%s'\n", i->c_str());
+            fclose(out);
+            close(fd);
+            return -1;
+        }
+        fprintf(out, "#pragma source \"%s\"\n", i->c_str());
+        char buffer[4096];
+        size_t size;
+        while (0 < (size = fread(buffer, 1, sizeof buffer, in)))
+        {
+            fwrite(buffer, 1, size, out);
+        }
+        fclose(in);
+    }
+    if (fclose(out) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+// Collects the generated files included by the generated file filename, and
+// returns the number of all the #include directives in it. A quoted name is
+// looked up relative to the directory of filename first.
+unsigned getIncludes(const std::string& filename, const std::string& data, const Compiler::Outputs& outputs,
+                     std::set<std::string>* includes)
+{
+    std::string directory;
+    size_t slash = filename.rfind('/');
+    if (slash != std::string::npos)
+    {
+        directory = filename.substr(0, slash + 1);
+    }
+    unsigned count = 0;
+    for (size_t pos = 0; pos < data.length(); )
+    {
+        size_t end = data.find('\n', pos);
+        if (end == std::string::npos)
+        {
+            end = data.length();
+        }
+        std::string line = data.substr(pos, end - pos);
+        pos = end + 1;
+        if (line.compare(0, 9, "#include ") != 0 || line.length() < 11)
+        {
+            continue;
+        }
+        ++count;
+        char close = (line[9] == '<') ? '>' : '"';
+        size_t last = line.find(close, 10);
+        if (last == std::string::npos)
+        {
+            continue;
+        }
+        std::string name = line.substr(10, last - 10);
+        if (close == '"' && outputs.count(directory + name))
+        {
+            includes->insert(directory + name);
+        }
+        else if (outputs.count(name))
+        {
+            includes->insert(name);
+        }
+    }
+    return count;
+}
+
+struct IncludeRecord
+{
+    std::string filename;
+    unsigned includes;          // all the #include directives
+    unsigned generated;         // the generated files included directly
+    unsigned includedBy;        // the generated files including it directly
+    unsigned affected;          // the generated files including it directly or indirectly
+
+    bool operator<(const IncludeRecord& other) const
+    {
+        if (affected != other.affected)
+        {
+            return other.affected < affected;
+        }
+        return filename < other.filename;
+    }
+};
+
+struct SizeRecord
+{
+    const Interface* interface;
+    unsigned long long bytes;   // by all the generators
+    unsigned operations;
+    unsigned methods;           // the C++ functions the operations are expanded to
+    unsigned long meta;         // the length of the meta data strings
+    unsigned supplementals;     // merged into the interface, recursively
+
+    bool operator<(const SizeRecord& other) const
+    {
+        if (bytes != other.bytes)
+        {
+            return other.bytes < bytes;
+        }
+        return interface->getQualifiedName() < other.interface->getQualifiedName();
+    }
+};
+
+SizeRecord getSizeRecord(const Interface* interface, const Context::GeneratorSizes& sizes)
+{
+    SizeRecord record;
+    record.interface = interface;
+    record.bytes = 0;
+    for (Context::GeneratorSizes::const_iterator i = sizes.begin(); i != sizes.end(); ++i)
+    {
+        record.bytes += i->second.bytes;
+    }
+    record.operations = 0;
+    record.methods = 0;
+    record.meta = interface->getMeta().length();
+    const std::vector<const Interface*>& interfaceList = interface->getExpandedSupplementals();
+    record.supplementals = interfaceList.size() - 1;
+    const Interface::MergedMembers& members = interface->getMergedMembers();
+    for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
+    {
+        Node* member = i->node;
+        switch (member->getKind())
+        {
+        case Node::OpDclKind:
+        {
+            const OpDcl* op = cast<OpDcl>(member);
+            ++record.operations;
+            record.methods += op->getMethodCount();
+            for (size_t k = 0; k < op->getMethodCount(); ++k)
+            {
+                record.meta += op->getMetaOp(k).length();
+            }
+            break;
+        }
+        case Node::AttributeKind:
+        {
+            const Attribute* attribute = cast<Attribute>(member);
+            record.meta += attribute->getMetaGetter().length() + attribute->getMetaSetter().length();
+            break;
+        }
+        case Node::ConstDclKind:
+            record.meta += member->getMeta().length();
+            break;
+        default:
+            break;
+        }
+    }
+    return record;
+}
+
+// Collects the IDL files cpp has read, i.e., the files named on the command
+// line and the files they include, except the system headers.
+class SourceCollector : public Visitor
+{
+    std::set<std::string>* sources;
+
+public:
+    SourceCollector(std::set<std::string>* sources) :
+        sources(sources)
+    {
+    }
+
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Include* node)
+    {
+        if (!node->isSystem() && !node->getName().empty() && node->getName()[0] != '<')
+        {
+            sources->insert(node->getName());
+        }
+    }
+};
+
+// Collects the definitions and the include directives in module and in
+// its nested modules.
+void collect(Node* module, std::vector<Node*>* definitions, std::vector<const Include*>* includes = 0)
+{
+    if (module->isLeaf())
+    {
+        return;
+    }
+    for (NodeList::iterator i = module->begin(); i != module->end(); ++i)
+    {
+        if (dyn_cast<Module>(*i))
+        {
+            collect(*i, definitions, includes);
+        }
+        else if (const Include* include = dyn_cast<Include>(*i))
+        {
+            if (includes)
+            {
+                includes->push_back(include);
+            }
+        }
+        else
+        {
+            definitions->push_back(*i);
+        }
+    }
+}
+
+// Collects the interfaces in the definition, i.e., the definition itself
+// and its constructor.
+void collectInterfaces(const Node* definition, std::set<const Interface*>* interfaces)
+{
+    if (const Interface* interface = dyn_cast<Interface>(definition))
+    {
+        if (!interface->isLeaf())
+        {
+            interfaces->insert(interface);
+            if (const Interface* constructor = interface->getConstructor())
+            {
+                interfaces->insert(constructor);
+            }
+        }
+    }
+}
+
+// Returns true if spec refers to a definition read from one of sources,
+// directly or through typedefs.
+bool refersTo(const Node* spec, const Node* scope, const std::set<std::string>& sources)
+{
+    if (!spec)
+    {
+        return false;
+    }
+    if (const ScopedName* name = dyn_cast<ScopedName>(spec))
+    {
+        Node* resolved = name->search(scope);
+        if (!resolved)
+        {
+            return false;
+        }
+        if (sources.count(resolved->getSource()))
+        {
+            return true;
+        }
+        Member* member = dyn_cast<Member>(resolved);
+        return member && member->isTypedef(member->getParent()) &&
+               refersTo(member->getSpec(), member->getParent(), sources);
+    }
+    if (const SequenceType* sequence = dyn_cast<SequenceType>(spec))
+    {
+        return refersTo(sequence->getSpec(), scope, sources);
+    }
+    if (const ArrayType* array = dyn_cast<ArrayType>(spec))
+    {
+        return refersTo(array->getSpec(), scope, sources);
+    }
+    if (const VariadicType* variadic = dyn_cast<VariadicType>(spec))
+    {
+        return refersTo(variadic->getSpec(), scope, sources);
+    }
+    if (dyn_cast<UnionType>(spec) && !spec->isLeaf())
+    {
+        for (NodeList::iterator i = spec->begin(); i != spec->end(); ++i)
+        {
+            if (refersTo(*i, scope, sources))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool refersTo(const Node* list, const Node* scope, const std::set<std::string>& sources, bool)
+{
+    if (list && !list->isLeaf())
+    {
+        for (NodeList::iterator i = list->begin(); i != list->end(); ++i)
+        {
+            if (refersTo(*i, scope, sources))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Returns true if the definition refers to a definition read from one of
+// sources by its base interfaces, or by the types of its members.
+bool dependsOn(const Node* node, const std::set<std::string>& sources)
+{
+    if (const Interface* interface = dyn_cast<Interface>(node))
+    {
+        if (refersTo(interface->getExtends(), interface->getParent(), sources, true))
+        {
+            return true;
+        }
+    }
+    else if (const Member* member = dyn_cast<Member>(node))
+    {
+        const Node* scope = member->getParent();
+        if (refersTo(member->getSpec(), scope, sources))
+        {
+            return true;
+        }
+        if (const OpDcl* op = dyn_cast<OpDcl>(member))
+        {
+            if (refersTo(op->getRaises(), scope, sources, true))
+            {
+                return true;
+            }
+        }
+        else if (const Attribute* attribute = dyn_cast<Attribute>(member))
+        {
+            if (refersTo(attribute->getGetRaises(), scope, sources, true) ||
+                refersTo(attribute->getSetRaises(), scope, sources, true))
+            {
+                return true;
+            }
+        }
+    }
+    if (!node->isLeaf())
+    {
+        for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
+        {
+            if (dependsOn(*i, sources))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Removes the definitions read from source from module and from its nested
+// modules, and then the modules opened in source that have become empty.
+void removeDefinitions(Node* module, const std::string& source, std::vector<Node*>* removed)
+{
+    if (module->isLeaf())
+    {
+        return;
+    }
+    std::vector<Node*> children(module->begin(), module->end());
+    for (std::vector<Node*>::iterator i = children.begin(); i != children.end(); ++i)
+    {
+        Node* node = *i;
+        if (dyn_cast<Module>(node))
+        {
+            removeDefinitions(node, source, removed);
+            if (node->getSource() != source || 0 < node->getChildrenCount())
+            {
+                continue;
+            }
+        }
+        else if (dyn_cast<Include>(node) || node->getSource() != source)
+        {
+            continue;
+        }
+        module->remove(node);
+        removed->push_back(node);
+    }
+}
+
+// Removes the definitions not read from source and the include directives
+// from module and from its nested modules, and then the empty modules.
+void prune(Node* module, const std::string& source)
+{
+    if (module->isLeaf())
+    {
+        return;
+    }
+    std::vector<Node*> children(module->begin(), module->end());
+    for (std::vector<Node*>::iterator i = children.begin(); i != children.end(); ++i)
+    {
+        Node* node = *i;
+        if (dyn_cast<Module>(node))
+        {
+            prune(node, source);
+            if (0 < node->getChildrenCount())
+            {
+                continue;
+            }
+        }
+        else if (!dyn_cast<Include>(node) && node->getSource() == source)
+        {
+            continue;
+        }
+        module->remove(node);
+    }
+}
+
+// The position of each IDL file in the input of cpp: the files named on the
+// command line in order, and an included file at the position of the file
+// including it first.
+class SourceOrder
+{
+    std::map<std::string, int> positions;
+
+public:
+    SourceOrder(const std::vector<std::string>& files, Node* specification)
+    {
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            positions.insert(std::make_pair(files[i], static_cast<int>(i)));
+        }
+        std::vector<Node*> definitions;
+        std::vector<const Include*> includes;
+        collect(specification, &definitions, &includes);
+        for (bool found = true; found; )
+        {
+            found = false;
+            for (std::vector<const Include*>::const_iterator i = includes.begin(); i != includes.end(); ++i)
+            {
+                std::map<std::string, int>::const_iterator includer = positions.find((*i)->getSource());
+                if (includer != positions.end() && !positions.count((*i)->getName()))
+                {
+                    positions.insert(std::make_pair((*i)->getName(), includer->second));
+                    found = true;
+                }
+            }
+        }
+    }
+
+    // Returns -1 if source is unknown.
+    int get(const std::string& source) const
+    {
+        std::map<std::string, int>::const_iterator found = positions.find(source);
+        return (found != positions.end()) ? found->second : -1;
+    }
+
+    // Returns the first child of module read after source, before which
+    // the definitions read from source are to be inserted; 0 to append them.
+    // The forward declarations, which the C++ target adds in front of the
+    // definitions, are skipped.
+    Node* getNext(Node* module, const std::string& source) const
+    {
+        int position = get(source);
+        if (module->isLeaf() || position == -1)
+        {
+            return 0;
+        }
+        for (NodeList::iterator i = module->begin(); i != module->end(); ++i)
+        {
+            if ((!dyn_cast<Interface>(*i) || !(*i)->isLeaf()) && position < get((*i)->getSource()))
+            {
+                return *i;
+            }
+        }
+        return 0;
+    }
+};
+
+// Orders the definitions by the position of the IDL file they have been
+// read from, and then by their serial numbers.
+class SerialOrder
+{
+    const SourceOrder& order;
+
+public:
+    SerialOrder(const SourceOrder& order) :
+        order(order)
+    {
+    }
+
+    bool operator()(const Node* a, const Node* b) const
+    {
+        int positionA = order.get(a->getSource());
+        int positionB = order.get(b->getSource());
+        if (positionA != positionB)
+        {
+            return positionA < positionB;
+        }
+        return a->getSerial() < b->getSerial();
+    }
+};
+
+// Gives the definitions the order of their serial numbers a fresh parse
+// would give them, as the definitions spliced in have been created after
+// the others. The definitions of a file read again are placed after those
+// of the other files read at its position, i.e., the files it includes.
+void resequence(const std::vector<Node*>& definitions, const SourceOrder& order)
+{
+    std::vector<Node*> sorted(definitions);
+    std::stable_sort(sorted.begin(), sorted.end(), SerialOrder(order));
+    std::vector<unsigned long> serials;
+    for (std::vector<Node*>::const_iterator i = definitions.begin(); i != definitions.end(); ++i)
+    {
+        serials.push_back((*i)->getSerial());
+    }
+    std::sort(serials.begin(), serials.end());
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        sorted[i]->setSerial(serials[i]);
+    }
+}
+
+// Moves the definitions read from source from the specification parsed
+// alone into module, in the order cpp would have read them. Returns the
+// definitions moved, and the modules they have been moved from with the
+// modules they have been moved into.
+void splice(Node* module, Node* parsed, const std::string& source, const SourceOrder& order,
+            std::vector<Node*>* added, std::map<const Node*, Node*>* modules)
+{
+    (*modules)[parsed] = module;
+    if (parsed->isLeaf())
+    {
+        return;
+    }
+    Node* next = order.getNext(module, source);
+    std::vector<Node*> children(parsed->begin(), parsed->end());
+    for (std::vector<Node*>::iterator i = children.begin(); i != children.end(); ++i)
+    {
+        Node* node = *i;
+        if (dyn_cast<Module>(node))
+        {
+            Node* found = 0;
+            if (!module->isLeaf())
+            {
+                for (NodeList::iterator j = module->begin(); j != module->end(); ++j)
+                {
+                    if (dyn_cast<Module>(*j) && (*j)->getName() == node->getName())
+                    {
+                        found = *j;
+                    }
+                }
+            }
+            if (found)
+            {
+                splice(found, node, source, order, added, modules);
+                continue;
+            }
+            prune(node, source);
+            if (node->getChildrenCount() == 0)
+            {
+                continue;
+            }
+        }
+        else if (dyn_cast<Include>(node) || node->getSource() != source)
+        {
+            continue;
+        }
+        parsed->remove(node);
+        module->insert(node, next);
+        added->push_back(node);
+    }
+}
+
+// Points the type nodes in node, which the parser parents to the scope they
+// appear in without adding them to it, to the modules the definitions have
+// been moved into.
+void reparent(Node* node, const std::map<const Node*, Node*>& modules)
+{
+    if (!node)
+    {
+        return;
+    }
+    std::map<const Node*, Node*>::const_iterator found = modules.find(node->getParent());
+    if (found != modules.end())
+    {
+        node->setParent(found->second);
+    }
+    if (Member* member = dyn_cast<Member>(node))
+    {
+        reparent(member->getSpec(), modules);
+    }
+    else if (SequenceType* sequence = dyn_cast<SequenceType>(node))
+    {
+        reparent(sequence->getSpec(), modules);
+    }
+    else if (ArrayType* array = dyn_cast<ArrayType>(node))
+    {
+        reparent(array->getSpec(), modules);
+    }
+    else if (VariadicType* variadic = dyn_cast<VariadicType>(node))
+    {
+        reparent(variadic->getSpec(), modules);
+    }
+    if (!node->isLeaf())
+    {
+        for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
+        {
+            reparent(*i, modules);
+        }
+    }
+}
+
+// Adjusts the method counts of the operations as AdjustMethodCount does,
+// without resolving the inheritance and the implements statements.
+class CountMethods : public Visitor
+{
+public:
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Implements* node)
+    {
+    }
+
+    virtual void at(const OpDcl* node)
+    {
+        const_cast<OpDcl*>(node)->adjustMethodCount();
+    }
+};
+
+// Resolves the inheritance, the implements statements and the supplemental
+// interfaces of the specified interfaces again, in the order
+// AdjustMethodCount does. ImplementedOn is set again for every interface.
+class Relink : public Visitor
+{
+    const std::set<const Interface*>& interfaces;
+    bool importImplements;
+
+    void link(Interface* interface, Interface* mixin, bool importImplements)
+    {
+        if (interfaces.count(interface))
+        {
+            interface->implements(mixin, importImplements);
+        }
+        else if ((mixin->getAttr() & Interface::Supplemental) || importImplements)
+        {
+            mixin->setAttr(mixin->getAttr() | Interface::ImplementedOn);
+        }
+    }
+
+public:
+    Relink(const std::set<const Interface*>& interfaces, bool importImplements) :
+        interfaces(interfaces),
+        importImplements(importImplements)
+    {
+    }
+
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Implements* node)
+    {
+        Implements* implements = const_cast<Implements*>(node);
+        Interface* interface = dyn_cast<Interface>(implements->getFirst()->search(node->getParent()));
+        Interface* mixin = dyn_cast<Interface>(implements->getSecond()->search(node->getParent()));
+        implements->getFirst()->check(interface, "could not resolve '%s'.", implements->getFirst()->getName().c_str());
+        implements->getSecond()->check(mixin, "could not resolve '%s'.", implements->getSecond()->getName().c_str());
+        link(interface, mixin, importImplements);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        visitChildren(node);
+        Interface* interface = const_cast<Interface*>(node);
+        if (interfaces.count(node))
+        {
+            interface->resolveSuperList();
+        }
+        std::vector<Interface*> targets;
+        interface->getSupplementalTargets(&targets);
+        for (std::vector<Interface*>::iterator i = targets.begin(); i != targets.end(); ++i)
+        {
+            link(*i, interface, true);
+        }
+    }
+};
+
+// Numbers the supplemental interfaces again in the order
+// ProcessExtendedAttributes has numbered them, and collects the interfaces
+// merging the supplemental interfaces renamed.
+class Renumber : public Visitor
+{
+    std::set<const Node*>* targets;
+
+public:
+    Renumber(std::set<const Node*>* targets) :
+        targets(targets)
+    {
+        getContext()->supplementalCount = 0;
+    }
+
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        Interface* interface = const_cast<Interface*>(node);
+        if ((node->getAttr() & (Interface::Supplemental | Interface::NoInterfaceObject)) == Interface::Supplemental &&
+            interface->renumber())
+        {
+            std::vector<Interface*> list;
+            interface->getSupplementalTargets(&list);
+            targets->insert(list.begin(), list.end());
+        }
+    }
+};
+
+// Collects the flags the interfaces and the operations get from the others
+// while resolved, and clears them if clear is set.
+class LinkFlags : public Visitor
+{
+    std::map<const Node*, uint32_t>* flags;
+    bool clear;
+
+    void get(const Node* node)
+    {
+        const uint32_t mask = OpDcl::HasCovariant | Interface::ImplementedOn;
+        if (node->getAttr() & mask)
+        {
+            (*flags)[node] = node->getAttr() & mask;
+            if (clear)
+            {
+                const_cast<Node*>(node)->setAttr(node->getAttr() & ~mask);
+            }
+        }
+    }
+
+public:
+    LinkFlags(std::map<const Node*, uint32_t>* flags, bool clear) :
+        flags(flags),
+        clear(clear)
+    {
+    }
+
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        get(node);
+        visitChildren(node);
+    }
+
+    virtual void at(const OpDcl* node)
+    {
+        get(node);
+    }
+};
+
+// Returns true if a module in module, or module itself, has an extended
+// attribute read from source. As the extended attributes of a reopened
+// module replace the earlier ones, they cannot be updated for a file.
+bool hasModuleAttributes(const Node* module, const std::string& source)
+{
+    if (const NodeList* list = module->getExtendedAttributes())
+    {
+        for (NodeList::const_iterator i = list->begin(); i != list->end(); ++i)
+        {
+            if ((*i)->getSource() == source)
+            {
+                return true;
+            }
+        }
+    }
+    if (!module->isLeaf())
+    {
+        for (NodeList::iterator i = module->begin(); i != module->end(); ++i)
+        {
+            if (dyn_cast<Module>(*i) && hasModuleAttributes(*i, source))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Computes the meta data of the specified interfaces only.
+class UpdateMeta : public Meta
+{
+    const std::set<const Interface*>& interfaces;
+
+public:
+    UpdateMeta(const std::string& objectTypeName, const std::set<const Interface*>& interfaces) :
+        Meta(objectTypeName),
+        interfaces(interfaces)
+    {
+    }
+
+    using Meta::at;
+
+    virtual void at(const Interface* node)
+    {
+        if (interfaces.count(node))
+        {
+            Meta::at(node);
+        }
+    }
+};
+
+}  // namespace
+
+Compiler::Options::Options() :
+    isystem(false),
+    useExceptions(true),
+    useVirtualBase(false),
+    useMultipleInheritance(true),
+    useSpan(false),
+    useMove(false),
+    useMinimalIncludes(false),
+    useDispatchTable(false),
+    useMemberTable(false),
+    collectSizes(false),
+    keepUnchanged(false),
+    unitySize(-1),
+    stringTypeName("char*"),
+    objectTypeName("Object"),
+    indent("es"),
+    prefix("::org::w3c::dom"),
+    ctorScope("::"),
+    skeleton(false),
+    generic(false)
+{
+}
+
+Compiler::Time::Time() :
+    wall(0.0),
+    cpu(0.0)
+{
+}
+
+Compiler::GeneratorStatistics::GeneratorStatistics() :
+    files(0),
+    written(0),
+    skipped(0),
+    bytes(0)
+{
+}
+
+Compiler::Job::Job(Target target, const std::string& outputRoot, Outputs* outputs) :
+    target(target),
+    outputRoot(outputRoot),
+    outputs(outputs),
+    succeeded(false)
+{
+}
+
+// A job of generate(Jobs*) and the context it runs in.
+struct Compiler::JobState
+{
+    Compiler* compiler;
+    Job* job;
+    Context context;
+    Time time;
+    pthread_t thread;
+    bool started;
+};
+
+Compiler::Compiler(const Options& options) :
+    options(options)
+{
+    setUp(&context);
+}
+
+// Copies the options into context.
+void Compiler::setUp(Context* context) const
+{
+    if (!options.includePath.empty())
+    {
+        context->includePath = options.includePath.c_str();
+    }
+    if (!options.namespaceName.empty())
+    {
+        context->namespaceName = options.namespaceName.c_str();
+    }
+    context->defaultPrefix = options.prefix.c_str();
+    context->ctorScope = options.ctorScope.c_str();
+    context->useMultipleInheritance = options.useMultipleInheritance;
+    context->useVirtualBase = options.useVirtualBase;
+    context->useSpan = options.useSpan;
+    context->useMove = options.useMove;
+    context->useMinimalIncludes = options.useMinimalIncludes;
+    context->useDispatchTable = options.useDispatchTable;
+    context->useMemberTable = options.useMemberTable;
+    context->collectSizes = options.collectSizes;
+    context->keepUnchanged = options.keepUnchanged;
+    context->unitySize = options.unitySize;
+    context->outputRoot = options.outputRoot;
+}
+
+Compiler::~Compiler()
+{
+    // Note the syntax tree is not freed here; the type nodes can be shared
+    // among several members, and the tree has never had a single owner.
+}
+
+bool Compiler::parse(const std::vector<std::string>& files)
+{
+    ContextSwitch contextSwitch(&context);
+
+    this->files = files;
+
+    // Set up the global module
+    Module* node = new Module("");
+    setSpecification(node);
+    setCurrent(node);
+
+    // Manually install 'object' interface forward declaration.
+    Interface* object = new Interface("object", 0, true);
+    object->setRank(2);
+    getCurrent()->add(object);
+
+    if (Node::getFlatNamespace())
+    {
+        Module* module = new Module(Node::getFlatNamespace());
+        getCurrent()->add(module);
+        setCurrent(module);
+    }
+
+    return load(files);
+}
+
+// Preprocesses the IDL files with cpp and parses them into the current
+// module of the current context.
+bool Compiler::load(const std::vector<std::string>& files)
+{
+    // Load every IDL file at once
+    Stopwatch cpp(RUSAGE_CHILDREN);
+    int source = concatenate(files);
+    if (source == -1)
+    {
+        return false;
+    }
+    int preprocessed = createTemporaryFile();
+    if (preprocessed == -1)
+    {
+        close(source);
+        return false;
+    }
+
+    std::vector<const char*> argCpp;
+    argCpp.push_back("cpp");
+    argCpp.push_back("-C");  // Use -C for cpp by default.
+    for (std::vector<std::string>::const_iterator i = options.cppOptions.begin(); i != options.cppOptions.end(); ++i)
+    {
+        argCpp.push_back(i->c_str());
+    }
+    argCpp.push_back(0);
+
+    // Run cpp to completion before parsing its output so that the time
+    // spent in each can be told apart.
+    pid_t id = fork();
+    if (id == 0)
+    {
+        // execute cpp
+        dup2(source, 0);
+        dup2(preprocessed, 1);
+        close(source);
+        close(preprocessed);
+        execvp(argCpp[0], const_cast<char**>(&argCpp[0]));
+        _exit(EXIT_FAILURE);
+    }
+    close(source);
+    if (id == -1)
+    {
+        close(preprocessed);
+        return false;
+    }
+    int status;
+    while (waitpid(id, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+        {
+            close(preprocessed);
+            return false;
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        close(preprocessed);
+        return false;
+    }
+    lseek(preprocessed, 0, SEEK_SET);
+    cpp.stop(timings.cpp);
+
+    // Process the IDL files
+    Stopwatch parse;
+    bool result;
+    try
+    {
+        result = (input(preprocessed, options.isystem, options.useExceptions, options.stringTypeName.c_str()) == EXIT_SUCCESS);
+    }
+    catch (CompilationError&)
+    {
+        result = false;
+    }
+    close(preprocessed);
+    parse.stop(timings.parse);
+
+    setBaseFilename("");
+    return result;
+}
+
+bool Compiler::resolve()
+{
+    ContextSwitch contextSwitch(&context);
+
+    if (!getSpecification())
+    {
+        return false;
+    }
+    try
+    {
+        Stopwatch stopwatch;
+        ProcessExtendedAttributes processExtendedAttributes;
+        getSpecification()->accept(&processExtendedAttributes);
+        stopwatch.stop(timings.processExtendedAttributes);
+
+        stopwatch = Stopwatch();
+        AdjustMethodCount adjustMethodCount(!options.useMultipleInheritance || Node::getFlatNamespace());
+        getSpecification()->accept(&adjustMethodCount);
+        Linearize linearize;
+        getSpecification()->accept(&linearize);
+        stopwatch.stop(timings.adjustMethodCount);
+
+        stopwatch = Stopwatch();
+        // The meta data takes about 10 bytes per node over dom/*.idl.
+        context.metaArena.reserve(context.statistics.nodes * 12);
+        Meta meta(options.objectTypeName.c_str());
+        getSpecification()->accept(&meta);
+        stopwatch.stop(timings.meta);
+
+        stopwatch = Stopwatch();
+        dependencyGraph.build(getSpecification());
+        stopwatch.stop(timings.dependencyGraph);
+    }
+    catch (CompilationError&)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool Compiler::update(const std::vector<std::string>& modified, Target target, Outputs* outputs)
+{
+    ContextSwitch contextSwitch(&context);
+
+    if (!getSpecification() || modified.empty())
+    {
+        return false;
+    }
+
+    // Remove the forward declarations added by the C++ target, which adds
+    // them again for each IDL file as it generates the files.
+    for (std::vector<Node*>::reverse_iterator i = context.forwardDeclarations.rbegin();
+         i != context.forwardDeclarations.rend();
+         ++i)
+    {
+        (*i)->getParent()->remove(*i);
+    }
+    context.forwardDeclarations.clear();
+
+    std::set<std::string> sources;
+    getSources(&sources);
+    SourceOrder order(files, getSpecification());
+    std::set<std::string> modifiedSources(modified.begin(), modified.end());
+
+    std::vector<Node*> definitions;
+    std::vector<const Include*> includes;
+    collect(getSpecification(), &definitions, &includes);
+
+    // Parse each modified file alone, and make sure that its definitions can
+    // replace the current ones without changing those of the other files.
+    std::vector<Node*> parsed;
+    for (std::vector<std::string>::const_iterator i = modified.begin(); i != modified.end(); ++i)
+    {
+        const std::string& source = *i;
+        if (std::find(files.begin(), files.end(), source) == files.end() ||
+            hasModuleAttributes(getSpecification(), source))
+        {
+            return false;
+        }
+        std::set<std::string> included;
+        for (std::vector<const Include*>::const_iterator j = includes.begin(); j != includes.end(); ++j)
+        {
+            if ((*j)->getName() == source)
+            {
+                return false;
+            }
+            if ((*j)->getSource() == source)
+            {
+                included.insert((*j)->getName());
+            }
+        }
+
+        Module* root = new Module("");
+        Node* current = root;
+        if (Node::getFlatNamespace())
+        {
+            current = new Module(Node::getFlatNamespace());
+            root->add(current);
+        }
+        Node* specification = context.specification;
+        Node* saved = context.current;
+        context.specification = root;
+        context.current = current;
+        bool loaded = load(std::vector<std::string>(1, source));
+        context.specification = specification;
+        context.current = saved;
+        if (!loaded || hasModuleAttributes(root, source))
+        {
+            return false;
+        }
+
+        std::vector<Node*> loadedDefinitions;
+        std::vector<const Include*> loadedIncludes;
+        collect(root, &loadedDefinitions, &loadedIncludes);
+        for (std::vector<Node*>::const_iterator j = loadedDefinitions.begin(); j != loadedDefinitions.end(); ++j)
+        {
+            if ((*j)->getSource() != source && !sources.count((*j)->getSource()))
+            {
+                return false;
+            }
+        }
+        // A file newly included must have been read before source, so that
+        // cpp would skip it as it does now.
+        for (std::vector<const Include*>::const_iterator j = loadedIncludes.begin(); j != loadedIncludes.end(); ++j)
+        {
+            if ((*j)->getSource() != source)
+            {
+                continue;
+            }
+            if (!included.erase((*j)->getName()) &&
+                !(0 <= order.get((*j)->getName()) && order.get((*j)->getName()) < order.get(source)))
+            {
+                return false;
+            }
+        }
+        if (!included.empty())
+        {
+            return false;
+        }
+        parsed.push_back(root);
+    }
+
+    try
+    {
+        // The interfaces affected by the current definitions
+        std::set<const Interface*> seeds;
+        std::set<const Node*> selected;
+        for (std::vector<Node*>::const_iterator i = definitions.begin(); i != definitions.end(); ++i)
+        {
+            Node* node = *i;
+            if (modifiedSources.count(node->getSource()))
+            {
+                if (Implements* implements = dyn_cast<Implements>(node))
+                {
+                    collectInterfaces(implements->getFirst()->search(node->getParent()), &seeds);
+                }
+                collectInterfaces(node, &seeds);
+            }
+            else if (dependsOn(node, modifiedSources))
+            {
+                collectInterfaces(node, &seeds);
+                selected.insert(node);
+            }
+        }
+
+        // Replace the definitions of the modified files.
+        std::vector<Node*> removed;
+        for (std::vector<std::string>::const_iterator i = modified.begin(); i != modified.end(); ++i)
+        {
+            removeDefinitions(getSpecification(), *i, &removed);
+        }
+        std::set<const Interface*> removedInterfaces;
+        for (std::vector<Node*>::const_iterator i = removed.begin(); i != removed.end(); ++i)
+        {
+            collectInterfaces(*i, &removedInterfaces);
+        }
+        std::vector<Node*> added;
+        std::map<const Node*, Node*> modules;
+        for (size_t i = 0; i < modified.size(); ++i)
+        {
+            splice(getSpecification(), parsed[i], modified[i], order, &added, &modules);
+        }
+        for (std::vector<Node*>::const_iterator i = added.begin(); i != added.end(); ++i)
+        {
+            reparent(*i, modules);
+        }
+        std::vector<Node*> addedDefinitions;
+        std::set<const Interface*> addedInterfaces;
+        ProcessExtendedAttributes processExtendedAttributes;
+        CountMethods countMethods;
+        for (std::vector<Node*>::const_iterator i = added.begin(); i != added.end(); ++i)
+        {
+            (*i)->accept(&processExtendedAttributes);
+            (*i)->accept(&countMethods);
+            if (dyn_cast<Module>(*i))
+            {
+                collect(*i, &addedDefinitions);
+            }
+            else
+            {
+                addedDefinitions.push_back(*i);
+            }
+        }
+
+        Renumber renumber(&selected);
+        getSpecification()->accept(&renumber);
+
+        // The interfaces affected by the new definitions
+        for (std::vector<Node*>::const_iterator i = addedDefinitions.begin(); i != addedDefinitions.end(); ++i)
+        {
+            Node* node = *i;
+            if (Implements* implements = dyn_cast<Implements>(node))
+            {
+                Node* interface = implements->getFirst()->search(node->getParent());
+                implements->getFirst()->check(interface, "could not resolve '%s'.", implements->getFirst()->getName().c_str());
+                collectInterfaces(interface, &seeds);
+            }
+            else if (Interface* interface = dyn_cast<Interface>(node))
+            {
+                std::vector<Interface*> targets;
+                interface->getSupplementalTargets(&targets);
+                seeds.insert(targets.begin(), targets.end());
+            }
+            collectInterfaces(node, &addedInterfaces);
+            selected.insert(node);
+        }
+        definitions.clear();
+        collect(getSpecification(), &definitions);
+        resequence(definitions, order);
+        for (std::vector<Node*>::const_iterator i = definitions.begin(); i != definitions.end(); ++i)
+        {
+            if (!modifiedSources.count((*i)->getSource()) && dependsOn(*i, modifiedSources))
+            {
+                collectInterfaces(*i, &seeds);
+                selected.insert(*i);
+            }
+        }
+
+        std::set<const Interface*> changed;
+        for (std::set<const Interface*>::const_iterator i = seeds.begin(); i != seeds.end(); ++i)
+        {
+            std::set<const Interface*> impact;
+            dependencyGraph.getImpact(*i, &impact);
+            changed.insert(impact.begin(), impact.end());
+        }
+        for (std::set<const Interface*>::const_iterator i = removedInterfaces.begin(); i != removedInterfaces.end(); ++i)
+        {
+            changed.erase(*i);
+        }
+        changed.insert(addedInterfaces.begin(), addedInterfaces.end());
+        for (std::set<const Interface*>::const_iterator i = changed.begin(); i != changed.end(); ++i)
+        {
+            const_cast<Interface*>(*i)->unlink();
+        }
+
+        // Link the changed interfaces again, and select the interfaces whose
+        // flags set by the others have changed as well.
+        std::map<const Node*, uint32_t> before;
+        LinkFlags clear(&before, true);
+        getSpecification()->accept(&clear);
+        Relink relink(changed, !options.useMultipleInheritance || Node::getFlatNamespace());
+        getSpecification()->accept(&relink);
+        Linearize linearize;
+        getSpecification()->accept(&linearize);
+        std::map<const Node*, uint32_t> after;
+        LinkFlags keep(&after, false);
+        getSpecification()->accept(&keep);
+        std::map<const Node*, uint32_t> flags(before);
+        flags.insert(after.begin(), after.end());
+        for (std::map<const Node*, uint32_t>::const_iterator i = flags.begin(); i != flags.end(); ++i)
+        {
+            std::map<const Node*, uint32_t>::const_iterator b = before.find(i->first);
+            std::map<const Node*, uint32_t>::const_iterator a = after.find(i->first);
+            if ((b == before.end()) != (a == after.end()) || (b != before.end() && b->second != a->second))
+            {
+                const Node* node = dyn_cast<OpDcl>(i->first) ? i->first->getParent() : i->first;
+                if (const Interface* interface = dyn_cast<Interface>(node))
+                {
+                    changed.insert(interface);
+                }
+            }
+        }
+
+        UpdateMeta meta(options.objectTypeName.c_str(), changed);
+        getSpecification()->accept(&meta);
+        dependencyGraph.build(getSpecification());
+
+        // Generate the files made from the changed definitions, and the
+        // unity files which have lost their interfaces. The definitions of
+        // the same name are generated again together, as they are generated
+        // into the same files, and the last one wins.
+        selected.insert(changed.begin(), changed.end());
+        std::set<std::string> names;
+        for (std::set<const Node*>::const_iterator i = selected.begin(); i != selected.end(); ++i)
+        {
+            names.insert((*i)->getQualifiedName());
+        }
+        context.selective = true;
+        context.selectedSources = modifiedSources;
+        for (std::vector<Node*>::const_iterator i = definitions.begin(); i != definitions.end(); ++i)
+        {
+            if (selected.count(*i) || names.count((*i)->getQualifiedName()))
+            {
+                context.selectedNodes.insert(*i);
+                if (const Interface* interface = dyn_cast<Interface>(*i))
+                {
+                    if (const Interface* constructor = interface->getConstructor())
+                    {
+                        context.selectedNodes.insert(constructor);
+                    }
+                }
+            }
+        }
+        context.selectedNodes.insert(selected.begin(), selected.end());
+        for (std::set<const Node*>::const_iterator i = context.selectedNodes.begin(); i != context.selectedNodes.end(); ++i)
+        {
+            context.selectedSources.insert((*i)->getSource());
+        }
+        std::set<const Node*> removedNodes(removed.begin(), removed.end());
+        removedNodes.insert(removedInterfaces.begin(), removedInterfaces.end());
+        std::map<std::string, Context::OutputOrigin> origins;
+        origins.swap(context.outputOrigins);
+        for (std::map<std::string, Context::OutputOrigin>::const_iterator i = origins.begin(); i != origins.end(); ++i)
+        {
+            for (std::vector<const Node*>::const_iterator j = i->second.nodes.begin(); j != i->second.nodes.end(); ++j)
+            {
+                if (removedNodes.count(*j))
+                {
+                    context.selectedFiles.insert(i->first);
+                }
+            }
+        }
+
+        Stopwatch stopwatch;
+        Context::Statistics statistics = context.statistics;
+        context.outputs = outputs;
+        bool result = run(target);
+        context.outputs = 0;
+        stopwatch.stop(timings.generate);
+        count(target, timings.generate, statistics, context.statistics);
+
+        // Keep the origins of the files not generated again unless they have
+        // been made from the definitions just removed, or have been removed
+        // like the units of -unity no longer needed.
+        for (std::map<std::string, Context::OutputOrigin>::const_iterator i = origins.begin(); i != origins.end(); ++i)
+        {
+            if (outputs && !outputs->count(i->first))
+            {
+                continue;
+            }
+            bool stale = removedNodes.count(i->second.node);
+            for (std::vector<const Node*>::const_iterator j = i->second.nodes.begin(); j != i->second.nodes.end(); ++j)
+            {
+                stale = stale || removedNodes.count(*j);
+            }
+            if (!stale)
+            {
+                context.outputOrigins.insert(*i);
+            }
+            else if (outputs && !context.outputOrigins.count(i->first))
+            {
+                outputs->erase(i->first);
+            }
+        }
+        context.selective = false;
+        context.selectedFiles.clear();
+        context.selectedNodes.clear();
+        context.selectedSources.clear();
+        return result;
+    }
+    catch (CompilationError&)
+    {
+        context.selective = false;
+        return false;
+    }
+}
+
+bool Compiler::generate(Target target, Outputs* outputs)
+{
+    ContextSwitch contextSwitch(&context);
+
+    if (!getSpecification())
+    {
+        return false;
+    }
+
+    Stopwatch stopwatch;
+    Context::Statistics before = context.statistics;
+    context.outputs = outputs;
+    context.outputOrigins.clear();
+    bool result = run(target);
+    context.outputs = 0;
+    stopwatch.stop(timings.generate);
+    count(target, timings.generate, before, context.statistics);
+    return result;
+}
+
+bool Compiler::generate(Jobs* jobs)
+{
+    if (!context.specification)
+    {
+        return false;
+    }
+
+    Stopwatch stopwatch;
+    std::vector<JobState*> states;
+    for (Jobs::iterator i = jobs->begin(); i != jobs->end(); ++i)
+    {
+        JobState* state = new JobState;
+        state->compiler = this;
+        state->job = &*i;
+        setUp(&state->context);
+        state->context.specification = context.specification;
+        state->context.current = context.specification;
+        state->context.outputs = i->outputs;
+        if (!i->outputRoot.empty())
+        {
+            state->context.outputRoot = i->outputRoot;
+        }
+        states.push_back(state);
+        // The C++ target adds the forward declarations to the specification,
+        // so it is run alone after the other targets.
+        state->started = (i->target != CxxTarget && pthread_create(&state->thread, 0, runJob, state) == 0);
+    }
+
+    bool result = true;
+    context.outputOrigins.clear();
+    for (std::vector<JobState*>::iterator i = states.begin(); i != states.end(); ++i)
+    {
+        if ((*i)->started)
+        {
+            pthread_join((*i)->thread, 0);
+        }
+    }
+    for (std::vector<JobState*>::iterator i = states.begin(); i != states.end(); ++i)
+    {
+        JobState* state = *i;
+        if (!state->started)
+        {
+            runJob(state);
+        }
+        if (!state->job->succeeded)
+        {
+            result = false;
+        }
+        count(state->job->target, state->time, Context::Statistics(), state->context.statistics);
+        addStatistics(&context.statistics, state->context.statistics);
+        addSizes(&context.sizes, state->context.sizes);
+        context.outputOrigins.insert(state->context.outputOrigins.begin(), state->context.outputOrigins.end());
+        delete state;
+    }
+    stopwatch.stop(timings.generate);
+    return result;
+}
+
+void* Compiler::runJob(void* param)
+{
+    JobState* state = static_cast<JobState*>(param);
+    ContextSwitch contextSwitch(&state->context);
+
+    Stopwatch stopwatch(RUSAGE_THREAD);
+    state->job->succeeded = state->compiler->run(state->job->target);
+    stopwatch.stop(state->time);
+    return 0;
+}
+
+// Runs the generator of target in the current context.
+bool Compiler::run(Target target) const
+{
+    const char* stringTypeName = options.stringTypeName.c_str();
+    const char* objectTypeName = options.objectTypeName.c_str();
+    const char* indent = options.indent.c_str();
+    int result = EXIT_SUCCESS;
+    try
+    {
+        switch (target)
+        {
+        case MessengerTarget:
+            if (options.stringPoolName.empty())
+            {
+                result = printMessenger(stringTypeName, objectTypeName, options.useExceptions, options.useVirtualBase, indent);
+            }
+            else
+            {
+                StringPool stringPool(options.stringPoolName);
+                buildMessengerStringPool(&stringPool);
+                result = printMessenger(stringTypeName, objectTypeName, options.useExceptions, options.useVirtualBase, indent,
+                                        &stringPool);
+                printStringPool(&stringPool);
+            }
+            break;
+        case MessengerSrcTarget:
+            result = printMessengerSrc(stringTypeName, objectTypeName, options.useExceptions, options.useVirtualBase, indent);
+            break;
+        case MessengerImpTarget:
+            result = printMessengerImp(stringTypeName, objectTypeName, options.useExceptions, options.useVirtualBase, indent);
+            break;
+        case MessengerImpSrcTarget:
+            result = printMessengerImpSrc(stringTypeName, objectTypeName, options.useExceptions, options.useVirtualBase, indent);
+            break;
+        case JavaTarget:
+            result = printJava(indent);
+            break;
+        case CxxModuleTarget:
+            result = printCxxModules(stringTypeName, options.stringViewTypeName.c_str(), objectTypeName,
+                                     options.useVirtualBase, indent, options.modulePrelude.c_str());
+            break;
+        case SheetTarget:
+            {
+                FILE* file = openOutput("-");
+                if (!file)
+                {
+                    result = EXIT_FAILURE;
+                    break;
+                }
+                Sheet visitor(file);
+                getSpecification()->accept(&visitor);
+                closeOutput(file);
+            }
+            break;
+        default:
+            {
+                StringPool stringPool(options.stringPoolName);
+                if (!options.stringPoolName.empty())
+                {
+                    buildStringPool(&stringPool, files);
+                }
+                for (std::vector<std::string>::const_iterator i = files.begin(); i != files.end(); ++i)
+                {
+                    result = output(i->c_str(), options.isystem, options.useExceptions, options.useVirtualBase,
+                                    stringTypeName, options.stringViewTypeName.c_str(), objectTypeName, indent,
+                                    options.skeleton, options.generic,
+                                    options.stringPoolName.empty() ? 0 : &stringPool);
+                }
+                if (!options.stringPoolName.empty())
+                {
+                    printStringPool(&stringPool);
+                }
+            }
+            break;
+        }
+    }
+    catch (CompilationError&)
+    {
+        result = EXIT_FAILURE;
+    }
+    Context* current = getContext();
+    while (!current->outputBuffers.empty())
+    {
+        closeOutput(current->outputBuffers.begin()->first);
+    }
+    return result == EXIT_SUCCESS;
+}
+
+// Adds what target has generated between before and after.
+void Compiler::count(Target target, const Time& time, const Context::Statistics& before, const Context::Statistics& after)
+{
+    GeneratorStatistics& statistics = generatorStatistics[target];
+    statistics.time.wall += time.wall;
+    statistics.time.cpu += time.cpu;
+    statistics.written += after.filesWritten - before.filesWritten;
+    statistics.skipped += after.filesSkipped - before.filesSkipped;
+    statistics.files = statistics.written + statistics.skipped;
+    statistics.bytes += after.bytes - before.bytes;
+}
+
+void Compiler::getSources(std::set<std::string>* sources) const
+{
+    sources->insert(files.begin(), files.end());
+    if (context.specification)
+    {
+        ContextSwitch contextSwitch(const_cast<Context*>(&context));
+        SourceCollector collector(sources);
+        context.specification->accept(&collector);
+    }
+}
+
+bool Compiler::getImpact(const std::string& interfaceName, std::set<std::string>* filenames) const
+{
+    const Interface* interface = dependencyGraph.find(interfaceName);
+    if (!interface)
+    {
+        return false;
+    }
+    std::set<const Interface*> impact;
+    dependencyGraph.getImpact(interface, &impact);
+
+    std::set<std::string> sources;
+    for (std::set<const Interface*>::const_iterator i = impact.begin(); i != impact.end(); ++i)
+    {
+        sources.insert((*i)->getSource());
+    }
+
+    for (std::map<std::string, Context::OutputOrigin>::const_iterator i = context.outputOrigins.begin();
+         i != context.outputOrigins.end();
+         ++i)
+    {
+        const Interface* origin = dyn_cast<Interface>(i->second.node);
+        if (origin ? impact.count(origin) : sources.count(i->second.source))
+        {
+            filenames->insert(i->first);
+        }
+        for (std::vector<const Node*>::const_iterator j = i->second.nodes.begin(); j != i->second.nodes.end(); ++j)
+        {
+            if (impact.count(dyn_cast<Interface>(*j)))
+            {
+                filenames->insert(i->first);
+            }
+        }
+    }
+    return true;
+}
+
+void Compiler::printIncludeReport(const Outputs& outputs, FILE* file)
+{
+    std::map<std::string, std::set<std::string> > includedBy;
+    std::vector<IncludeRecord> records;
+    unsigned includes = 0;
+    unsigned generated = 0;
+    for (Outputs::const_iterator i = outputs.begin(); i != outputs.end(); ++i)
+    {
+        std::set<std::string> list;
+        IncludeRecord record;
+        record.filename = i->first;
+        record.includes = getIncludes(i->first, i->second, outputs, &list);
+        record.generated = list.size();
+        records.push_back(record);
+        includes += record.includes;
+        generated += record.generated;
+        for (std::set<std::string>::const_iterator j = list.begin(); j != list.end(); ++j)
+        {
+            includedBy[*j].insert(i->first);
+        }
+    }
+
+    for (std::vector<IncludeRecord>::iterator i = records.begin(); i != records.end(); ++i)
+    {
+        // Follow the edges backward to find every file to be recompiled if
+        // this file changes.
+        std::set<std::string> affected;
+        std::vector<std::string> stack(1, i->filename);
+        while (!stack.empty())
+        {
+            std::string filename = stack.back();
+            stack.pop_back();
+            const std::set<std::string>& users = includedBy[filename];
+            for (std::set<std::string>::const_iterator j = users.begin(); j != users.end(); ++j)
+            {
+                if (*j != i->filename && affected.insert(*j).second)
+                {
+                    stack.push_back(*j);
+                }
+            }
+        }
+        const std::set<std::string>& users = includedBy[i->filename];
+        i->includedBy = users.size() - users.count(i->filename);
+        i->affected = affected.size();
+    }
+    std::sort(records.begin(), records.end());
+
+    fprintf(file, "# includes: the #include directives; generated: the generated files included;\n");
+    fprintf(file, "# included-by: the generated files including the file; affected: directly or indirectly\n");
+    fprintf(file, "%8s %9s %11s %8s  %s\n", "includes", "generated", "included-by", "affected", "file");
+    for (std::vector<IncludeRecord>::const_iterator i = records.begin(); i != records.end(); ++i)
+    {
+        fprintf(file, "%8u %9u %11u %8u  %s\n",
+                i->includes, i->generated, i->includedBy, i->affected, i->filename.c_str());
+    }
+    fprintf(file, "# %lu files, %u includes, %u of the generated files\n",
+            static_cast<unsigned long>(records.size()), includes, generated);
+}
+
+void Compiler::printSizeReport(FILE* file) const
+{
+    std::vector<SizeRecord> records;
+    for (std::map<const Interface*, Context::GeneratorSizes>::const_iterator i = context.sizes.begin();
+         i != context.sizes.end();
+         ++i)
+    {
+        records.push_back(getSizeRecord(i->first, i->second));
+    }
+    std::sort(records.begin(), records.end());
+
+    fprintf(file, "[");
+    for (std::vector<SizeRecord>::const_iterator i = records.begin(); i != records.end(); ++i)
+    {
+        fprintf(file, "%s\n  {\n", (i == records.begin()) ? "" : ",");
+        fprintf(file, "    \"interface\": \"%s\",\n", i->interface->getQualifiedName().c_str());
+        fprintf(file, "    \"source\": \"%s\",\n", i->interface->getSource().c_str());
+        fprintf(file, "    \"bytes\": %llu,\n", i->bytes);
+        fprintf(file, "    \"operations\": %u,\n", i->operations);
+        fprintf(file, "    \"methods\": %u,\n", i->methods);
+        fprintf(file, "    \"meta\": %lu,\n", i->meta);
+        fprintf(file, "    \"supplementals\": %u,\n", i->supplementals);
+        fprintf(file, "    \"generators\": {");
+        const Context::GeneratorSizes& sizes = context.sizes.find(i->interface)->second;
+        for (Context::GeneratorSizes::const_iterator j = sizes.begin(); j != sizes.end(); ++j)
+        {
+            fprintf(file, "%s\n      \"%s\": { \"bytes\": %llu, \"cases\": %lu }",
+                    (j == sizes.begin()) ? "" : ",", j->first.c_str(), j->second.bytes, j->second.cases);
+        }
+        fprintf(file, "%s}\n", sizes.empty() ? "" : "\n    ");
+        fprintf(file, "  }");
+    }
+    fprintf(file, "%s]\n", records.empty() ? "" : "\n");
+}
+
+void Compiler::printStatistics(FILE* file) const
+{
+    const Context::Statistics& statistics = context.statistics;
+    fprintf(file, "{\n");
+    fprintf(file, "  \"phases\": {\n");
+    printTime(file, 4, "cpp", timings.cpp, ",\n");
+    printTime(file, 4, "parse", timings.parse, ",\n");
+    printTime(file, 4, "processExtendedAttributes", timings.processExtendedAttributes, ",\n");
+    printTime(file, 4, "adjustMethodCount", timings.adjustMethodCount, ",\n");
+    printTime(file, 4, "meta", timings.meta, ",\n");
+    printTime(file, 4, "dependencyGraph", timings.dependencyGraph, ",\n");
+    printTime(file, 4, "generate", timings.generate, "\n");
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"nodes\": %lu,\n", statistics.nodes);
+    fprintf(file, "  \"resolve\": { \"calls\": %lu, \"maxDepth\": %u },\n",
+            statistics.resolveCalls, statistics.maxResolveDepth);
+    fprintf(file, "  \"search\": { \"calls\": %lu, \"comparisons\": %lu },\n",
+            statistics.searchCalls, statistics.searchComparisons);
+    fprintf(file, "  \"generators\": {");
+    for (std::map<Target, GeneratorStatistics>::const_iterator i = generatorStatistics.begin();
+         i != generatorStatistics.end();
+         ++i)
+    {
+        const GeneratorStatistics& generator = i->second;
+        fprintf(file, "%s\n    \"%s\": {\n", (i == generatorStatistics.begin()) ? "" : ",", getTargetName(i->first));
+        printTime(file, 6, "time", generator.time, ",\n");
+        fprintf(file, "      \"files\": %lu,\n", generator.files);
+        fprintf(file, "      \"written\": %lu,\n", generator.written);
+        fprintf(file, "      \"skipped\": %lu,\n", generator.skipped);
+        fprintf(file, "      \"bytes\": %llu\n", generator.bytes);
+        fprintf(file, "    }");
+    }
+    fprintf(file, "%s}\n", generatorStatistics.empty() ? "" : "\n  ");
+    fprintf(file, "}\n");
+}
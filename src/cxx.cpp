@@ -18,9 +18,15 @@
 #include "cxx.h"
 #include "info.h"
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
 class CxxInterface : public Cxx
 {
     bool useVirtualBase;
+    const StringPool* stringPool;
 
     // TODO: Move to Cxx
     void visitInterfaceElement(const Interface* interface, Node* element)
@@ -36,12 +42,27 @@ class CxxInterface : public Cxx
 
 public:
     CxxInterface(const char* source, FILE* file, const char* stringTypeName = "char*", const char* objectTypeName = "object",
-        bool useExceptions = true, bool useVirtualBase = false, const char* indent = "es") :
-        Cxx(source, file, stringTypeName, objectTypeName, useExceptions, indent),
-        useVirtualBase(useVirtualBase)
+        bool useExceptions = true, bool useVirtualBase = false, const char* indent = "es", const char* stringViewTypeName = "",
+        const StringPool* stringPool = 0) :
+        Cxx(source, file, stringTypeName, objectTypeName, useExceptions, indent, stringViewTypeName),
+        useVirtualBase(useVirtualBase),
+        stringPool(stringPool)
     {
     }
 
+    // Prints a definition on its own as at(const Module*) would print it
+    // among the other definitions of its module. The enclosing namespaces
+    // are not printed.
+    void printDefinition(const Node* node)
+    {
+        const Node* saved = currentNode;
+        moduleName = (node->getParent() == getSpecification()) ? "" : node->getParent()->getQualifiedName();
+        currentNode = node;
+        const_cast<Node*>(node)->accept(this);
+        currentNode = saved;
+        moduleName = "";
+    }
+
     virtual void at(const ExceptDcl* node)
     {
         writetab();
@@ -77,6 +98,7 @@ public:
         }
         else
         {
+            SizeProbe probe(getFile(), node, "CxxInterface");
             if (node->getExtends())
             {
                 write(" : ");
@@ -107,9 +129,8 @@ public:
             }
 
             // Expand mixins
-            std::list<const Interface*> interfaceList;
-            node->collectSupplementals(&interfaceList);
-            for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
+            const std::vector<const Interface*>& interfaceList = node->getExpandedSupplementals();
+            for (std::vector<const Interface*>::const_iterator i = interfaceList.begin();
                  i != interfaceList.end();
                  ++i)
             {
@@ -130,18 +151,32 @@ public:
                 writeln("return name;");
             writeln("}");
 
-            writeln("static const char* info() {");
-                writetab();
-                write("static const char* const info =");
-                flush();
-                indent();
-                Info info(this);
-                const_cast<Interface*>(node)->accept(&info);
-                info.flush();
-                write(";\n");
-                unindent();
-                writeln("return info;");
-            writeln("}");
+            unsigned offset;
+            if (stringPool && stringPool->getOffset(node, &offset))
+            {
+                SizeProbe probe(getFile(), node, "Info");
+                writeln("static const char* info() {");
+                    writeln("return %s + %u;", stringPool->getName().c_str(), offset);
+                writeln("}");
+            }
+            else
+            {
+                writeln("static const char* info() {");
+                    writetab();
+                    write("static const char* const info =");
+                    flush();
+                    indent();
+                    {
+                        SizeProbe probe(getFile(), node, "Info");
+                        Info info(this);
+                        const_cast<Interface*>(node)->accept(&info);
+                        info.flush();
+                    }
+                    write(";\n");
+                    unindent();
+                    writeln("return info;");
+                writeln("}");
+            }
 
             if (Interface* constructor = node->getConstructor())
             {
@@ -249,9 +284,29 @@ public:
             writetab();
             Cxx::setter(node);
             write(" = 0;\n");
+            if (useStringView() && getSetterSpec(node)->isString(node->getParent()))
+            {
+                writeStringSetters(node);
+            }
         }
     }
 
+    // Writes the overloads of the setter taking a string view or a C string,
+    // which copy the string just once into the string moved to the setter.
+    // The C string overload resolves the ambiguity between the other two.
+    void writeStringSetters(const Attribute* node)
+    {
+        std::string cap = node->getName();
+        cap[0] = toupper(cap[0]);
+        std::string name = getBufferName(node);
+        writeln("void set%s(%s %s) {", cap.c_str(), stringViewTypeName.c_str(), name.c_str());
+            writeln("set%s(%s(%s.data(), %s.size()));", cap.c_str(), stringTypeName.c_str(), name.c_str(), name.c_str());
+        writeln("}");
+        writeln("void set%s(const %s::value_type* %s) {", cap.c_str(), stringViewTypeName.c_str(), name.c_str());
+            writeln("set%s(%s(%s));", cap.c_str(), stringViewTypeName.c_str(), name.c_str());
+        writeln("}");
+    }
+
     virtual void at(const OpDcl* node)
     {
         writetab();
@@ -386,13 +441,13 @@ public:
     }
 };
 
-void printCxx(const char* source, const char* stringTypeName, const char* objectTypeName,
-              bool useExceptions, bool useVirtualBase, const char* indent)
+void printCxx(const char* source, const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName,
+              bool useExceptions, bool useVirtualBase, const char* indent, const StringPool* stringPool)
 {
     const std::string filename = getOutputFilename(source, "h");
-    printf("# %s\n", filename.c_str());
+    logOutput("# %s\n", filename.c_str());
 
-    FILE* file = fopen(filename.c_str(), "w");
+    FILE* file = openOutput(filename, source);
     if (!file)
     {
         return;
@@ -410,16 +465,559 @@ void printCxx(const char* source, const char* stringTypeName, const char* object
         fprintf(file, "\n");
     }
 
+    if (stringPool)
+    {
+        fprintf(file, "extern const char %s[];\n\n", stringPool->getName().c_str());
+    }
+
     if (!Node::getFlatNamespace())
     {
         Predeclaration predeclaration(source, file, indent);
         getSpecification()->accept(&predeclaration);
     }
 
-    CxxInterface cxx(source, file, stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent);
+    CxxInterface cxx(source, file, stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent, stringViewTypeName,
+                     stringPool);
     getSpecification()->accept(&cxx);
 
     fprintf(file, "#endif  // %s\n", included.c_str());
 
-    fclose(file);
+    closeOutput(file);
+}
+
+void buildStringPool(StringPool* stringPool, const std::vector<std::string>& sources)
+{
+    for (std::vector<std::string>::const_iterator i = sources.begin(); i != sources.end(); ++i)
+    {
+        StringPoolBuilder builder(stringPool, i->c_str());
+        getSpecification()->accept(&builder);
+    }
+    stringPool->build();
+}
+
+namespace
+{
+
+// Returns the outermost module enclosing node, or the specification for the
+// definitions in the global scope.
+const Node* getTopModule(const Node* node)
+{
+    const Node* top = getSpecification();
+    for (; node && node != getSpecification(); node = node->getParent())
+    {
+        if (isa<Module>(node))
+        {
+            top = node;
+        }
+    }
+    return top;
+}
+
+// Collects the outermost modules of the names referred from definitions.
+class ModuleImports : public Visitor
+{
+    const Node* currentNode;
+    std::set<const Node*>* modules;
+
+    void visitInterfaceElement(const Interface* interface, Node* element)
+    {
+        if (element->isInterface(interface))  // Do not process Constructor
+        {
+            return;
+        }
+        element->accept(this);
+    }
+
+public:
+    ModuleImports(std::set<const Node*>* modules) :
+        currentNode(getSpecification()),
+        modules(modules)
+    {
+    }
+
+    void collect(const Node* node)
+    {
+        currentNode = node->getParent();
+        const_cast<Node*>(node)->accept(this);
+    }
+
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const Type* node)
+    {
+    }
+
+    virtual void at(const ScopedName* node)
+    {
+        if (Node* resolved = resolve(currentNode, node->getName()))
+        {
+            if (resolved->getRank() == 1)
+            {
+                modules->insert(getTopModule(resolved));
+            }
+        }
+    }
+
+    virtual void at(const SequenceType* node)
+    {
+        node->getSpec()->accept(this);
+    }
+
+    virtual void at(const VariadicType* node)
+    {
+        node->getSpec()->accept(this);
+    }
+
+    virtual void at(const ArrayType* node)
+    {
+        node->getSpec()->accept(this);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        if (node->isLeaf())
+        {
+            return;
+        }
+        const Node* saved = currentNode;
+        currentNode = node->getParent();
+        visitChildren(node->getExtends());
+
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
+        {
+            currentNode = i->interface;
+            visitInterfaceElement(i->interface, i->node);
+        }
+
+        if (Interface* constructor = node->getConstructor())
+        {
+            currentNode = node;
+            for (NodeList::iterator i = constructor->begin(); i != constructor->end(); ++i)
+            {
+                visitInterfaceElement(node, *i);
+            }
+        }
+        currentNode = saved;
+    }
+
+    virtual void at(const Member* node)
+    {
+        node->getSpec()->accept(this);
+    }
+
+    virtual void at(const Attribute* node)
+    {
+        node->getSpec()->accept(this);
+    }
+
+    virtual void at(const ConstDcl* node)
+    {
+        node->getSpec()->accept(this);
+    }
+
+    virtual void at(const OpDcl* node)
+    {
+        node->getSpec()->accept(this);
+        visitChildren(node);
+    }
+
+    virtual void at(const ParamDcl* node)
+    {
+        node->getSpec()->accept(this);
+    }
+};
+
+// A module unit holds the definitions of one or more outermost modules
+// which depend on each other.
+struct ModuleUnit
+{
+    std::vector<const Node*> modules;           // in the order of definition
+    std::vector<const Node*> definitions;       // in the order to be printed
+    std::set<const ModuleUnit*> imports;
+
+    std::string getName() const
+    {
+        return getModuleUnitName(modules.front());
+    }
+
+    static std::string getModuleUnitName(const Node* module)
+    {
+        return (module == getSpecification()) ? "global" : module->getName();
+    }
+};
+
+// Collects the definitions in module and in the modules nested in it. A
+// file included by another one listed on the command line is parsed twice,
+// and two files can define the same interface; only the first definition
+// of each qualified name is collected, as a unit can define a name once.
+void collectDefinitions(const Node* module, std::vector<const Node*>* definitions,
+                        std::set<std::string>* defined)
+{
+    if (module->isLeaf())
+    {
+        return;
+    }
+    for (NodeList::iterator i = module->begin(); i != module->end(); ++i)
+    {
+        if (isa<Module>(*i))
+        {
+            collectDefinitions(*i, definitions, defined);
+        }
+        else if (isa<Include>(*i) || isa<Implements>(*i))
+        {
+            continue;
+        }
+        else if ((*i)->isDefinedIn(0) && !(*i)->isNative(module->getParent()))
+        {
+            // A forward declaration does not define the name.
+            if (isa<Interface>(*i) && (*i)->isLeaf())
+            {
+                definitions->push_back(*i);
+            }
+            else if (defined->insert((*i)->getQualifiedName()).second)
+            {
+                definitions->push_back(*i);
+            }
+        }
+    }
+}
+
+// Finds the strongly connected components of the module graph by Tarjan's
+// algorithm. The components are found in the reverse topological order,
+// i.e., each component after the components it depends on.
+class ModuleGraph
+{
+    const std::vector<const Node*>& modules;    // in the order of definition
+    const std::map<const Node*, std::set<const Node*> >& edges;
+    std::map<const Node*, unsigned> index;
+    std::map<const Node*, unsigned> lowLink;
+    std::vector<const Node*> stack;
+    std::set<const Node*> onStack;
+    std::vector<std::vector<const Node*> > components;
+
+    void connect(const Node* module)
+    {
+        unsigned n = index.size();
+        index[module] = lowLink[module] = n;
+        stack.push_back(module);
+        onStack.insert(module);
+        std::map<const Node*, std::set<const Node*> >::const_iterator found = edges.find(module);
+        if (found != edges.end())
+        {
+            // Follow the edges in the order of definition so that the
+            // result does not depend on the addresses of the nodes.
+            for (std::vector<const Node*>::const_iterator i = modules.begin(); i != modules.end(); ++i)
+            {
+                if (!found->second.count(*i))
+                {
+                    continue;
+                }
+                if (index.find(*i) == index.end())
+                {
+                    connect(*i);
+                    lowLink[module] = std::min(lowLink[module], lowLink[*i]);
+                }
+                else if (onStack.count(*i))
+                {
+                    lowLink[module] = std::min(lowLink[module], index[*i]);
+                }
+            }
+        }
+        if (lowLink[module] == index[module])
+        {
+            std::vector<const Node*> component;
+            const Node* top;
+            do
+            {
+                top = stack.back();
+                stack.pop_back();
+                onStack.erase(top);
+                component.push_back(top);
+            } while (top != module);
+            components.push_back(component);
+        }
+    }
+
+public:
+    ModuleGraph(const std::vector<const Node*>& modules, const std::map<const Node*, std::set<const Node*> >& edges) :
+        modules(modules),
+        edges(edges)
+    {
+    }
+
+    const std::vector<std::vector<const Node*> >& getComponents()
+    {
+        for (std::vector<const Node*>::const_iterator i = modules.begin(); i != modules.end(); ++i)
+        {
+            if (index.find(*i) == index.end())
+            {
+                connect(*i);
+            }
+        }
+        return components;
+    }
+};
+
+// Sorts the definitions of a unit so that every base interface is defined
+// before the interfaces derived from it.
+void sortDefinition(const Node* node, const std::set<const Node*>& definitions,
+                    std::set<const Node*>* sorted, std::vector<const Node*>* order)
+{
+    if (sorted->count(node))
+    {
+        return;
+    }
+    sorted->insert(node);
+    if (const Interface* interface = dyn_cast<Interface>(node))
+    {
+        if (Node* extends = interface->getExtends())
+        {
+            for (NodeList::iterator i = extends->begin(); i != extends->end(); ++i)
+            {
+                Node* base = static_cast<ScopedName*>(*i)->search(interface->getParent());
+                if (base && definitions.count(base))
+                {
+                    sortDefinition(base, definitions, sorted, order);
+                }
+            }
+        }
+    }
+    order->push_back(node);
+}
+
+// Prints the namespace of module and of the modules enclosing it.
+void printNamespace(Formatter* formatter, const Node* module)
+{
+    if (!module || module == getSpecification())
+    {
+        return;
+    }
+    printNamespace(formatter, module->getParent());
+    formatter->writeln("namespace %s {", module->getName().c_str());
+}
+
+void closeNamespace(Formatter* formatter, const Node* module)
+{
+    for (; module && module != getSpecification(); module = module->getParent())
+    {
+        formatter->writeln("}");
+    }
+}
+
+void printModuleUnit(const ModuleUnit* unit, const char* stringTypeName, const char* stringViewTypeName,
+                     const char* objectTypeName, bool useVirtualBase, const char* indent, const char* prelude)
+{
+    const std::string filename = getOutputFilename(unit->getName(), "cppm");
+    logOutput("# %s\n", filename.c_str());
+
+    FILE* file = openOutput(filename);
+    if (!file)
+    {
+        return;
+    }
+
+    fprintf(file, "// Generated by esidl %s.\n\n", PACKAGE_VERSION);
+    if (*prelude)
+    {
+        fprintf(file, "module;\n\n");
+        fprintf(file, "#include \"%s\"\n\n", prelude);
+    }
+    fprintf(file, "export module %s;\n\n", unit->getName().c_str());
+    if (!unit->imports.empty())
+    {
+        for (std::set<const ModuleUnit*>::const_iterator i = unit->imports.begin(); i != unit->imports.end(); ++i)
+        {
+            fprintf(file, "import %s;\n", (*i)->getName().c_str());
+        }
+        fprintf(file, "\n");
+    }
+
+    // Dynamic exception specifications are not allowed in C++17 and later.
+    CxxInterface cxx(0, file, stringTypeName, objectTypeName, false, useVirtualBase, indent, stringViewTypeName);
+    cxx.writeln("export {");
+
+    // Declare the interfaces first so that they can refer to each other.
+    std::vector<const Node*> scopes;
+    std::map<const Node*, std::vector<const Interface*> > declarations;
+    for (std::vector<const Node*>::const_iterator i = unit->definitions.begin(); i != unit->definitions.end(); ++i)
+    {
+        const Interface* interface = dyn_cast<Interface>(*i);
+        if (!interface || (interface->getAttr() & Interface::Supplemental))
+        {
+            continue;
+        }
+        std::vector<const Interface*>& list = declarations[interface->getParent()];
+        if (list.empty())
+        {
+            scopes.push_back(interface->getParent());
+        }
+        // A forward declaration and the definition share the name.
+        std::vector<const Interface*>::const_iterator j;
+        for (j = list.begin(); j != list.end(); ++j)
+        {
+            if ((*j)->getName() == interface->getName())
+            {
+                break;
+            }
+        }
+        if (j == list.end())
+        {
+            list.push_back(interface);
+        }
+    }
+    for (std::vector<const Node*>::const_iterator i = scopes.begin(); i != scopes.end(); ++i)
+    {
+        printNamespace(&cxx, *i);
+        const std::vector<const Interface*>& list = declarations[*i];
+        for (std::vector<const Interface*>::const_iterator j = list.begin(); j != list.end(); ++j)
+        {
+            cxx.writeln("class %s;", (*j)->getName().c_str());
+        }
+        closeNamespace(&cxx, *i);
+    }
+
+    const Node* module = 0;
+    for (std::vector<const Node*>::const_iterator i = unit->definitions.begin(); i != unit->definitions.end(); ++i)
+    {
+        if (isa<Interface>(*i) && (*i)->isLeaf())
+        {
+            continue;   // forward declarations are predeclared above
+        }
+        if ((*i)->getParent() != module)
+        {
+            closeNamespace(&cxx, module);
+            module = (*i)->getParent();
+            printNamespace(&cxx, module);
+        }
+        cxx.printDefinition(*i);
+    }
+    closeNamespace(&cxx, module);
+
+    cxx.writeln("}");
+    cxx.flush();
+
+    closeOutput(file);
+}
+
+void printModuleAlias(const Node* module, const ModuleUnit* unit)
+{
+    const std::string filename = getOutputFilename(ModuleUnit::getModuleUnitName(module), "cppm");
+    logOutput("# %s\n", filename.c_str());
+
+    FILE* file = openOutput(filename);
+    if (!file)
+    {
+        return;
+    }
+
+    fprintf(file, "// Generated by esidl %s.\n\n", PACKAGE_VERSION);
+    fprintf(file, "// '%s' depends on '%s' and vice versa; both are defined in '%s'.\n\n",
+            ModuleUnit::getModuleUnitName(module).c_str(), unit->getName().c_str(), unit->getName().c_str());
+    fprintf(file, "export module %s;\n\n", ModuleUnit::getModuleUnitName(module).c_str());
+    fprintf(file, "export import %s;\n", unit->getName().c_str());
+
+    closeOutput(file);
+}
+
+}  // namespace
+
+int printCxxModules(const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName,
+                    bool useVirtualBase, const char* indent, const char* prelude)
+{
+    // Collect the definitions by their outermost modules.
+    std::vector<const Node*> modules;
+    std::map<const Node*, std::vector<const Node*> > definitions;
+    std::vector<const Node*> all;
+    std::set<std::string> defined;
+    collectDefinitions(getSpecification(), &all, &defined);
+    for (std::vector<const Node*>::const_iterator i = all.begin(); i != all.end(); ++i)
+    {
+        const Node* module = getTopModule(*i);
+        if (definitions.find(module) == definitions.end())
+        {
+            modules.push_back(module);
+        }
+        definitions[module].push_back(*i);
+    }
+
+    // Build the module graph from the names the definitions refer to.
+    std::map<const Node*, std::set<const Node*> > edges;
+    for (std::vector<const Node*>::const_iterator i = modules.begin(); i != modules.end(); ++i)
+    {
+        std::set<const Node*> imports;
+        ModuleImports collector(&imports);
+        const std::vector<const Node*>& list = definitions[*i];
+        for (std::vector<const Node*>::const_iterator j = list.begin(); j != list.end(); ++j)
+        {
+            collector.collect(*j);
+        }
+        for (std::set<const Node*>::const_iterator j = imports.begin(); j != imports.end(); ++j)
+        {
+            if (*j != *i && definitions.find(*j) != definitions.end())
+            {
+                edges[*i].insert(*j);
+            }
+        }
+    }
+
+    // Each strongly connected component of the graph becomes a unit, which
+    // is printed after the units it imports.
+    ModuleGraph graph(modules, edges);
+    const std::vector<std::vector<const Node*> >& components = graph.getComponents();
+    std::vector<ModuleUnit> units(components.size());
+    std::map<const Node*, ModuleUnit*> unitOf;
+    for (size_t i = 0; i < components.size(); ++i)
+    {
+        ModuleUnit& unit = units[i];
+        std::set<const Node*> members(components[i].begin(), components[i].end());
+        std::vector<const Node*> list;
+        for (std::vector<const Node*>::const_iterator j = modules.begin(); j != modules.end(); ++j)
+        {
+            if (members.count(*j))
+            {
+                unit.modules.push_back(*j);
+                unitOf[*j] = &unit;
+                list.insert(list.end(), definitions[*j].begin(), definitions[*j].end());
+            }
+        }
+        std::set<const Node*> listed(list.begin(), list.end());
+        std::set<const Node*> sorted;
+        for (std::vector<const Node*>::const_iterator j = list.begin(); j != list.end(); ++j)
+        {
+            sortDefinition(*j, listed, &sorted, &unit.definitions);
+        }
+    }
+    for (std::map<const Node*, std::set<const Node*> >::const_iterator i = edges.begin(); i != edges.end(); ++i)
+    {
+        for (std::set<const Node*>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+        {
+            if (unitOf[i->first] != unitOf[*j])
+            {
+                unitOf[i->first]->imports.insert(unitOf[*j]);
+            }
+        }
+    }
+
+    FILE* order = openOutput("modules.txt");
+    if (!order)
+    {
+        return EXIT_FAILURE;
+    }
+    logOutput("# modules.txt\n");
+    for (std::vector<ModuleUnit>::const_iterator i = units.begin(); i != units.end(); ++i)
+    {
+        printModuleUnit(&*i, stringTypeName, stringViewTypeName, objectTypeName, useVirtualBase, indent, prelude);
+        fprintf(order, "%s\n", getOutputFilename(i->getName(), "cppm").c_str());
+        for (std::vector<const Node*>::const_iterator j = i->modules.begin() + 1; j != i->modules.end(); ++j)
+        {
+            printModuleAlias(*j, &*i);
+            fprintf(order, "%s\n", getOutputFilename(ModuleUnit::getModuleUnitName(*j), "cppm").c_str());
+        }
+    }
+    closeOutput(order);
+    return EXIT_SUCCESS;
 }
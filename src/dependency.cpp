@@ -0,0 +1,236 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dependency.h"
+
+#include <list>
+
+namespace
+{
+
+// Adds every interface definition in the specification to the graph.
+class CollectInterfaces : public Visitor
+{
+    DependencyGraph* graph;
+
+public:
+    CollectInterfaces(DependencyGraph* graph) :
+        graph(graph)
+    {
+    }
+
+    virtual void at(const Node* node)
+    {
+        visitChildren(node);
+    }
+
+    virtual void at(const StructType* node)
+    {
+    }
+
+    virtual void at(const Interface* node)
+    {
+        if (node->isLeaf())
+        {
+            return;
+        }
+        graph->add(node);
+
+        // Process constructors.
+        for (NodeList::iterator i = node->begin(); i != node->end(); ++i)
+        {
+            if (Interface* interface = dyn_cast<Interface>(*i))
+            {
+                at(interface);
+            }
+        }
+    }
+};
+
+}  // namespace
+
+void DependencyGraph::clear()
+{
+    interfaces.clear();
+    dependencies.clear();
+    dependents.clear();
+}
+
+void DependencyGraph::add(const Interface* interface)
+{
+    interfaces.push_back(interface);
+}
+
+void DependencyGraph::addEdge(const Interface* from, const Interface* to, Kind kind)
+{
+    if (!from || !to || from == to)
+    {
+        return;
+    }
+    dependencies[from][to] |= kind;
+    dependents[to][from] |= kind;
+}
+
+void DependencyGraph::addUses(const Interface* interface, const Node* spec, const Node* scope)
+{
+    if (!spec)
+    {
+        return;
+    }
+    if (const ScopedName* name = dyn_cast<ScopedName>(spec))
+    {
+        // ScopedName::search() resolves typedefs as well.
+        Node* resolved = name->search(scope);
+        if (Interface* used = dyn_cast<Interface>(resolved))
+        {
+            addEdge(interface, used, Uses);
+        }
+        else if (resolved && resolved != spec && !dyn_cast<ScopedName>(resolved))
+        {
+            addUses(interface, resolved, resolved->getParent() ? resolved->getParent() : scope);
+        }
+    }
+    else if (const SequenceType* sequence = dyn_cast<SequenceType>(spec))
+    {
+        addUses(interface, sequence->getSpec(), scope);
+    }
+    else if (const ArrayType* array = dyn_cast<ArrayType>(spec))
+    {
+        addUses(interface, array->getSpec(), scope);
+    }
+    else if (const VariadicType* variadic = dyn_cast<VariadicType>(spec))
+    {
+        addUses(interface, variadic->getSpec(), scope);
+    }
+    else if (dyn_cast<UnionType>(spec) && !spec->isLeaf())
+    {
+        for (NodeList::iterator i = spec->begin(); i != spec->end(); ++i)
+        {
+            addUses(interface, *i, scope);
+        }
+    }
+}
+
+void DependencyGraph::build(Node* specification)
+{
+    clear();
+    CollectInterfaces collectInterfaces(this);
+    specification->accept(&collectInterfaces);
+
+    for (std::vector<const Interface*>::const_iterator i = interfaces.begin(); i != interfaces.end(); ++i)
+    {
+        const Interface* interface = *i;
+        if (Node* extends = interface->getExtends())
+        {
+            for (NodeList::iterator j = extends->begin(); j != extends->end(); ++j)
+            {
+                Node* base = static_cast<ScopedName*>(*j)->search(interface->getParent());
+                addEdge(interface, dyn_cast<Interface>(base), Extends);
+            }
+        }
+        for (std::list<const Interface*>::const_iterator j = interface->getImplements()->begin();
+             j != interface->getImplements()->end();
+             ++j)
+        {
+            addEdge(interface, *j, Implements);
+        }
+        for (std::list<const Interface*>::const_iterator j = interface->getSupplementals()->begin();
+             j != interface->getSupplementals()->end();
+             ++j)
+        {
+            addEdge(interface, *j, Supplemental);
+        }
+        for (NodeList::iterator j = interface->begin(); j != interface->end(); ++j)
+        {
+            Member* member = dyn_cast<Member>(*j);
+            if (!member)
+            {
+                continue;
+            }
+            addUses(interface, member->getSpec(), interface);
+            if (dyn_cast<OpDcl>(member) && !member->isLeaf())
+            {
+                for (NodeList::iterator k = member->begin(); k != member->end(); ++k)
+                {
+                    if (ParamDcl* param = dyn_cast<ParamDcl>(*k))
+                    {
+                        addUses(interface, param->getSpec(), interface);
+                    }
+                }
+            }
+        }
+    }
+}
+
+const DependencyGraph::Edges* DependencyGraph::getDependencies(const Interface* interface) const
+{
+    std::map<const Interface*, Edges>::const_iterator found = dependencies.find(interface);
+    return (found != dependencies.end()) ? &found->second : 0;
+}
+
+const DependencyGraph::Edges* DependencyGraph::getDependents(const Interface* interface) const
+{
+    std::map<const Interface*, Edges>::const_iterator found = dependents.find(interface);
+    return (found != dependents.end()) ? &found->second : 0;
+}
+
+const Interface* DependencyGraph::find(const std::string& name) const
+{
+    bool qualified = (name.compare(0, 2, "::") == 0);
+    for (std::vector<const Interface*>::const_reverse_iterator i = interfaces.rbegin(); i != interfaces.rend(); ++i)
+    {
+        if (qualified ? ((*i)->getQualifiedName() == name) : ((*i)->getName() == name))
+        {
+            return *i;
+        }
+    }
+    return 0;
+}
+
+void DependencyGraph::getImpact(const Interface* interface, std::set<const Interface*>* impact) const
+{
+    std::list<const Interface*> queue;
+    if (impact->insert(interface).second)
+    {
+        queue.push_back(interface);
+    }
+    std::set<const Interface*> users;
+    while (!queue.empty())
+    {
+        const Interface* changed = queue.front();
+        queue.pop_front();
+        const Edges* edges = getDependents(changed);
+        if (!edges)
+        {
+            continue;
+        }
+        for (Edges::const_iterator i = edges->begin(); i != edges->end(); ++i)
+        {
+            if (i->second & (Extends | Implements | Supplemental))
+            {
+                if (impact->insert(i->first).second)
+                {
+                    queue.push_back(i->first);
+                }
+            }
+            else
+            {
+                users.insert(i->first);
+            }
+        }
+    }
+    impact->insert(users.begin(), users.end());
+}
@@ -16,58 +16,144 @@
  * limitations under the License.
  */
 
-#include "esidl.h"
-#include "meta.h"
-#include "sheet.h"
+#include "compiler.h"
+#include "watcher.h"
 
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace
 {
-    std::string baseFilename;
-    std::string filename;
+
+// The targets sharing the options resolve() depends on are generated from
+// the IDL files parsed once.
+enum Group
+{
+    CxxGroup,
+    MessengerGroup,
+    JavaGroup
+};
+
+Group getGroup(Compiler::Target target)
+{
+    switch (target)
+    {
+    case Compiler::MessengerTarget:
+    case Compiler::MessengerSrcTarget:
+    case Compiler::MessengerImpTarget:
+    case Compiler::MessengerImpSrcTarget:
+        return MessengerGroup;
+    case Compiler::JavaTarget:
+    case Compiler::SheetTarget:
+        return JavaGroup;
+    default:
+        return CxxGroup;
+    }
 }
 
-const std::string getBaseFilename()
+Compiler::Options getOptions(Compiler::Options options, Group group)
 {
-    return baseFilename;
+    switch (group)
+    {
+    case MessengerGroup:
+        // Multiple inheritance is not allowed in Web IDL.
+        options.useMultipleInheritance = false;
+        break;
+    case JavaGroup:
+        options.ctorScope = "_";
+        break;
+    default:
+        break;
+    }
+    return options;
 }
 
-void setBaseFilename(const char* name)
+bool hasCxxTarget(const Compiler::Jobs& jobs)
 {
-    baseFilename = name;
-    if (baseFilename[0] == '"')
+    for (Compiler::Jobs::const_iterator i = jobs.begin(); i != jobs.end(); ++i)
     {
-        baseFilename = baseFilename.substr(1, baseFilename.length() - 2);
+        if (i->target == Compiler::CxxTarget)
+        {
+            return true;
+        }
     }
-    setFilename(name);
+    return false;
 }
 
-const std::string getFilename()
+// Generates the jobs of a group over the IDL files parsed once, each job on
+// its own thread; see Compiler::generate(Jobs*).
+bool generate(const Compiler::Options& options, const std::vector<std::string>& files,
+              Group group, Compiler::Jobs* jobs, bool stats)
 {
-    return filename;
+    Compiler compiler(getOptions(options, group));
+    bool succeeded = compiler.parse(files) && compiler.resolve() && compiler.generate(jobs);
+    if (stats)
+    {
+        fflush(stdout);
+        compiler.printStatistics(stderr);
+    }
+    return succeeded;
 }
 
-void setFilename(const char* name)
+// Generates the jobs grouped by the options resolve() depends on, one group
+// after another in this process, each from the IDL files parsed again. As
+// the C++ target adds the forward declarations to the parsed files, every
+// group has at most one C++ target.
+bool generate(const Compiler::Options& options, const std::vector<std::string>& files,
+              const Compiler::Jobs& jobs, bool stats)
 {
-    filename = name;
-    if (filename == "\"<stdin>\"")
+    std::vector<std::pair<Group, Compiler::Jobs> > groups;
+    for (Compiler::Jobs::const_iterator i = jobs.begin(); i != jobs.end(); ++i)
+    {
+        std::vector<std::pair<Group, Compiler::Jobs> >::iterator group;
+        for (group = groups.begin(); group != groups.end(); ++group)
+        {
+            if (group->first == getGroup(i->target) &&
+                (i->target != Compiler::CxxTarget || !hasCxxTarget(group->second)))
+            {
+                break;
+            }
+        }
+        if (group == groups.end())
+        {
+            group = groups.insert(groups.end(), std::make_pair(getGroup(i->target), Compiler::Jobs()));
+        }
+        group->second.push_back(*i);
+    }
+
+    // With several groups, the statistics of the groups are printed as a
+    // JSON array, so that stderr still holds a single JSON document.
+    bool array = stats && 1 < groups.size();
+    if (array)
     {
-        filename = getBaseFilename();
+        fprintf(stderr, "[\n");
+    }
+    bool succeeded = true;
+    for (std::vector<std::pair<Group, Compiler::Jobs> >::iterator i = groups.begin(); i != groups.end(); ++i)
+    {
+        if (array && i != groups.begin())
+        {
+            fprintf(stderr, ",\n");
+        }
+        if (!generate(options, files, i->first, &i->second, stats))
+        {
+            succeeded = false;
+        }
     }
-    else if (filename[0] == '"')
+    if (array)
     {
-        filename = filename.substr(1, filename.length() - 2);
+        fprintf(stderr, "]\n");
     }
+    return succeeded;
 }
 
+}  // namespace
+
 int main(int argc, char* argv[])
 {
     if (argc < 2)
@@ -75,32 +161,16 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    // Construct cpp options
-    const char** argCpp = static_cast<const char**>(malloc(sizeof(char*) * (argc + 2)));
-    if (!argCpp)
-    {
-        return EXIT_FAILURE;
-    }
-
-    int optCpp = 0;
-    argCpp[optCpp++] = "cpp";
-    argCpp[optCpp++] = "-C";  // Use -C for cpp by default.
+    Compiler::Options options;
+    std::vector<std::string> files;
 
-    bool skeleton = false;
-    bool generic = false;
-    bool isystem = false;
-    bool useExceptions = true;
-    bool useVirtualBase = false;
-    bool useMultipleInheritance = true;
-    bool messenger = false;
-    bool messengerSrc = false;
-    bool messengerImp = false;
-    bool messengerImpSrc = false;
-    bool java = false;
-    bool sheet = false;
-    const char* stringTypeName = "char*";   // C++ string type name to be used
-    const char* objectTypeName = "Object";  // C++ object type name to be used
-    const char* indent = "es";
+    Compiler::Jobs jobs;            // in the order specified
+    std::string outputRoot;         // for the targets without their own -o
+    bool watch = false;
+    bool stats = false;
+    bool includeReport = false;
+    bool sizeReport = false;
+    const char* impact = 0;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -108,112 +178,214 @@ int main(int argc, char* argv[])
         {
             if (argv[i][1] == 'I')
             {
-                argCpp[optCpp++] = argv[i];
+                options.cppOptions.push_back(argv[i]);
                 if (argv[i][2] == '\0')
                 {
                     ++i;
-                    argCpp[optCpp++] = argv[i];
-                    setIncludePath(argv[i]);
+                    options.cppOptions.push_back(argv[i]);
+                    options.includePath = argv[i];
                 }
                 else
                 {
-                    setIncludePath(&argv[i][2]);
+                    options.includePath = &argv[i][2];
                 }
             }
+            else if (strcmp(argv[i], "-cxx") == 0)
+            {
+                jobs.push_back(Compiler::Job(Compiler::CxxTarget));
+            }
             else if (strcmp(argv[i], "-messenger") == 0)
             {
-                messenger = true;
+                jobs.push_back(Compiler::Job(Compiler::MessengerTarget));
             }
             else if (strcmp(argv[i], "-messenger-src") == 0)
             {
-                messengerSrc = true;
+                jobs.push_back(Compiler::Job(Compiler::MessengerSrcTarget));
             }
             else if (strcmp(argv[i], "-messenger-imp") == 0)
             {
-                messengerImp = true;
+                jobs.push_back(Compiler::Job(Compiler::MessengerImpTarget));
             }
             else if (strcmp(argv[i], "-messenger-imp-src") == 0)
             {
-                messengerImpSrc = true;
+                jobs.push_back(Compiler::Job(Compiler::MessengerImpSrcTarget));
             }
             else if (strcmp(argv[i], "-fexceptions") == 0)
             {
-                useExceptions = true;
+                options.useExceptions = true;
             }
             else if (strcmp(argv[i], "-fno-exceptions") == 0)
             {
-                useExceptions = false;
+                options.useExceptions = false;
+            }
+            else if (strcmp(argv[i], "-fmove") == 0)
+            {
+                options.useMove = true;
+            }
+            else if (strcmp(argv[i], "-fno-move") == 0)
+            {
+                options.useMove = false;
+            }
+            else if (strcmp(argv[i], "-fdispatch-table") == 0)
+            {
+                options.useDispatchTable = true;
+            }
+            else if (strcmp(argv[i], "-fno-dispatch-table") == 0)
+            {
+                options.useDispatchTable = false;
+            }
+            else if (strcmp(argv[i], "-fmember-table") == 0)
+            {
+                options.useMemberTable = true;
+            }
+            else if (strcmp(argv[i], "-fno-member-table") == 0)
+            {
+                options.useMemberTable = false;
+            }
+            else if (strcmp(argv[i], "-fminimal-includes") == 0)
+            {
+                options.useMinimalIncludes = true;
+            }
+            else if (strcmp(argv[i], "-fno-minimal-includes") == 0)
+            {
+                options.useMinimalIncludes = false;
             }
             else if (strcmp(argv[i], "-fvirtualbase") == 0)
             {
-                useVirtualBase = true;
+                options.useVirtualBase = true;
             }
             else if (strcmp(argv[i], "-fno-virtualbase") == 0)
             {
-                useVirtualBase = false;
+                options.useVirtualBase = false;
             }
             else if (strcmp(argv[i], "-fmultipleinheritance") == 0)
             {
-                useMultipleInheritance = true;
+                options.useMultipleInheritance = true;
             }
             else if (strcmp(argv[i], "-fno-multipleinheritance") == 0)
             {
-                useMultipleInheritance = false;
+                options.useMultipleInheritance = false;
             }
             else if (strcmp(argv[i], "-include") == 0)
             {
-                argCpp[optCpp++] = argv[i];
+                options.cppOptions.push_back(argv[i]);
                 ++i;
-                argCpp[optCpp++] = argv[i];
+                options.cppOptions.push_back(argv[i]);
             }
             else if (strcmp(argv[i], "-indent") == 0)
             {
                 ++i;
-                indent = argv[i];
+                options.indent = argv[i];
             }
             else if (strcmp(argv[i], "-isystem") == 0)
             {
-                argCpp[optCpp++] = argv[i];
+                options.cppOptions.push_back(argv[i]);
                 ++i;
-                argCpp[optCpp++] = argv[i];
-                setIncludePath(argv[i]);
-                isystem = true;
+                options.cppOptions.push_back(argv[i]);
+                options.includePath = argv[i];
+                options.isystem = true;
             }
             else if (strcmp(argv[i], "-java") == 0)
             {
-                java = true;
+                jobs.push_back(Compiler::Job(Compiler::JavaTarget));
+            }
+            else if (strcmp(argv[i], "-cxx-module") == 0)
+            {
+                jobs.push_back(Compiler::Job(Compiler::CxxModuleTarget));
+            }
+            else if (strcmp(argv[i], "-module-prelude") == 0)
+            {
+                ++i;
+                options.modulePrelude = argv[i];
             }
             else if (strcmp(argv[i], "-namespace") == 0)
             {
                 ++i;
-                Node::setFlatNamespace(argv[i]);
+                options.namespaceName = argv[i];
+            }
+            else if (strcmp(argv[i], "-o") == 0)
+            {
+                ++i;
+                if (jobs.empty())
+                {
+                    outputRoot = argv[i];
+                }
+                else
+                {
+                    jobs.back().outputRoot = argv[i];
+                }
             }
             else if (strcmp(argv[i], "-object") == 0)
             {
                 ++i;
-                objectTypeName = argv[i];
+                options.objectTypeName = argv[i];
             }
             else if (strcmp(argv[i], "-prefix") == 0)
             {
                 ++i;
-                Node::setDefaultPrefix(argv[i]);
+                options.prefix = argv[i];
             }
             else if (strcmp(argv[i], "-template") == 0)
             {
-                generic = true;
+                options.generic = true;
             }
             else if (strcmp(argv[i], "-sheet") == 0)
             {
-                sheet = true;
+                jobs.push_back(Compiler::Job(Compiler::SheetTarget));
             }
             else if (strcmp(argv[i], "-skeleton") == 0)
             {
-                skeleton = true;
+                options.skeleton = true;
+            }
+            else if (strcmp(argv[i], "-span") == 0)
+            {
+                options.useSpan = true;
+            }
+            else if (strcmp(argv[i], "-unity") == 0)
+            {
+                ++i;
+                options.unitySize = atoi(argv[i]);
             }
             else if (strcmp(argv[i], "-string") == 0)
             {
                 ++i;
-                stringTypeName = argv[i];
+                options.stringTypeName = argv[i];
+            }
+            else if (strcmp(argv[i], "-string-view") == 0)
+            {
+                ++i;
+                options.stringViewTypeName = argv[i];
+            }
+            else if (strcmp(argv[i], "-string-pool") == 0)
+            {
+                ++i;
+                options.stringPoolName = argv[i];
+            }
+            else if (strcmp(argv[i], "--impact") == 0)
+            {
+                ++i;
+                impact = argv[i];
+            }
+            else if (strcmp(argv[i], "--include-report") == 0)
+            {
+                includeReport = true;
+            }
+            else if (strcmp(argv[i], "--keep-unchanged") == 0)
+            {
+                options.keepUnchanged = true;
+            }
+            else if (strcmp(argv[i], "--size-report") == 0)
+            {
+                sizeReport = true;
+                options.collectSizes = true;
+            }
+            else if (strcmp(argv[i], "--stats") == 0)
+            {
+                stats = true;
+            }
+            else if (strcmp(argv[i], "--watch") == 0)
+            {
+                watch = true;
             }
             else if (strcmp(argv[i], "--help") == 0)
             {
@@ -226,209 +398,102 @@ int main(int argc, char* argv[])
                 return 0;
             }
         }
+        else
+        {
+            files.push_back(argv[i]);
+        }
     }
 
-    if (messenger || messengerSrc || messengerImp || messengerImpSrc)
+    // The dispatch table casts the pointers to the members of the
+    // implementation classes to those of Imp, which is ill-formed through
+    // a virtual base class.
+    if (options.useDispatchTable && options.useVirtualBase)
     {
-        // Multiple inheritance is not allowed in Web IDL.
-        useMultipleInheritance = false;
+        fprintf(stderr, "esidl: -fdispatch-table cannot be used with -fvirtualbase\n");
+        return EXIT_FAILURE;
     }
 
-    argCpp[optCpp] = 0;
-
-    // Set up the global module
-    Module* node = new Module("");
-    setSpecification(node);
-    setCurrent(node);
-
-    // Manually install 'object' interface forward declaration.
-    Interface* object = new Interface("object", 0, true);
-    object->setRank(2);
-    getCurrent()->add(object);
-
-    if (Node::getFlatNamespace())
+    if (jobs.empty())
     {
-        Module* module = new Module(Node::getFlatNamespace());
-        getCurrent()->add(module);
-        setCurrent(module);
+        jobs.push_back(Compiler::Job(Compiler::CxxTarget));
     }
-
-    // Load every IDL file at once
-    int result = EXIT_SUCCESS;
-    int cppStream[2];
-    pipe(cppStream);
-    pid_t id = fork();
-    if (id == 0)
+    for (Compiler::Jobs::iterator i = jobs.begin(); i != jobs.end(); ++i)
     {
-        // Child process
-        int catStream[2];
-        pipe(catStream);
-        pid_t id = fork();
-        if (id == 0)
-        {
-            // cat every IDL file
-            close(catStream[0]);
-            FILE* out = fdopen(catStream[1], "w");
-            for (int i = 1; i < argc; ++i)
-            {
-                if (argv[i][0] == '-')
-                {
-                    if (strcmp(argv[i], "-I") == 0 ||
-                        strcmp(argv[i], "-include") == 0 ||
-                        strcmp(argv[i], "-indent") == 0 ||
-                        strcmp(argv[i], "-isystem") == 0 ||
-                        strcmp(argv[i], "-namespace") == 0 ||
-                        strcmp(argv[i], "-object") == 0 ||
-                        strcmp(argv[i], "-prefix") == 0 ||
-                        strcmp(argv[i], "-string") == 0)
-                    {
-                        ++i;
-                    }
-                    continue;
-                }
-
-                if (const char* dot = strrchr(argv[i], '.'))
-                {
-                    if (strcasecmp(dot + 1, "idl"))
-                    {
-                        continue;
-                    }
-                }
-
-                FILE* in = fopen(argv[i], "r");
-                if (!in)
-                {
-                    return EXIT_FAILURE;
-                }
-
-                fprintf(out, "#pragma source \"%s\"\n", argv[i]);
-                int ch;
-                while ((ch = fgetc(in)) != EOF)
-                {
-                    putc(ch, out);
-                }
-                fclose(in);
-            }
-            fclose(out);
-            return EXIT_SUCCESS;
-        }
-        else if (0 < id)
-        {
-            // execute cpp
-            close(0);
-            dup(catStream[0]);
-            close(catStream[0]);
-            close(catStream[1]);
-            close(1);
-            dup(cppStream[1]);
-            close(cppStream[0]);
-            close(cppStream[1]);
-            execvp(argCpp[0], const_cast<char**>(argCpp));
-            return EXIT_FAILURE;
-        }
-        else
+        if (i->outputRoot.empty())
         {
-            return EXIT_FAILURE;
+            i->outputRoot = outputRoot;
         }
     }
-    else if (0 < id)
+
+    if (1 < jobs.size())
     {
-        // Parent process - process an IDL file
-        close(cppStream[1]);
-        if (input(cppStream[0], isystem, useExceptions, stringTypeName) != EXIT_SUCCESS)
+        if (watch || impact || includeReport || sizeReport)
         {
+            fprintf(stderr, "esidl: %s takes a single target\n",
+                    watch ? "--watch" : impact ? "--impact" : includeReport ? "--include-report" : "--size-report");
             return EXIT_FAILURE;
         }
-        close(cppStream[0]);
-
-        int status;
-        while (wait(&status) != id)
-        {
-        }
-        if (result == EXIT_SUCCESS)
-        {
-            if (!WIFEXITED(status))
-            {
-                result = EXIT_FAILURE;
-            }
-            else
-            {
-                result = WEXITSTATUS(status);
-            }
-        }
-    }
-    else
-    {
-        return EXIT_FAILURE;
+        return generate(options, files, jobs, stats) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    setBaseFilename("");
+    Compiler::Target target = jobs.front().target;
+    options = getOptions(options, getGroup(target));
+    options.outputRoot = jobs.front().outputRoot;
 
-    if (java || sheet)
+    if (watch)
     {
-        Node::setCtorScope("_");
+        Watcher watcher(options, files, target);
+        return watcher.run();
     }
 
-    Interface::useMultipleInheritance = useMultipleInheritance;
-
-    ProcessExtendedAttributes processExtendedAttributes;
-    getSpecification()->accept(&processExtendedAttributes);
-
-    AdjustMethodCount adjustMethodCount(!useMultipleInheritance || Node::getFlatNamespace());
-    getSpecification()->accept(&adjustMethodCount);
-
-    Meta meta(objectTypeName);
-    getSpecification()->accept(&meta);
-
-    if (messenger)
-    {
-        result = printMessenger(stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent);
-    }
-    else if (messengerSrc)
-    {
-        result = printMessengerSrc(stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent);
-    }
-    else if (messengerImp)
-    {
-        result = printMessengerImp(stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent);
-    }
-    else if (messengerImpSrc)
+    Compiler compiler(options);
+    if (impact)
     {
-        result = printMessengerImpSrc(stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent);
-    }
-    else if (java)
-    {
-        result = printJava(indent);
+        // List the files to be regenerated if the interface changes.
+        Compiler::Outputs outputs;
+        std::set<std::string> filenames;
+        if (!compiler.parse(files) || !compiler.resolve() || !compiler.generate(target, &outputs))
+        {
+            return EXIT_FAILURE;
+        }
+        if (!compiler.getImpact(impact, &filenames))
+        {
+            fprintf(stderr, "esidl: interface '%s' not found\n", impact);
+            return EXIT_FAILURE;
+        }
+        for (std::set<std::string>::const_iterator i = filenames.begin(); i != filenames.end(); ++i)
+        {
+            printf("%s\n", i->c_str());
+        }
+        return EXIT_SUCCESS;
     }
-    else if (sheet)
+    if (includeReport)
     {
-        Sheet visitor;
-        getSpecification()->accept(&visitor);
-        result = EXIT_SUCCESS;
+        // Report the include graph of the files instead of writing them.
+        Compiler::Outputs outputs;
+        if (!compiler.parse(files) || !compiler.resolve() || !compiler.generate(target, &outputs))
+        {
+            return EXIT_FAILURE;
+        }
+        Compiler::printIncludeReport(outputs, stdout);
+        return EXIT_SUCCESS;
     }
-    else
+    if (sizeReport)
     {
-        for (int i = 1; i < argc; ++i)
+        // Report the sizes of the files instead of writing them.
+        Compiler::Outputs outputs;
+        if (!compiler.parse(files) || !compiler.resolve() || !compiler.generate(target, &outputs))
         {
-            if (argv[i][0] == '-')
-            {
-                if (strcmp(argv[i], "-I") == 0 ||
-                    strcmp(argv[i], "-include") == 0 ||
-                    strcmp(argv[i], "-indent") == 0 ||
-                    strcmp(argv[i], "-isystem") == 0 ||
-                    strcmp(argv[i], "-namespace") == 0 ||
-                    strcmp(argv[i], "-object") == 0 ||
-                    strcmp(argv[i], "-prefix") == 0 ||
-                    strcmp(argv[i], "-string") == 0)
-                {
-                    ++i;
-                }
-                continue;
-            }
-            result = output(argv[i], isystem, useExceptions, useVirtualBase,
-                            stringTypeName, objectTypeName, indent,
-                            skeleton, generic);
+            return EXIT_FAILURE;
         }
+        compiler.printSizeReport(stdout);
+        return EXIT_SUCCESS;
+    }
+    bool succeeded = compiler.parse(files) && compiler.resolve() && compiler.generate(target);
+    if (stats)
+    {
+        fflush(stdout);
+        compiler.printStatistics(stderr);
     }
-    return result;
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -19,6 +19,7 @@
 #include "esidl.h"
 #include "parser.hh"
 #include "forward.h"
+#include "stringPool.h"
 
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -27,85 +28,223 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <sstream>
 
-extern FILE* yyin;
-extern int yyparse(void);
-
 namespace
 {
-    Node* specification;
-    Node* current;          // Current name space
-    const char* includePath;
-    std::string javadoc;
-    std::string savedJavadoc;
+    Context defaultContext;
+    __thread Context* threadContext;
 }
 
-int Node::level = 1;
 const char* Node::baseObjectName = "::object";
-const char* Node::namespaceName;
-const char* Node::defaultPrefix = "::org::w3c::dom";
-const char* Node::ctorScope = "::";
 
 std::map<uint32_t, std::string> Node::hashMap;
 
-bool Interface::useMultipleInheritance = false;
+Context::Context() :
+    specification(0),
+    current(0),
+    includePath(0),
+    level(1),
+    namespaceName(0),
+    defaultPrefix("::org::w3c::dom"),
+    ctorScope("::"),
+    useMultipleInheritance(false),
+    useVirtualBase(false),
+    useSpan(false),
+    useMove(false),
+    useMinimalIncludes(false),
+    useDispatchTable(false),
+    useMemberTable(false),
+    unitySize(-1),
+    supplementalCount(0),
+    poundMode(false),
+    stdinOffset(0),
+    stdinLine(0),
+    outputs(0),
+    keepUnchanged(false),
+    selective(false),
+    collectSizes(false),
+    sizeProbe(0)
+{
+}
+
+Context::Statistics::Statistics() :
+    nodes(0),
+    resolveCalls(0),
+    resolveDepth(0),
+    maxResolveDepth(0),
+    searchCalls(0),
+    searchComparisons(0),
+    filesWritten(0),
+    filesSkipped(0),
+    bytes(0)
+{
+}
+
+namespace
+{
+
+const size_t MetaBlockSize = 64 * 1024;
+
+}  // namespace
+
+MetaArena::MetaArena() :
+    next(0),
+    left(0),
+    size(0)
+{
+}
+
+MetaArena::~MetaArena()
+{
+    for (std::vector<char*>::iterator i = blocks.begin(); i != blocks.end(); ++i)
+    {
+        delete[] *i;
+    }
+}
+
+void MetaArena::reserve(size_t capacity)
+{
+    if (capacity <= left)
+    {
+        return;
+    }
+    next = new char[capacity];
+    left = capacity;
+    blocks.push_back(next);
+}
+
+MetaString MetaArena::store(const std::string& s)
+{
+    size_t length = s.length();
+    if (left < length + 1)
+    {
+        reserve(std::max(MetaBlockSize, length + 1));
+    }
+    char* data = next;
+    memcpy(data, s.data(), length);
+    data[length] = '\0';
+    next += length + 1;
+    left -= length + 1;
+    size += length;
+    return MetaString(data, length);
+}
+
+Context::GeneratorSize::GeneratorSize() :
+    bytes(0),
+    cases(0)
+{
+}
+
+Context* getContext()
+{
+    return threadContext ? threadContext : &defaultContext;
+}
+
+Context* setContext(Context* context)
+{
+    Context* prev = threadContext;
+    threadContext = context;
+    return prev;
+}
 
 Node* getSpecification()
 {
-    return specification;
+    return getContext()->specification;
 }
 
 Node* setSpecification(Node* node)
 {
-    Node* prev = specification;
-    specification = node;
+    Context* context = getContext();
+    Node* prev = context->specification;
+    context->specification = node;
     return prev;
 }
 
 const char* getIncludePath()
 {
-    return includePath;
+    return getContext()->includePath;
 }
 
 void setIncludePath(const char* path)
 {
-    includePath = path;
+    getContext()->includePath = path;
+}
+
+const std::string getBaseFilename()
+{
+    return getContext()->baseFilename;
+}
+
+void setBaseFilename(const char* name)
+{
+    std::string& baseFilename = getContext()->baseFilename;
+    baseFilename = name;
+    if (baseFilename[0] == '"')
+    {
+        baseFilename = baseFilename.substr(1, baseFilename.length() - 2);
+    }
+    setFilename(name);
+}
+
+const std::string getFilename()
+{
+    return getContext()->filename;
+}
+
+void setFilename(const char* name)
+{
+    std::string& filename = getContext()->filename;
+    filename = name;
+    if (filename == "\"<stdin>\"")
+    {
+        filename = getBaseFilename();
+    }
+    else if (filename[0] == '"')
+    {
+        filename = filename.substr(1, filename.length() - 2);
+    }
 }
 
 Node* getCurrent()
 {
-    return current;
+    return getContext()->current;
 }
 
 Node* setCurrent(const Node* node)
 {
-    Node* prev = current;
-    current = const_cast<Node*>(node);
+    Context* context = getContext();
+    Node* prev = context->current;
+    context->current = const_cast<Node*>(node);
     return prev;
 }
 
 std::string& getJavadoc()
 {
-    return javadoc;
+    return getContext()->javadoc;
 }
 
 void setJavadoc(const char* doc)
 {
-    javadoc = doc ? doc : "";
+    getContext()->javadoc = doc ? doc : "";
 }
 
 std::string& popJavadoc()
 {
-    javadoc = savedJavadoc;
-    return javadoc;
+    Context* context = getContext();
+    context->javadoc = context->savedJavadoc;
+    return context->javadoc;
 }
 
 void pushJavadoc()
 {
-    savedJavadoc = getJavadoc();
+    Context* context = getContext();
+    context->savedJavadoc = context->javadoc;
     setJavadoc(0);
 }
 
@@ -140,6 +279,91 @@ std::string getOutputFilename(std::string filename, const char* suffix)
         }
     }
 
+    return filename;
+}
+
+bool isSelected(const Node* node)
+{
+    Context* context = getContext();
+    return !context->selective || context->selectedNodes.count(node);
+}
+
+// Returns 0 without opening the file if the file is not selected to be
+// generated; see Context::selective.
+FILE* openOutput(const std::string& filename, const char* source)
+{
+    Context* context = getContext();
+    if (context->selective && source && *source &&
+        !context->selectedSources.count(source) && !context->selectedFiles.count(filename))
+    {
+        return 0;
+    }
+    Context::OutputOrigin& origin = context->outputOrigins[filename];
+    origin.node = 0;
+    origin.source = source;
+    return openOutput(filename, static_cast<const Node*>(0));
+}
+
+FILE* openOutput(const std::string& filename, const Node* node)
+{
+    Context* context = getContext();
+    if (node && !isSelected(node) && !context->selectedFiles.count(filename))
+    {
+        return 0;
+    }
+    if (node)
+    {
+        Context::OutputOrigin& origin = context->outputOrigins[filename];
+        origin.node = node;
+        origin.source = node->getSource();
+    }
+
+    // Every file is generated in memory first; see closeOutput().
+    Context::OutputBuffer* buffer = new Context::OutputBuffer;
+    buffer->filename = filename;
+    buffer->data = 0;
+    buffer->size = 0;
+    FILE* file = open_memstream(&buffer->data, &buffer->size);
+    if (!file)
+    {
+        delete buffer;
+        return 0;
+    }
+    context->outputBuffers[file] = buffer;
+    return file;
+}
+
+namespace
+{
+
+// Returns true if the file exists with exactly the specified contents.
+bool isUnchanged(const std::string& filename, const char* data, size_t size)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) == -1 || !S_ISREG(st.st_mode) || st.st_size != static_cast<off_t>(size))
+    {
+        return false;
+    }
+    FILE* file = fopen(filename.c_str(), "r");
+    if (!file)
+    {
+        return false;
+    }
+    bool unchanged = true;
+    char buffer[4096];
+    size_t pos = 0;
+    size_t count;
+    while (unchanged && 0 < (count = fread(buffer, 1, sizeof buffer, file)))
+    {
+        unchanged = (count <= size - pos && memcmp(buffer, data + pos, count) == 0);
+        pos += count;
+    }
+    fclose(file);
+    return unchanged && pos == size;
+}
+
+bool writeFile(const std::string& filename, const char* data, size_t size)
+{
     std::string dir;
     std::string path(filename);
     for (;;)
@@ -154,8 +378,183 @@ std::string getOutputFilename(std::string filename, const char* suffix)
         mkdir(dir.c_str(), 0777);
         dir += '/';
     }
+    FILE* file = fopen(filename.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+    fwrite(data, 1, size, file);
+    return fclose(file) == 0;
+}
 
-    return filename;
+}  // namespace
+
+// Stores the generated file in the outputs map if there is one. Otherwise
+// writes it under the output root, or to stdout if its name is "-". With
+// --keep-unchanged, a file already having the same contents is not
+// rewritten, so that the sources including it are not rebuilt needlessly.
+void closeOutput(FILE* file)
+{
+    Context* context = getContext();
+    std::map<FILE*, Context::OutputBuffer*>::iterator found = context->outputBuffers.find(file);
+    fclose(file);
+    if (found == context->outputBuffers.end())
+    {
+        return;
+    }
+    Context::OutputBuffer* buffer = found->second;
+    context->outputBuffers.erase(found);
+
+    Context::Statistics& statistics = context->statistics;
+    statistics.bytes += buffer->size;
+    if (context->outputs)
+    {
+        (*context->outputs)[buffer->filename].assign(buffer->data, buffer->size);
+        ++statistics.filesWritten;
+    }
+    else if (buffer->filename == "-")
+    {
+        fwrite(buffer->data, 1, buffer->size, stdout);
+        ++statistics.filesWritten;
+    }
+    else
+    {
+        std::string path = buffer->filename;
+        if (!context->outputRoot.empty())
+        {
+            path.insert(0, context->outputRoot + '/');
+        }
+        if (context->keepUnchanged && isUnchanged(path, buffer->data, buffer->size))
+        {
+            ++statistics.filesSkipped;
+        }
+        else if (writeFile(path, buffer->data, buffer->size))
+        {
+            ++statistics.filesWritten;
+        }
+        else
+        {
+            fprintf(stderr, "esidl: cannot write '%s'\n", path.c_str());
+        }
+    }
+    free(buffer->data);
+    delete buffer;
+}
+
+// Removes a file generated by an earlier run but no longer generated, from
+// the outputs map if there is one, or from under the output root. Returns
+// false if there is no such file.
+bool removeOutput(const std::string& filename)
+{
+    Context* context = getContext();
+    context->outputOrigins.erase(filename);
+    if (context->outputs)
+    {
+        return context->outputs->erase(filename) != 0;
+    }
+    std::string path = filename;
+    if (!context->outputRoot.empty())
+    {
+        path.insert(0, context->outputRoot + '/');
+    }
+    if (unlink(path.c_str()) != 0)
+    {
+        return false;
+    }
+    logOutput("# %s removed\n", filename.c_str());
+    return true;
+}
+
+SizeProbe::SizeProbe(FILE* file, const Interface* interface, const char* generator) :
+    file(file),
+    size(0),
+    start(0),
+    nested(0),
+    outer(0)
+{
+    Context* context = getContext();
+    if (!context->collectSizes)
+    {
+        return;
+    }
+    size = &context->sizes[interface][generator];
+    start = ftell(file);
+    outer = context->sizeProbe;
+    context->sizeProbe = this;
+}
+
+SizeProbe::~SizeProbe()
+{
+    if (!size)
+    {
+        return;
+    }
+    long written = ftell(file) - start;
+    size->bytes += written - nested;
+    if (outer)
+    {
+        outer->nested += written;
+    }
+    getContext()->sizeProbe = outer;
+}
+
+// Reports the name of a generated file unless the outputs are kept in memory.
+void logOutput(const char* format, ...)
+{
+    if (getContext()->outputs)
+    {
+        return;
+    }
+    va_list ap;
+    va_start(ap, format);
+    vprintf(format, ap);
+    va_end(ap);
+}
+
+// Writes the string pool to NAME.cpp, a name or a record per line.
+void printStringPool(const StringPool* stringPool)
+{
+    const std::string filename = getOutputFilename(stringPool->getName(), "cpp");
+    logOutput("# %s\n", filename.c_str());
+
+    FILE* file = openOutput(filename);
+    if (!file)
+    {
+        return;
+    }
+
+    const std::string& pool = stringPool->getPool();
+    const std::vector<size_t>& lines = stringPool->getLines();
+    fprintf(file, "// Generated by esidl %s.\n\n", PACKAGE_VERSION);
+    fprintf(file, "// %u names shared by %u interfaces in %u bytes\n",
+            static_cast<unsigned>(stringPool->getNameCount()), static_cast<unsigned>(stringPool->getCount()),
+            static_cast<unsigned>(pool.length()));
+    fprintf(file, "extern const char %s[];\n\n", stringPool->getName().c_str());
+    fprintf(file, "const char %s[] =", stringPool->getName().c_str());
+    for (std::vector<size_t>::const_iterator i = lines.begin(); i != lines.end(); ++i)
+    {
+        size_t end = (i + 1 != lines.end()) ? *(i + 1) : pool.length();
+        fprintf(file, "\n    /* %u */ \"", static_cast<unsigned>(*i));
+        for (size_t offset = *i; offset < end; ++offset)
+        {
+            if (pool[offset])
+            {
+                fputc(pool[offset], file);
+            }
+            else
+            {
+                fprintf(file, "\\0");  // always the last one in a line
+            }
+        }
+        fprintf(file, "\"");
+    }
+    if (pool.empty())
+    {
+        fprintf(file, " \"\"");
+    }
+    fprintf(file, ";\n");
+
+    closeOutput(file);
 }
 
 void Node::setLocation(struct YYLTYPE* yylloc)
@@ -184,7 +583,7 @@ std::string Node::getQualifiedName() const
     std::string qualifiedName;
     for (const Node* node = this; node && node->name != ""; node = node->getParent())
     {
-        qualifiedName = (node->isConstructor() ? ctorScope : "::") + node->name + qualifiedName;
+        qualifiedName = (node->isConstructor() ? getCtorScope() : "::") + node->name + qualifiedName;
     }
     return qualifiedName;
 }
@@ -193,7 +592,7 @@ std::string Node::getQualifiedModuleName() const
 {
     for (const Node* node = this; node; node = node->getParent())
     {
-        if (dynamic_cast<const Module*>(node))
+        if (dyn_cast<Module>(node))
         {
             return node->getQualifiedName();
         }
@@ -205,7 +604,7 @@ std::string Node::getPrefixedName() const
 {
     if (Node* parent = getParent())
     {
-        return parent->getPrefixedName() + (isConstructor() ? ctorScope : "::") + getName();
+        return parent->getPrefixedName() + (isConstructor() ? getCtorScope() : "::") + getName();
     }
     return getName();
 }
@@ -214,7 +613,7 @@ std::string Node::getPrefixedModuleName() const
 {
     for (const Node* node = this; node; node = node->getParent())
     {
-        if (dynamic_cast<const Module*>(node))
+        if (dyn_cast<Module>(node))
         {
             return node->getPrefixedName();
         }
@@ -239,12 +638,12 @@ bool Module::hasPredeclarations() const
     }
     for (NodeList::iterator i = begin(); i != end(); ++i)
     {
-        const Interface* interface = dynamic_cast<const Interface*>(*i);
+        const Interface* interface = dyn_cast<Interface>(*i);
         if (interface && 1 == interface->getRank() && interface->isLeaf())
         {
             return true;
         }
-        const Module* module = dynamic_cast<const Module*>(*i);
+        const Module* module = dyn_cast<Module>(*i);
         if (module && module->hasPredeclarations())
         {
             return true;
@@ -257,25 +656,58 @@ void Module::add(Node* node)
 {
     if (node->getRank() == 1)
     {
-        if (dynamic_cast<Interface*>(node))
+        switch (node->getKind())
         {
+        case InterfaceKind:
+        case DictionaryKind:
             if (!node->isLeaf())
             {
                 ++interfaceCount;
             }
-        }
-        if (dynamic_cast<ConstDcl*>(node))
-        {
+            break;
+        case ConstDclKind:
             ++constCount;
-        }
-        if (dynamic_cast<Module*>(node))
-        {
+            break;
+        case ModuleKind:
             ++moduleCount;
+            break;
+        default:
+            break;
         }
     }
     Node::add(node);
 }
 
+void Module::remove(Node* node)
+{
+    if (node->getRank() == 1)
+    {
+        switch (node->getKind())
+        {
+        case InterfaceKind:
+        case DictionaryKind:
+            if (!node->isLeaf())
+            {
+                --interfaceCount;
+                if (static_cast<Interface*>(node)->getConstructor())
+                {
+                    --interfaceCount;   // cf. Interface::add()
+                }
+            }
+            break;
+        case ConstDclKind:
+            --constCount;
+            break;
+        case ModuleKind:
+            --moduleCount;
+            break;
+        default:
+            break;
+        }
+    }
+    Node::remove(node);
+}
+
 void StructType::add(Node* node)
 {
     ++memberCount;
@@ -284,27 +716,31 @@ void StructType::add(Node* node)
 
 void Interface::add(Node* node)
 {
-    if (dynamic_cast<ConstDcl*>(node))
+    switch (node->getKind())
     {
+    case ConstDclKind:
         ++constCount;
-    }
-    else if (Interface* interface = dynamic_cast<Interface*>(node))
-    {
+        break;
+    case InterfaceKind:
+    case DictionaryKind:
         if (node->getRank() == 1)
         {
-            assert(!interface->isLeaf());
-            if (Module* module = dynamic_cast<Module*>(getParent()))
+            assert(!node->isLeaf());
+            if (Module* module = dyn_cast<Module>(getParent()))
             {
                 module->incInterfaceCount();
             }
         }
+        break;
+    default:
+        break;
     }
     Node::add(node);
 }
 
 void OpDcl::add(Node* node)
 {
-    if (dynamic_cast<ParamDcl*>(node))
+    if (node->getKind() == ParamDclKind)
     {
         ++paramCount;
     }
@@ -323,7 +759,7 @@ void OpDcl::adjustMethodCount()
         int paramCount = 0;
         for (NodeList::iterator i = begin(); i != end(); ++i)
         {
-            ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+            ParamDcl* param = dyn_cast<ParamDcl>(*i);
             assert(param);
             if (param->isOptional())
             {
@@ -339,19 +775,23 @@ void OpDcl::adjustMethodCount()
         paramCounts.push_back(paramCount);
         ++optionalStage;
     } while (optionalStage <= optionalCount);
-    Interface* interface = dynamic_cast<Interface*>(getParent());
+    Interface* interface = dyn_cast<Interface>(getParent());
     assert(interface);
     if (getAttr() & Static)
         interface->addStaticMethodCount(methodCount - 1);
     else
         interface->addMethodCount(methodCount - 1);
+}
 
+void OpDcl::checkCovariance()
+{
     if (hasCovariantReturnType())
     {
-        Node* base = resolveInBase(interface, getName());
-        assert(base);
+        const Interface::MemberEntry* entry = static_cast<Interface*>(getParent())->findInheritedMember(getName());
+        assert(entry);
+        Node* base = const_cast<Node*>(entry->member);
         base->setAttr(base->getAttr() | OpDcl::HasCovariant);
-        Interface* interface = dynamic_cast<Interface*>(base->getParent());
+        Interface* interface = dyn_cast<Interface>(base->getParent());
         assert(interface);
         interface->setAttr(interface->getAttr() | OpDcl::HasCovariant);
     }
@@ -366,7 +806,7 @@ Node* OpDcl::getSpec() const
     {
         if ((interface->getAttr() & Interface::OverrideBuiltins) &&
             (getAttr() & OpDcl::IndexGetter) &&
-            dynamic_cast<ParamDcl*>(*(this->begin()))->getSpec()->getName() == "string")
+            dyn_cast<ParamDcl>(*(this->begin()))->getSpec()->getName() == "string")
         {
             return &any;
         }
@@ -376,8 +816,8 @@ Node* OpDcl::getSpec() const
 
 void Implements::resolve(bool importImplements)
 {
-    Interface* interface = dynamic_cast<Interface*>(getFirst()->search(getParent()));
-    Interface* mixin = dynamic_cast<Interface*>(getSecond()->search(getParent()));
+    Interface* interface = dyn_cast<Interface>(getFirst()->search(getParent()));
+    Interface* mixin = dyn_cast<Interface>(getSecond()->search(getParent()));
     getFirst()->check(interface, "could not resolve '%s'.", getFirst()->getName().c_str());
     getSecond()->check(mixin, "could not resolve '%s'.", getSecond()->getName().c_str());
     interface->implements(mixin, importImplements);
@@ -393,11 +833,11 @@ void Module::processExtendedAttributes()
 
     for (NodeList::iterator i = list->begin(); i != list->end(); ++i)
     {
-        ExtendedAttribute* ext = dynamic_cast<ExtendedAttribute*>(*i);
+        ExtendedAttribute* ext = dyn_cast<ExtendedAttribute>(*i);
         assert(ext);
         if (ext->getName() == "Prefix")
         {
-            if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+            if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
             {
                 prefix = name->getName();
             }
@@ -419,18 +859,16 @@ void Module::processExtendedAttributes()
 
 void Interface::processExtendedAttributes()
 {
-    static unsigned supplementalCount = 0;
-
     if (NodeList* list = getExtendedAttributes())
     {
         ScopedName* interfaceName;
         for (NodeList::iterator i = list->begin(); i != list->end(); ++i)
         {
-            ExtendedAttribute* ext = dynamic_cast<ExtendedAttribute*>(*i);
+            ExtendedAttribute* ext = dyn_cast<ExtendedAttribute>(*i);
             assert(ext);
             if (ext->getName() == "Callback")
             {
-                if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+                if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
                 {
                     if (name->getName() == "FunctionOnly")
                     {
@@ -466,7 +904,7 @@ void Interface::processExtendedAttributes()
                     interfaceName = new ScopedName(getName());
                 }
                 OpDcl* op;
-                if (op = dynamic_cast<OpDcl*>(ext->getDetails()))
+                if (op = dyn_cast<OpDcl>(ext->getDetails()))
                 {
                     op->setSpec(interfaceName);
                     op->getName() = "createInstance";
@@ -508,7 +946,7 @@ void Interface::processExtendedAttributes()
     if ((attr & (Supplemental | NoInterfaceObject)) == Supplemental)
     {
         std::ostringstream oss;
-        oss << name << '-' << ++supplementalCount;
+        oss << name << '-' << ++getContext()->supplementalCount;
         name = oss.str();
     }
 }
@@ -523,7 +961,7 @@ void Attribute::processExtendedAttributes()
     uint32_t attr = getAttr();
     for (NodeList::iterator i = list->begin(); i != list->end(); ++i)
     {
-        ExtendedAttribute* ext = dynamic_cast<ExtendedAttribute*>(*i);
+        ExtendedAttribute* ext = dyn_cast<ExtendedAttribute>(*i);
         assert(ext);
         if (ext->getName() == "Replaceable")
         {
@@ -531,7 +969,7 @@ void Attribute::processExtendedAttributes()
         }
         else if (ext->getName() == "TreatNullAs")
         {
-            if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+            if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
             {
                 if (name->getName() == "EmptyString")
                 {
@@ -541,7 +979,7 @@ void Attribute::processExtendedAttributes()
         }
         else if (ext->getName() == "TreatUndefinedAs")
         {
-            if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+            if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
             {
                 if (name->getName() == "EmptyString")
                 {
@@ -555,7 +993,7 @@ void Attribute::processExtendedAttributes()
         }
         else if (ext->getName() == "PutForwards")
         {
-            if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+            if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
             {
                 putForwards = name->getName();
             }
@@ -580,7 +1018,7 @@ void OpDcl::processExtendedAttributes()
     // Check indexed/named properties
     if (attr & IndexMask)
     {
-        Node* spec = dynamic_cast<ParamDcl*>(*(begin()))->getSpec();
+        Node* spec = dyn_cast<ParamDcl>(*(begin()))->getSpec();
         Node* interface = getParent();
         if (spec->getName() == "unsigned long")
         {
@@ -623,7 +1061,7 @@ void OpDcl::processExtendedAttributes()
     }
     for (NodeList::iterator i = list->begin(); i != list->end(); ++i)
     {
-        ExtendedAttribute* ext = dynamic_cast<ExtendedAttribute*>(*i);
+        ExtendedAttribute* ext = dyn_cast<ExtendedAttribute>(*i);
         assert(ext);
         if (ext->getName() == "Null" ||
             ext->getName() == "Undefined" ||
@@ -646,6 +1084,38 @@ void OpDcl::processExtendedAttributes()
     setAttr(attr);
 }
 
+Node* ParamDcl::getSpanType() const
+{
+    if (!getContext()->useSpan || isVariadic())
+    {
+        return 0;
+    }
+    Node* spec = getSpec();
+    SequenceType* seq = spec->isSequence(getParent());
+    if (!seq || (spec->getAttr() & Nullable) || (getAttr() & NullIsEmpty))
+    {
+        return 0;
+    }
+    Node* elem = seq->getSpec();
+    if (elem->getAttr() & Nullable)
+    {
+        return 0;
+    }
+    const Node* scope = getParent();
+    if (elem->isBoolean(scope) ||
+        elem->isByte(scope) || elem->isOctet(scope) ||
+        elem->isShort(scope) || elem->isUnsignedShort(scope) ||
+        elem->isLong(scope) || elem->isUnsignedLong(scope) ||
+        elem->isLongLong(scope) || elem->isUnsignedLongLong(scope) ||
+        elem->isFloat(scope) || elem->isDouble(scope) ||
+        elem->compare("unrestricted float", scope) == 0 ||
+        elem->compare("unrestricted double", scope) == 0)
+    {
+        return elem;
+    }
+    return 0;
+}
+
 void ParamDcl::processExtendedAttributes()
 {
     NodeList* list = getExtendedAttributes();
@@ -656,11 +1126,11 @@ void ParamDcl::processExtendedAttributes()
     uint32_t attr = getAttr();
     for (NodeList::iterator i = list->begin(); i != list->end(); ++i)
     {
-        ExtendedAttribute* ext = dynamic_cast<ExtendedAttribute*>(*i);
+        ExtendedAttribute* ext = dyn_cast<ExtendedAttribute>(*i);
         assert(ext);
         if (ext->getName() == "TreatNullAs")
         {
-            if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+            if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
             {
                 if (name->getName() == "EmptyString")
                 {
@@ -670,7 +1140,7 @@ void ParamDcl::processExtendedAttributes()
         }
         else if (ext->getName() == "TreatUndefinedAs")
         {
-            if (ScopedName* name = dynamic_cast<ScopedName*>(ext->getDetails()))
+            if (ScopedName* name = dyn_cast<ScopedName>(ext->getDetails()))
             {
                 if (name->getName() == "EmptyString")
                 {
@@ -713,6 +1183,9 @@ Node* Node::search(const std::string& elem, size_t pos) const
         return 0;
     }
 
+    Context::Statistics& statistics = getContext()->statistics;
+    ++statistics.searchCalls;
+
     Interface* forwardDecl = 0;
 
     size_t n = elem.find("::", pos);
@@ -725,9 +1198,10 @@ Node* Node::search(const std::string& elem, size_t pos) const
          i != children->rend();
          ++i)
     {
+        ++statistics.searchComparisons;
         if ((*i)->getName().compare(0, (*i)->getName().size(), elem, pos, n - pos) == 0)
         {
-            Interface* interface = dynamic_cast<Interface*>(*i);
+            Interface* interface = dyn_cast<Interface>(*i);
             if (interface && interface->isLeaf() && elem.size() <= n)
             {
                 forwardDecl = interface;
@@ -751,7 +1225,7 @@ Node* resolveInBase(const Interface* interface, std::string name)
          ++i)
     {
         ScopedName* baseName = static_cast<ScopedName*>(*i);
-        Interface* base = dynamic_cast<Interface*>(baseName->search(interface->getParent()));
+        Interface* base = dyn_cast<Interface>(baseName->search(interface->getParent()));
         if (base)
         {
             if (base->getParent()->search(name) == base)
@@ -772,8 +1246,38 @@ Node* resolveInBase(const Interface* interface, std::string name)
     return 0;
  }
 
+namespace
+{
+
+// Tracks the nesting of resolve(); ScopedName::search() calls back into
+// resolve() for every typedef and base interface it goes through.
+class ResolveDepth
+{
+    Context::Statistics& statistics;
+
+public:
+    ResolveDepth(Context::Statistics& statistics) :
+        statistics(statistics)
+    {
+        ++statistics.resolveCalls;
+        if (statistics.maxResolveDepth < ++statistics.resolveDepth)
+        {
+            statistics.maxResolveDepth = statistics.resolveDepth;
+        }
+    }
+
+    ~ResolveDepth()
+    {
+        --statistics.resolveDepth;
+    }
+};
+
+}  // namespace
+
 Node* resolve(const Node* scope, std::string name)
 {
+    ResolveDepth depth(getContext()->statistics);
+
     if (name.compare(0, 2, "::") == 0)
     {
         return getSpecification()->search(name, 2);
@@ -785,7 +1289,7 @@ Node* resolve(const Node* scope, std::string name)
         {
             return found;
         }
-        if (const Interface* base = dynamic_cast<const Interface*>(node))
+        if (const Interface* base = dyn_cast<Interface>(node))
         {
             if (Node* found = resolveInBase(base, name))
             {
@@ -803,7 +1307,7 @@ Member* ScopedName::isTypedef(const Node* scope) const
     {
         return 0;
     }
-    if (Member* member = dynamic_cast<Member*>(resolved))
+    if (Member* member = dyn_cast<Member>(resolved))
     {
         return member->isTypedef(member->getParent());
     }
@@ -815,12 +1319,12 @@ Node* ScopedName::search(const Node* scope) const
     Node* resolved = resolve(scope, name);
     if (resolved)
     {
-        if (Member* member = dynamic_cast<Member*>(resolved))
+        if (Member* member = dyn_cast<Member>(resolved))
         {
             if (member->isTypedef(member->getParent()))
             {
                 resolved = member->getSpec();
-                if (ScopedName* node = dynamic_cast<ScopedName*>(resolved))
+                if (ScopedName* node = dyn_cast<ScopedName>(resolved))
                 {
                     if (Node* found = node->search(member->getParent()))
                     {
@@ -839,11 +1343,11 @@ Node* ScopedName::searchCplusplus(const Node* scope) const
     Node* resolved = resolve(scope, name);
     if (resolved)
     {
-        if (Member* member = dynamic_cast<Member*>(resolved))
+        if (Member* member = dyn_cast<Member>(resolved))
         {
             if (member->isTypedef(member->getParent()))
             {
-                if (ScopedName* node = dynamic_cast<ScopedName*>(member->getSpec()))
+                if (ScopedName* node = dyn_cast<ScopedName>(member->getSpec()))
                 {
                     resolved = node;
                     if (Node* found = node->searchCplusplus(member->getParent()))
@@ -857,14 +1361,36 @@ Node* ScopedName::searchCplusplus(const Node* scope) const
     return resolved;
 }
 
-// This method works only after AdjustMethodCount visitor has been applied.
-size_t Interface::getInterfaceCount() const
+// Each vector is the concatenation of the vectors of the interfaces it
+// refers to, which are linearized first.
+void Interface::linearize()
 {
-    if (interfaceCount != 0)
+    if (linearized)
     {
-        return interfaceCount;
+        return;
+    }
+    linearized = true;
+    for (std::list<const Interface*>::const_iterator i = superList.begin();
+         i != superList.end();
+         ++i)
+    {
+        const_cast<Interface*>(*i)->linearize();
+    }
+    for (std::list<const Interface*>::const_iterator i = implementList.begin();
+         i != implementList.end();
+         ++i)
+    {
+        const_cast<Interface*>(*i)->linearize();
+    }
+    for (std::list<const Interface*>::const_iterator i = supplementalList.begin();
+         i != supplementalList.end();
+         ++i)
+    {
+        const_cast<Interface*>(*i)->linearize();
     }
 
+    // The number of the non-supplemental interfaces this interface will
+    // implement, excluding Object.
     interfaceCount = 1;
     for (std::list<const Interface*>::const_iterator i = superList.begin();
          i != superList.end();
@@ -881,78 +1407,188 @@ size_t Interface::getInterfaceCount() const
     {
         interfaceCount += (*i)->getInterfaceCount();
     }
-    return interfaceCount;
-}
 
-void Interface::getInterfaceList(std::list<const Interface*>* list) const
-{
-    for (std::list<const Interface*>::const_reverse_iterator i = implementList.rbegin();
-         i != implementList.rend();
+    interfaceList.push_back(this);
+    for (std::list<const Interface*>::const_reverse_iterator i = superList.rbegin();
+         i != superList.rend();
+         ++i)
+    {
+        if (!((*i)->getAttr() & Interface::Supplemental) && !(*i)->isBaseObject())
+        {
+            const std::vector<const Interface*>& list = (*i)->getInterfaceList();
+            interfaceList.insert(interfaceList.end(), list.begin(), list.end());
+        }
+    }
+    for (std::list<const Interface*>::const_iterator i = implementList.begin();
+         i != implementList.end();
          ++i)
     {
         if (!((*i)->getAttr() & Interface::Supplemental))
         {
-            (*i)->getInterfaceList(list);
+            const std::vector<const Interface*>& list = (*i)->getInterfaceList();
+            interfaceList.insert(interfaceList.end(), list.begin(), list.end());
+        }
+    }
+
+    if (getContext()->useMultipleInheritance)
+    {
+        for (std::list<const Interface*>::const_reverse_iterator i = implementList.rbegin();
+             i != implementList.rend();
+             ++i)
+        {
+            if (!((*i)->getAttr() & Interface::Supplemental))
+            {
+                mixinList.push_back(*i);
+                const std::vector<const Interface*>& list = (*i)->getMixinList();
+                mixinList.insert(mixinList.end(), list.begin(), list.end());
+            }
+        }
+        for (std::list<const Interface*>::const_iterator i = superList.begin();
+             i != superList.end();
+             ++i)
+        {
+            if (!((*i)->getAttr() & Interface::Supplemental) && !(*i)->isBaseObject())
+            {
+                const std::vector<const Interface*>& list = (*i)->getMixinList();
+                mixinList.insert(mixinList.end(), list.begin(), list.end());
+            }
         }
     }
+
+    expandedSupplementals.push_back(this);
+    if (!isLeaf())
+    {
+        for (NodeList::iterator i = begin(); i != end(); ++i)
+        {
+            MergedMember merged = { this, *i };
+            mergedMembers.push_back(merged);
+        }
+    }
+    for (std::list<const Interface*>::const_iterator i = supplementalList.begin();
+         i != supplementalList.end();
+         ++i)
+    {
+        assert(!(*i)->isLeaf());
+        assert((*i) != this);
+        const std::vector<const Interface*>& list = (*i)->getExpandedSupplementals();
+        expandedSupplementals.insert(expandedSupplementals.end(), list.begin(), list.end());
+        const MergedMembers& members = (*i)->getMergedMembers();
+        mergedMembers.insert(mergedMembers.end(), members.begin(), members.end());
+    }
+
+    // Flatten the member table. The first super interface having a member
+    // of a name hides the following ones, as resolveInBase() does, and the
+    // members of this interface hide the inherited ones. The members of this
+    // interface are numbered after those of its first super interface.
+    // A forward declared interface like the base object has no members.
+    if (isLeaf())
+    {
+        return;
+    }
     for (std::list<const Interface*>::const_iterator i = superList.begin();
          i != superList.end();
          ++i)
     {
-        if (!((*i)->getAttr() & Interface::Supplemental) && !(*i)->isBaseObject())
+        if ((*i)->isBaseObject())
         {
-            (*i)->getInterfaceList(list);
+            continue;
+        }
+        const MemberTable& table = (*i)->getMemberTable();
+        for (MemberTable::const_iterator j = table.begin(); j != table.end(); ++j)
+        {
+            MemberEntry entry = j->second;
+            ++entry.depth;
+            memberTable.insert(std::make_pair(j->first, entry));
+        }
+        if (i == superList.begin())
+        {
+            memberCount = (*i)->getMemberCount();
         }
     }
-    list->push_front(this);
-}
-
-void Interface::collectMixins(std::list<const Interface*>* list) const
-{
-    if (!useMultipleInheritance)
-        return;
-
-    for (std::list<const Interface*>::const_reverse_iterator i = implementList.rbegin();
-         i != implementList.rend();
+    for (std::vector<const Interface*>::const_iterator i = expandedSupplementals.begin();
+         i != expandedSupplementals.end();
          ++i)
     {
-        if (!((*i)->getAttr() & Interface::Supplemental))
+        if ((*i)->isLeaf())
+        {
+            continue;
+        }
+        for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
         {
-            list->push_back(*i);
-            (*i)->collectMixins(list);
+            Node* member = *j;
+            switch (member->getKind())
+            {
+            case AttributeKind:
+            case OpDclKind:
+            case ConstDclKind:
+                break;
+            default:
+                continue;
+            }
+            if (member->isSequence(*i) || member->isNative(*i) || member->isTypedef(*i) || member->isInterface(*i))
+            {
+                continue;
+            }
+            MemberEntry entry = { member, this, 0, memberCount++ };
+            if (!member->getName().empty())
+            {
+                memberTable[member->getName()] = entry;
+            }
         }
     }
+}
+
+const Interface::MemberEntry* Interface::findInheritedMember(const std::string& name) const
+{
     for (std::list<const Interface*>::const_iterator i = superList.begin();
          i != superList.end();
          ++i)
     {
-        if (!((*i)->getAttr() & Interface::Supplemental) && !(*i)->isBaseObject())
+        const MemberTable& table = (*i)->getMemberTable();
+        MemberTable::const_iterator found = table.find(name);
+        if (found != table.end())
         {
-            (*i)->collectMixins(list);
+            return &found->second;
         }
     }
+    return 0;
 }
 
 void Interface::adjustMethodCount()
+{
+    resolveSuperList();
+
+    std::vector<Interface*> targets;
+    getSupplementalTargets(&targets);
+    for (std::vector<Interface*>::iterator i = targets.begin(); i != targets.end(); ++i)
+    {
+        (*i)->implements(this, true);
+    }
+}
+
+void Interface::resolveSuperList()
 {
     if (extends)
     {
         for (NodeList::iterator i = extends->begin(); i != extends->end(); ++i)
         {
-            Interface* super = dynamic_cast<Interface*>(static_cast<ScopedName*>(*i)->search(getParent()));
+            Interface* super = dyn_cast<Interface>(static_cast<ScopedName*>(*i)->search(getParent()));
             check(super, "could not resolve '%s'.", name.substr(0, name.rfind('-')).c_str());
             superList.push_back(super);
         }
     }
+}
 
+void Interface::getSupplementalTargets(std::vector<Interface*>* targets) const
+{
     switch (attr & (Supplemental | NoInterfaceObject))
     {
     case Supplemental:
     {
-        ScopedName* org = new ScopedName(name.substr(0, name.rfind('-')));
-        Interface* supplemental = dynamic_cast<Interface*>(org->search(getParent()));
+        ScopedName org(name.substr(0, name.rfind('-')));
+        Interface* supplemental = dyn_cast<Interface>(org.search(getParent()));
         check(supplemental, "could not resolve '%s'.", name.substr(0, name.rfind('-')).c_str());
-        supplemental->implements(this, true);
+        targets->push_back(supplemental);
         break;
     }
     case Supplemental | NoInterfaceObject:
@@ -960,8 +1596,7 @@ void Interface::adjustMethodCount()
         {
             for (NodeList::iterator i = extends->begin(); i != extends->end(); ++i)
             {
-                Interface* supplemental = dynamic_cast<Interface*>(static_cast<ScopedName*>(*i)->search(getParent()));
-                supplemental->implements(this, true);
+                targets->push_back(dyn_cast<Interface>(static_cast<ScopedName*>(*i)->search(getParent())));
             }
         }
         break;
@@ -970,6 +1605,33 @@ void Interface::adjustMethodCount()
     }
 }
 
+bool Interface::renumber()
+{
+    std::ostringstream oss;
+    oss << name.substr(0, name.rfind('-')) << '-' << ++getContext()->supplementalCount;
+    if (name == oss.str())
+    {
+        return false;
+    }
+    name = oss.str();
+    return true;
+}
+
+void Interface::unlink()
+{
+    interfaceCount = 0;
+    supplementalList.clear();
+    implementList.clear();
+    superList.clear();
+    linearized = false;
+    interfaceList.clear();
+    mixinList.clear();
+    expandedSupplementals.clear();
+    mergedMembers.clear();
+    memberTable.clear();
+    memberCount = 0;
+}
+
 std::string getScopedName(std::string moduleName, std::string absoluteName)
 {
     while (moduleName != "")
@@ -1036,18 +1698,13 @@ unsigned ArrayType::getLength(const Node* scope)
     return eval.getValue();
 }
 
-void yyerror(const char* message, ...)
+void yyerror(YYLTYPE* location, yyscan_t scanner, const char* message)
 {
-    va_list ap;
-
-    va_start(ap, message);
-    fprintf(stderr, "%s %d.%d-%d.%d: ",
+    fprintf(stderr, "%s %d.%d-%d.%d: %s\n",
             getFilename().c_str(),
-            yylloc.first_line, yylloc.first_column,
-            yylloc.last_line, yylloc.last_column);
-    vfprintf(stderr, message, ap);
-    fprintf(stderr, "\n");
-    va_end(ap);
+            location->first_line, location->first_column,
+            location->last_line, location->last_column,
+            message);
 }
 
 int input(int fd,
@@ -1055,22 +1712,35 @@ int input(int fd,
           bool useExceptions,
           const char* stringTypeName)
 {
-    yylloc.first_line = yylloc.last_line = 1;
-    yylloc.first_column = yylloc.last_column = 0;
+    // Read from a duplicate so that fd stays open for the caller.
+    FILE* file = fdopen(dup(fd), "r");
+    if (!file)
+    {
+        return EXIT_FAILURE;
+    }
+    yyscan_t scanner;
+    if (yylex_init_extra(getContext(), &scanner) != 0)
+    {
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    yyset_in(file, scanner);
+
+    int result = EXIT_SUCCESS;
     try
     {
-        yyin = fdopen(fd, "r");
-        if (yyparse() != 0)
+        if (yyparse(scanner) != 0)
         {
-            return EXIT_FAILURE;
+            result = EXIT_FAILURE;
         }
     }
     catch (...)
     {
-        return EXIT_FAILURE;
+        result = EXIT_FAILURE;
     }
-
-    return EXIT_SUCCESS;
+    yylex_destroy(scanner);
+    fclose(file);
+    return result;
 }
 
 int output(const char* filename,
@@ -1078,23 +1748,25 @@ int output(const char* filename,
            bool useExceptions,
            bool useVirtualBase,
            const char* stringTypeName,
+           const char* stringViewTypeName,
            const char* objectTypeName,
            const char* indent,
            bool skeleton,
-           bool generic)
+           bool generic,
+           const StringPool* stringPool)
 {
     Forward forward(filename);
     getSpecification()->accept(&forward);
     forward.generateForwardDeclarations();
 
-    printCxx(filename, stringTypeName, objectTypeName, useExceptions, useVirtualBase, indent);
+    printCxx(filename, stringTypeName, stringViewTypeName, objectTypeName, useExceptions, useVirtualBase, indent, stringPool);
     if (skeleton)
     {
         printSkeleton(filename, isystem, indent);
     }
     if (generic)
     {
-        printTemplate(filename, stringTypeName, objectTypeName, useExceptions, isystem, indent);
+        printTemplate(filename, stringTypeName, stringViewTypeName, objectTypeName, useExceptions, isystem, indent);
     }
     return EXIT_SUCCESS;
 }
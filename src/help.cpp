@@ -25,17 +25,68 @@ const char* helpText =
 "Usage: esidl [OPTION]... [FILE]...\n"
 "Generate C++ header and source files from Web IDL definition files.\n"
 "\n"
+"  -cxx                               generate C++ header files of abstract classes (default)\n"
 "  -messenger                         generate C++ header files\n"
 "  -messenger-src                     generate C++ source files\n"
 "  -messenger-imp                     generate C++ header skeleton files for implementation\n"
 "  -messenger-imp-src                 generate C++ source skeleton files for implementation\n"
+"  -cxx-module                        generate a C++20 module interface unit for each module,\n"
+"                                     merging the modules which depend on each other, and\n"
+"                                     list the units in the order to build in modules.txt\n"
+"  -module-prelude FILE               include FILE in the global module fragment of each unit\n"
+"  -o DIR                             write the files of the preceding target under DIR, or\n"
+"                                     those of all the targets if no target precedes it\n"
+"  -fdispatch-table                   generate a non-template dispatcher for each interface of\n"
+"                                     the messenger targets, which calls the implementation\n"
+"                                     classes through a table of pointers to their members;\n"
+"                                     cannot be used with -fvirtualbase\n"
+"  -fmember-table                     emit into the messenger headers a table of the members\n"
+"                                     of each interface, including the inherited ones, sorted\n"
+"                                     by selector for Reflect::findMember()\n"
+"  -fminimal-includes                 include only the headers of the classes the generated\n"
+"                                     messenger headers need complete, and define message_()\n"
+"                                     of the implementation classes in the -messenger-src files\n"
+"  -fmove                             move the arguments and the results into and out of\n"
+"                                     Any in the messenger targets (C++11)\n"
 "  -object NAME                       specify the name of C++ object class\n"
+"  -span                              pass sequences of primitive types as a pointer and\n"
+"                                     a length in the messenger targets\n"
 "  -string NAME                       specify the name of C++ string class\n"
+"  -string-view NAME                  pass DOMString parameters by the C++ string view class\n"
+"                                     NAME, and move strings into attribute setters\n"
+"  -string-pool NAME                  keep the reflection data of all the interfaces of the C++\n"
+"                                     and messenger targets in the string pool NAME defined in\n"
+"                                     NAME.cpp, storing the names used more than once only once\n"
+"  -unity N                           amalgamate the source files of the messenger targets into\n"
+"                                     one file per module if N is 0, or into files of at most\n"
+"                                     N interfaces of a module chosen by the hash of their names\n"
+"  --impact NAME                      list the files to be regenerated if interface NAME changes\n"
+"  --include-report                   print the number of the files each generated file includes\n"
+"                                     and is included by instead of writing the files\n"
+"  --keep-unchanged                   leave the files already having the generated contents\n"
+"                                     untouched, keeping their time stamps\n"
+"  --size-report                      print as JSON the bytes each generator emits for each\n"
+"                                     interface, the dispatch cases, the overloads and the\n"
+"                                     meta data lengths instead of writing the files\n"
+"  --stats                            print the time spent in each phase and other statistics\n"
+"                                     as JSON to stderr at exit, in an array of one object per\n"
+"                                     parse if the targets need the FILEs parsed more than once\n"
+"  --watch                            keep running, and update the outputs when FILEs or the\n"
+"                                     files they include change, parsing only the FILEs changed\n"
+"                                     where possible\n"
 "  --help                             display this help and exit\n"
 "  --version                          output version information and exit\n"
 "\n"
+"Several targets can be specified at once. The targets sharing the same options\n"
+"are generated in parallel from the FILEs parsed once, and the other targets after\n"
+"them from the FILEs parsed again. --impact, --include-report, --size-report and\n"
+"--watch take a single target.\n"
+"\n"
 "Examples:\n"
 "  esidl -messenger dom.idl html.idl  Generate C++ header files from dom.idl and html.idl.\n"
+"  esidl -messenger -o include -messenger-src -o src dom.idl\n"
+"                                     Generate C++ header files into include/ and source\n"
+"                                     files into src/ from dom.idl.\n"
 "\n"
 "Report esidl bugs to <https://github.com/esrille/esidl/issues>\n"
 "ES Operating System home page: <http://code.google.com/p/es-operating-system/>\n";
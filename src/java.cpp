@@ -51,23 +51,8 @@ FILE* createFile(const std::string package, const Node* node)
     filename += node->getName() + ".java";
 #endif
 
-    std::string dir;
-    std::string path(filename);
-    for (;;)
-    {
-        size_t slash = path.find("/");
-        if (slash == std::string::npos)
-        {
-            break;
-        }
-        dir += path.substr(0, slash);
-        path.erase(0, slash + 1);
-        mkdir(dir.c_str(), 0777);
-        dir += '/';
-    }
-
-    printf("# %s in %s\n", node->getName().c_str(), filename.c_str());
-    return fopen(filename.c_str(), "w");
+    logOutput("# %s in %s\n", node->getName().c_str(), filename.c_str());
+    return openOutput(filename, node);
 }
 
 }  // namespace
@@ -140,7 +125,7 @@ class JavaInterface : public Java
     // TODO: Move to Java
     void visitInterfaceElement(const Interface* interface, Node* element)
     {
-        if (dynamic_cast<Interface*>(element))
+        if (dyn_cast<Interface>(element))
         {
             // Do not process Constructor.
             return;
@@ -245,9 +230,8 @@ public:
 #endif
 
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
+        const std::vector<const Interface*>& interfaceList = node->getExpandedSupplementals();
+        for (std::vector<const Interface*>::const_iterator i = interfaceList.begin();
              i != interfaceList.end();
              ++i)
         {
@@ -432,13 +416,13 @@ public:
         {
             currentNode = resolved->getParent();
         }
-        if (!dynamic_cast<Interface*>(resolved) && !dynamic_cast<ExceptDcl*>(resolved))
+        if (!dyn_cast<Interface>(resolved) && !dyn_cast<ExceptDcl>(resolved))
         {
             resolved->accept(this);
         }
         else if (!resolved->isBaseObject())
         {
-            if (Module* module = dynamic_cast<Module*>(resolved->getParent()))
+            if (Module* module = dyn_cast<Module>(resolved->getParent()))
             {
                 if (prefixedName != module->getPrefixedName())
                 {
@@ -458,11 +442,11 @@ public:
     virtual void at(const ArrayType* node)
     {
         Node* spec = node->getSpec();
-        if (ScopedName* name = dynamic_cast<ScopedName*>(spec))
+        if (ScopedName* name = dyn_cast<ScopedName>(spec))
         {
             spec = name->search(currentNode);
         }
-        Type* type = dynamic_cast<Type*>(spec);
+        Type* type = dyn_cast<Type>(spec);
         if (type && !(type->getAttr() & Node::Nullable))
         {
             if (type->getName() == "boolean")
@@ -551,20 +535,17 @@ public:
             currentNode = node->getParent();
         }
 #endif
-        if (Module* module = dynamic_cast<Module*>(currentNode->getParent()))
+        if (Module* module = dyn_cast<Module>(currentNode->getParent()))
         {
             prefixedName = module->getPrefixedName();
         }
         visitChildren(node->getExtends());
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
-            currentNode = *i;
-            visitChildren(*i);
+            currentNode = i->interface;
+            i->node->accept(this);
         }
         currentNode = node;
     }
@@ -655,7 +636,7 @@ public:
         JavaInterface javaInterface(file, indent);
         javaInterface.at(node);
 
-        fclose(file);
+        closeOutput(file);
     }
 
     virtual void at(const Interface* node)
@@ -682,7 +663,7 @@ public:
         JavaInterface javaInterface(file, indent);
         javaInterface.at(node);
 
-        fclose(file);
+        closeOutput(file);
 
 #ifdef USE_CONSTRUCTOR
         if (Interface* constructor = node->getConstructor())
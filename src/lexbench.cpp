@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// lexbench - measures the throughput of the IDL scanner.
+//
+// Usage: lexbench [-n COUNT] FILE...
+//
+// Scans the given files COUNT times and reports the number of tokens
+// processed per second.
+
+#include "esidl.h"
+#include "parser.hh"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+
+double getTime()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+unsigned long scan(const char* name)
+{
+    FILE* file = fopen(name, "r");
+    if (!file)
+    {
+        fprintf(stderr, "lexbench: cannot open '%s'\n", name);
+        exit(EXIT_FAILURE);
+    }
+    Context context;
+    yyscan_t scanner;
+    yylex_init_extra(&context, &scanner);
+    yyset_in(file, scanner);
+
+    YYSTYPE value;
+    YYLTYPE location;
+    location.first_line = location.last_line = 1;
+    location.first_column = location.last_column = 0;
+    unsigned long count = 0;
+    while (int token = yylex(&value, &location, scanner))
+    {
+        switch (token)
+        {
+        case IDENTIFIER:
+        case INTEGER_LITERAL:
+        case FLOATING_PT_LITERAL:
+        case STRING_LITERAL:
+        case JAVADOC:
+            free(value.name);
+            break;
+        default:
+            break;
+        }
+        ++count;
+    }
+    yylex_destroy(scanner);
+    fclose(file);
+    return count;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    int repeat = 1;
+    int i = 1;
+    if (i + 1 < argc && strcmp(argv[i], "-n") == 0)
+    {
+        repeat = atoi(argv[i + 1]);
+        i += 2;
+    }
+    if (argc <= i || repeat < 1)
+    {
+        fprintf(stderr, "Usage: lexbench [-n COUNT] FILE...\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned long bytes = 0;
+    for (int j = i; j < argc; ++j)
+    {
+        struct stat st;
+        if (stat(argv[j], &st) == 0)
+            bytes += st.st_size;
+    }
+
+    unsigned long tokens = 0;
+    double start = getTime();
+    for (int n = 0; n < repeat; ++n)
+    {
+        for (int j = i; j < argc; ++j)
+            tokens += scan(argv[j]);
+    }
+    double elapsed = getTime() - start;
+    if (elapsed <= 0.0)
+        elapsed = 1e-6;
+
+    bytes *= repeat;
+    printf("%lu tokens, %lu bytes in %.3f sec: %.0f tokens/sec, %.2f MB/sec\n",
+           tokens, bytes, elapsed, tokens / elapsed, bytes / elapsed / (1024 * 1024));
+    return EXIT_SUCCESS;
+}
@@ -35,27 +35,155 @@
 #include "esidl.h"
 #include "parser.hh"
 
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
 #ifndef VERBOSE
 #define PRINTF(...)     (__VA_ARGS__)
 #else
 #define PRINTF(...)     printf(__VA_ARGS__)
 #endif
 
-void yyerror(const char* str);
+// The scanner keeps its state in the compilation context.
+#define YY_EXTRA_TYPE   Context*
+
+static void stepLocation(YYLTYPE* location, int length)
+{
+    location->first_line = location->last_line;
+    location->first_column = location->last_column + 1;
+    location->last_column += length;
+}
+
+//
+// Input
+//
+
+// The scanner reads the whole preprocessed IDL at once; fetch it in large
+// blocks with read(2) rather than through stdio.
+#define YY_BUF_SIZE     65536
+
+#define YY_INPUT(buf, result, max_size)                                 \
+    do                                                                  \
+    {                                                                   \
+        ssize_t count;                                                  \
+        while ((count = read(fileno(yyin), (buf), (max_size))) < 0)     \
+        {                                                               \
+            if (errno != EINTR)                                         \
+                YY_FATAL_ERROR("input in flex scanner failed");         \
+        }                                                               \
+        (result) = count;                                               \
+    } while (0)
+
+//
+// Keywords
+//
+
+namespace
+{
+
+struct Keyword
+{
+    const char* name;
+    int token;
+};
+
+// The keywords are recognized by the {Identifier} rule and looked up in a
+// perfect hash table instead of having a rule per keyword.
+const Keyword keywords[] =
+{
+    { "any", ANY },
+    { "attribute", ATTRIBUTE },
+    { "byte", BYTE },
+    { "ByteString", STRING },   // cf. http://dev.w3.org/2006/webapi/WebIDL/#idl-ByteString
+    { "boolean", BOOLEAN },
+    { "callback", CALLBACK },
+    { "const", CONST },
+    { "creator", CREATOR },
+    { "deleter", DELETER },
+    { "dictionary", DICTIONARY },
+    { "double", DOUBLE },
+    { "Date", DATE },
+    { "DOMString", STRING },
+    { "enum", ENUM },
+    { "exception", EXCEPTION },
+    { "false", FALSE },
+    { "float", FLOAT },
+    { "getraises", GETRAISES },
+    { "getter", GETTER },
+    { "implements", IMPLEMENTS },
+    { "in", IN },
+    { "Infinity", INFINITY },
+    { "inherit", INHERIT },
+    { "interface", INTERFACE },
+    { "legacycaller", CALLER },
+    { "long", LONG },
+    { "module", MODULE },
+    { "NaN", NAN },
+    { "native", NATIVE },
+    { "null", NULL_LITERAL },
+    { "object", IDENTIFIER },   // replaced with Node::getBaseObjectName()
+    { "octet", OCTET },
+    { "omittable", OMITTABLE },
+    { "optional", OPTIONAL },
+    { "or", OR },
+    { "partial", PARTIAL },
+    { "raises", RAISES },
+    { "readonly", READONLY },
+    { "sequence", SEQUENCE },
+    { "setraises", SETRAISES },
+    { "setter", SETTER },
+    { "short", SHORT },
+    { "static", STATIC },
+    { "string", STRING },
+    { "stringifier", STRINGIFIER },
+    { "true", TRUE },
+    { "typedef", TYPEDEF },
+    { "unrestricted", UNRESTRICTED },
+    { "unsigned", UNSIGNED },
+    { "void", VOID },
+};
+
+const unsigned KeywordTableSize = 128;  // must be a power of two
+
+// Every keyword is at least two characters long. For a one character
+// identifier, text[1] is the terminating NUL.
+inline unsigned hashKeyword(const char* text, int length)
+{
+    return (length + 31 * (unsigned char) text[0] + 5 * (unsigned char) text[1] + 31 * (unsigned char) text[length - 1]) & (KeywordTableSize - 1);
+}
 
-extern "C" int yywrap();
+const Keyword** createKeywordTable()
+{
+    static const Keyword* table[KeywordTableSize];
+    for (size_t i = 0; i < sizeof keywords / sizeof keywords[0]; ++i)
+    {
+        const Keyword* keyword = &keywords[i];
+        unsigned hash = hashKeyword(keyword->name, strlen(keyword->name));
+        assert(!table[hash]);  // the hash function must be updated for the new keyword
+        table[hash] = keyword;
+    }
+    return table;
+}
 
-void stepLocation()
+// Returns the token of the keyword, or 0 if text is not a keyword.
+int lookupKeyword(const char* text, int length)
 {
-    yylloc.first_line = yylloc.last_line;
-    yylloc.first_column = yylloc.last_column + 1;
-    yylloc.last_column += yyleng;
+    static const Keyword** table = createKeywordTable();
+    const Keyword* keyword = table[hashKeyword(text, length)];
+    if (keyword && strcmp(keyword->name, text) == 0)
+        return keyword->token;
+    return 0;
 }
 
-static bool poundMode = false;
+}  // namespace
 
 %}
 
+%option reentrant bison-bridge bison-locations
+%option noyywrap never-interactive
+
 /* regular definitions */
 
 USP                     (\xe1\x9a\x80)|(\xe1\xa0\x8e)|(\xe2\x80[\x80-\x8a])|(\xe2\x80\xaf)|(\xe2\x81\x9f)|(\xe3\x80\x80)
@@ -90,282 +218,89 @@ DoubleStringCharacter   ([^\"\\\n\r]|\\{EscapeSequence})
 Identifier              [A-Z_a-z][0-9A-Z_a-z]*
 
 MultiLineComment        \/\*(([^*])|(\*[^/]))*\*\/
-SingleLineComment       \/\/
+SingleLineComment       \/\/[^\n\r]*[\n\r]?
 
 PoundSign               ^{WhiteSpace}*#
 
 %%
 
 {WhiteSpace}        {
-                        ++yylloc.last_column;
+                        ++yylloc->last_column;
                     }
 {LineTerminator}    {
                         if (*yytext == '\n')
                         {
-                            ++yylloc.last_line;
-                            yylloc.last_column = 0;
-                            if (poundMode)
+                            ++yylloc->last_line;
+                            yylloc->last_column = 0;
+                            if (yyextra->poundMode)
                             {
-                                poundMode = false;
+                                yyextra->poundMode = false;
                                 return EOL;
                             }
                         }
                     }
 
-any                 {
-                        stepLocation();
-                        return ANY;
-                    }
-attribute           {
-                        stepLocation();
-                        return ATTRIBUTE;
-                    }
-byte                {
-                        stepLocation();
-                        return BYTE;
-                    }
-ByteString          {   /* cf. http://dev.w3.org/2006/webapi/WebIDL/#idl-ByteString */
-                        stepLocation();
-                        return STRING;
-                    }
-boolean             {
-                        stepLocation();
-                        return BOOLEAN;
-                    }
-callback            {
-                        stepLocation();
-                        return CALLBACK;
-                    }
-const               {
-                        stepLocation();
-                        return CONST;
-                    }
-creator             {
-                        stepLocation();
-                        return CREATOR;
-                    }
-deleter             {
-                        stepLocation();
-                        return DELETER;
-                    }
-dictionary          {
-                        stepLocation();
-                        return DICTIONARY;
-                    }
-double              {
-                        stepLocation();
-                        return DOUBLE;
-                    }
-Date                {
-                        stepLocation();
-                        return DATE;
-                    }
-DOMString           {
-                        stepLocation();
-                        return STRING;
-                    }
-enum                {
-                        stepLocation();
-                        return ENUM;
-                    }
-exception           {
-                        stepLocation();
-                        return EXCEPTION;
-                    }
-false               {
-                        stepLocation();
-                        return FALSE;
-                    }
-float               {
-                        stepLocation();
-                        return FLOAT;
-                    }
-getraises           {
-                        stepLocation();
-                        return GETRAISES;
-                    }
-getter              {
-                        stepLocation();
-                        return GETTER;
-                    }
-implements          {
-                        stepLocation();
-                        return IMPLEMENTS;
-                    }
-in                  {
-                        stepLocation();
-                        return IN;
-                    }
-Infinity            {
-                        stepLocation();
-                        return INFINITY;
-                    }
-inherit            {
-                        stepLocation();
-                        return INHERIT;
-                    }
-interface           {
-                        stepLocation();
-                        return INTERFACE;
-                    }
-legacycaller        {
-                        stepLocation();
-                        return CALLER;
-                    }
-long                {
-                        stepLocation();
-                        return LONG;
-                    }
-module              {
-                        stepLocation();
-                        return MODULE;
-                    }
-NaN                 {
-                        stepLocation();
-                        return NAN;
-                    }
-native              {
-                        stepLocation();
-                        return NATIVE;
-                    }
-null                {
-                        stepLocation();
-                        return NULL_LITERAL;
-                    }
-object              {
-                        stepLocation();
-                        yylval.name = strdup(Node::getBaseObjectName());
-                        return IDENTIFIER;
-                    }
-octet               {
-                        stepLocation();
-                        return OCTET;
-                    }
-omittable           {
-                        stepLocation();
-                        return OMITTABLE;
-                    }
-optional            {
-                        stepLocation();
-                        return OPTIONAL;
-                    }
-or                  {
-                        stepLocation();
-                        return OR;
-                    }
-partial              {
-                        stepLocation();
-                        return PARTIAL;
-                    }
-
-raises              {
-                        stepLocation();
-                        return RAISES;
-                    }
-readonly            {
-                        stepLocation();
-                        return READONLY;
-                    }
-sequence            {
-                        stepLocation();
-                        return SEQUENCE;
-                    }
-setraises           {
-                        stepLocation();
-                        return SETRAISES;
-                    }
-setter              {
-                        stepLocation();
-                        return SETTER;
-                    }
-short               {
-                        stepLocation();
-                        return SHORT;
-                    }
-static              {
-                        stepLocation();
-                        return STATIC;
-                    }
-string              {
-                        stepLocation();
-                        return STRING;
-                    }
-stringifier         {
-                        stepLocation();
-                        return STRINGIFIER;
-                    }
-true                {
-                        stepLocation();
-                        return TRUE;
-                    }
-typedef             {
-                        stepLocation();
-                        return TYPEDEF;
-                    }
-unrestricted        {
-                        stepLocation();
-                        return UNRESTRICTED;
-                    }
-unsigned            {
-                        stepLocation();
-                        return UNSIGNED;
-                    }
-void                {
-                        stepLocation();
-                        return VOID;
-                    }
-
 "::"                {
-                        stepLocation();
+                        stepLocation(yylloc, yyleng);
                         return OP_SCOPE;
                     }
 "<<"                {
-                        stepLocation();
+                        stepLocation(yylloc, yyleng);
                         return OP_SHL;
                     }
 ">>"                {
-                        stepLocation();
+                        stepLocation(yylloc, yyleng);
                         return OP_SHR;
                     }
 "..."               {
-                        stepLocation();
+                        stepLocation(yylloc, yyleng);
                         return ELLIPSIS;
                     }
 
 {Identifier}        {
-                        stepLocation();
-                        // A leading "_" is used to escape an identifier from looking like a reserved word terminal.
-                        yylval.name = (yytext[0] == '_') ? strdup(yytext + 1) : strdup(yytext);
-                        return IDENTIFIER;
+                        stepLocation(yylloc, yyleng);
+                        switch (int token = lookupKeyword(yytext, yyleng))
+                        {
+                        case 0:
+                            // A leading "_" is used to escape an identifier from looking like a reserved word terminal.
+                            yylval->name = (yytext[0] == '_') ? strdup(yytext + 1) : strdup(yytext);
+                            return IDENTIFIER;
+                        case IDENTIFIER:
+                            // object
+                            yylval->name = strdup(Node::getBaseObjectName());
+                            return IDENTIFIER;
+                        default:
+                            return token;
+                        }
                     }
 
 {DecimalIntegerLiteral} {
-                        stepLocation();
-                        yylval.name = strdup(yytext);
+                        stepLocation(yylloc, yyleng);
+                        yylval->name = strdup(yytext);
                         return INTEGER_LITERAL;
                     }
 
 {OctalIntegerLiteral}   {
-                        stepLocation();
-                        yylval.name = strdup(yytext);
+                        stepLocation(yylloc, yyleng);
+                        yylval->name = strdup(yytext);
                         return INTEGER_LITERAL;
                     }
 
 {HexIntegerLiteral} {
-                        stepLocation();
-                        yylval.name = strdup(yytext);
+                        stepLocation(yylloc, yyleng);
+                        yylval->name = strdup(yytext);
                         return INTEGER_LITERAL;
                     }
 
 {DecimalLiteral}    {
-                        stepLocation();
-                        yylval.name = strdup(yytext);
+                        stepLocation(yylloc, yyleng);
+                        yylval->name = strdup(yytext);
                         return FLOATING_PT_LITERAL;
                     }
 
 \"{DoubleStringCharacter}*\"    {
-                        stepLocation();
-                        yylval.name = strdup(yytext);
+                        stepLocation(yylloc, yyleng);
+                        yylval->name = strdup(yytext);
                         return STRING_LITERAL;
                     }
 
@@ -375,42 +310,36 @@ void                {
                         {
                             if (*s == '\n')
                             {
-                                ++yylloc.last_line;
-                                yylloc.last_column = 0;
+                                ++yylloc->last_line;
+                                yylloc->last_column = 0;
                             }
                             else
                             {
-                                ++yylloc.last_column;
+                                ++yylloc->last_column;
                             }
                         }
                         if (strncmp(yytext, "/**", 3) == 0)
                         {
                             /* Javadoc style comment */
-                            yylval.name = strdup(yytext);
+                            yylval->name = strdup(yytext);
                             return JAVADOC;
                         }
                     }
 
 {SingleLineComment} {
                         /* SingleLineComment */
-                        int c;
-
-                        do
-                        {
-                            c = yyinput();
-                        } while (c != '\n' && c != '\r' && c != EOF);
-                        ++yylloc.last_line;
-                        yylloc.last_column = 0;
+                        ++yylloc->last_line;
+                        yylloc->last_column = 0;
                     }
 
 {PoundSign}         {
-                        stepLocation();
-                        poundMode = true;
+                        stepLocation(yylloc, yyleng);
+                        yyextra->poundMode = true;
                         return POUND_SIGN;
                     }
 
 .                   {
-                        stepLocation();
+                        stepLocation(yylloc, yyleng);
                         return (int) yytext[0];
                     }
 
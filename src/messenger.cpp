@@ -26,8 +26,6 @@
 #include "messengerInvoke.h"
 #include "messengerMeta.h"
 
-bool Messenger::useVirtualBase = false;
-
 namespace
 {
 
@@ -55,25 +53,197 @@ std::string createFileName(const std::string prefixedName, const std::string obj
     return filename + ext;
 }
 
-FILE* createFile(const std::string prefixedName, const std::string objectTypeName, const char* ext = ".h")
+FILE* createFile(const Node* node, const std::string prefixedName, const std::string objectTypeName, const char* ext = ".h")
 {
     std::string filename = createFileName(prefixedName, objectTypeName, ext);
-    std::string dir;
-    std::string path(filename);
-    for (;;)
+    logOutput("# %s\n", filename.c_str());
+    return openOutput(filename, node);
+}
+
+// Orders the nodes in the order they have been read rather than by address,
+// so that the output does not depend on where the nodes were allocated.
+struct SerialLess
+{
+    bool operator()(const Node* a, const Node* b) const
     {
-        size_t slash = path.find("/");
-        if (slash == std::string::npos)
+        return a->getSerial() < b->getSerial();
+    }
+};
+
+typedef std::set<const Node*, SerialLess> NodeSet;
+
+// A unit of the amalgamated source files written with -unity.
+struct Unit
+{
+    const Node* module;
+    unsigned index;                             // within the module
+    std::vector<const Interface*> interfaces;
+};
+
+bool isPrecedingInUnits(const Interface* a, const Interface* b)
+{
+    std::string moduleA = a->getParent()->getPrefixedName();
+    std::string moduleB = b->getParent()->getPrefixedName();
+    if (moduleA != moduleB)
+    {
+        return moduleA < moduleB;
+    }
+    return a->getName() < b->getName();
+}
+
+// Groups the interfaces by module, and distributes each group into units
+// of at most size interfaces, or into a single unit if size is zero. The
+// number of the units of a module is the smallest power of two that can
+// hold its interfaces, and each interface goes to the unit given by the
+// hash of its name, so that adding or removing an interface usually changes
+// only the unit it belongs to. A unit given more than size interfaces by
+// chance keeps the first size of them by name, and the others are split by
+// name into the extra units numbered after the others. The units of a
+// module are listed together, and are to be written even if empty so that
+// the set of the files changes only with the number of the units. The
+// interfaces are sorted by name so that the units do not depend on the
+// order of the IDL files. If an interface is defined more than once, the
+// last definition is used as it would overwrite the file of the former
+// definitions.
+void getUnits(const std::vector<const Interface*>& list, unsigned size, std::vector<Unit>* units)
+{
+    std::vector<const Interface*> interfaces;
+    std::set<std::string> names;
+    for (std::vector<const Interface*>::const_reverse_iterator i = list.rbegin(); i != list.rend(); ++i)
+    {
+        if (names.insert((*i)->getPrefixedName()).second)
         {
-            break;
+            interfaces.push_back(*i);
+        }
+    }
+    std::stable_sort(interfaces.begin(), interfaces.end(), isPrecedingInUnits);
+    std::vector<const Interface*>::const_iterator i = interfaces.begin();
+    while (i != interfaces.end())
+    {
+        const Node* module = (*i)->getParent();
+        std::string moduleName = module->getPrefixedName();
+        std::vector<const Interface*>::const_iterator end = i;
+        while (end != interfaces.end() && (*end)->getParent()->getPrefixedName() == moduleName)
+        {
+            ++end;
+        }
+        unsigned count = 1;
+        while (0 < size && count * size < static_cast<unsigned>(end - i))
+        {
+            count *= 2;
+        }
+        std::vector<Unit> buckets(count);
+        std::vector<std::vector<const Interface*> > overflows(count);
+        for (; i != end; ++i)
+        {
+            std::string name = (*i)->getPrefixedName();
+            unsigned index = one_at_a_time(name.c_str(), name.length()) % count;
+            if (size == 0 || buckets[index].interfaces.size() < size)
+            {
+                buckets[index].interfaces.push_back(*i);
+            }
+            else
+            {
+                overflows[index].push_back(*i);
+            }
+        }
+        for (unsigned j = 0; j < count; ++j)
+        {
+            for (size_t k = 0; k < overflows[j].size(); k += size)
+            {
+                Unit unit;
+                unit.interfaces.assign(overflows[j].begin() + k,
+                                       overflows[j].begin() + std::min(k + size, overflows[j].size()));
+                buckets.push_back(unit);
+            }
+        }
+        for (unsigned j = 0; j < buckets.size(); ++j)
+        {
+            buckets[j].module = module;
+            buckets[j].index = j;
+            units->push_back(buckets[j]);
         }
-        dir += path.substr(0, slash);
-        path.erase(0, slash + 1);
-        mkdir(dir.c_str(), 0777);
-        dir += '/';
     }
-    printf("# %s\n", filename.c_str());
-    return fopen(filename.c_str(), "w");
+}
+
+// Returns the name of the amalgamated source file of the unit of module
+// in directory, e.g., "org/w3c/dom/html/unity-html-2.cpp" for the second
+// unit of html.
+std::string getUnitFileName(const std::string& directory, const Node* module, unsigned index)
+{
+    std::string name = directory + "unity-" + module->getName();
+    if (0 < index)
+    {
+        char suffix[16];
+        snprintf(suffix, sizeof suffix, "-%u", index + 1);
+        name += suffix;
+    }
+    return name + ".cpp";
+}
+
+// Opens the amalgamated source file of unit in directory.
+FILE* createUnitFile(const std::string& directory, const Unit& unit)
+{
+    std::string name = getUnitFileName(directory, unit.module, unit.index);
+    logOutput("# %s\n", name.c_str());
+    FILE* file = openOutput(name);
+    if (file)
+    {
+        std::vector<const Node*>& nodes = getContext()->outputOrigins[name].nodes;
+        nodes.assign(unit.interfaces.begin(), unit.interfaces.end());
+    }
+    return file;
+}
+
+// Writes the units of the interfaces with printer, and removes the files of
+// the units numbered after those of each module, which an earlier run may
+// have written. The units of a module are generated again together if any
+// of their interfaces is selected or any of their files has lost an
+// interface, as the number of the units may have changed; see
+// Compiler::update(). printer->getUnitDirectory() returns the directory of
+// the files of an interface.
+template <class Printer>
+void writeUnits(Printer* printer, const std::vector<const Interface*>& interfaces)
+{
+    Context* context = getContext();
+    std::vector<Unit> units;
+    getUnits(interfaces, context->unitySize, &units);
+    std::vector<Unit>::const_iterator i = units.begin();
+    while (i != units.end())
+    {
+        std::vector<Unit>::const_iterator end = i;
+        std::string directory;
+        while (end != units.end() && end->module == i->module)
+        {
+            if (directory.empty() && !end->interfaces.empty())
+            {
+                directory = printer->getUnitDirectory(end->interfaces.front());
+            }
+            ++end;
+        }
+        bool selected = !context->selective;
+        for (std::vector<Unit>::const_iterator j = i; !selected && j != end; ++j)
+        {
+            selected = context->selectedFiles.count(getUnitFileName(directory, j->module, j->index)) != 0;
+            for (std::vector<const Interface*>::const_iterator k = j->interfaces.begin(); !selected && k != j->interfaces.end(); ++k)
+            {
+                selected = isSelected(*k);
+            }
+        }
+        if (selected)
+        {
+            for (std::vector<Unit>::const_iterator j = i; j != end; ++j)
+            {
+                printer->printUnit(directory, *j);
+            }
+            unsigned index = end - i;
+            while (removeOutput(getUnitFileName(directory, i->module, index)))
+            {
+                ++index;
+            }
+        }
+        i = end;
+    }
 }
 
 }  // namespace
@@ -153,15 +323,20 @@ std::string Messenger::getEscapedName(std::string name)
 
 class MessengerInterface : public Messenger
 {
+    const StringPool* stringPool;
+
 public:
-    MessengerInterface(FILE* file, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
-        Messenger(file, stringTypeName, objectTypeName, useExceptions, indent)
+    MessengerInterface(FILE* file, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent,
+                       const StringPool* stringPool = 0) :
+        Messenger(file, stringTypeName, objectTypeName, useExceptions, indent),
+        stringPool(stringPool)
     {
         currentNode = 0;
     }
 
     MessengerInterface(const Formatter* formatter, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions) :
-        Messenger(formatter, stringTypeName, objectTypeName, useExceptions)
+        Messenger(formatter, stringTypeName, objectTypeName, useExceptions),
+        stringPool(0)
     {
         currentNode = 0;
     }
@@ -208,6 +383,7 @@ public:
             targetModuleName = prefixedModuleName = currentNode->getPrefixedModuleName();
         }
         assert(!(node->getAttr() & Interface::Supplemental) && !node->isLeaf());
+        SizeProbe probe(getFile(), node, "MessengerInterface");
 
         writetab();
         if (node->getJavadoc().size())
@@ -226,7 +402,7 @@ public:
             {
                 write(separator);
                 separator = ", public ";
-                if (useVirtualBase && (*i)->isBaseObject())
+                if (getContext()->useVirtualBase && (*i)->isBaseObject())
                 {
                     write("virtual ");
                 }
@@ -239,9 +415,8 @@ public:
         indent();
 
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
+        const std::vector<const Interface*>& interfaceList = node->getExpandedSupplementals();
+        for (std::vector<const Interface*>::const_iterator i = interfaceList.begin();
              i != interfaceList.end();
              ++i)
         {
@@ -391,8 +566,12 @@ public:
         writeln("}");
 
         writeln("");
-        MessengerDispatch dispatch(this, stringTypeName, objectTypeName, useExceptions);
-        dispatch.at(node);
+        {
+            SizeProbe probe(getFile(), node, "MessengerDispatch");
+            MessengerDispatch dispatch(this, stringTypeName, objectTypeName, useExceptions);
+            dispatch.at(node);
+            probe.addCases(dispatch.getCaseCount());
+        }
 
         if (constructor || 0 < node->getStaticMethodCount())
         {
@@ -400,8 +579,11 @@ public:
             writeln("static Object getConstructor();");
         }
 
-        MessengerMeta meta(this, stringTypeName, objectTypeName, useExceptions);
-        const_cast<Interface*>(node)->accept(&meta);
+        {
+            SizeProbe probe(getFile(), node, "MessengerMeta");
+            MessengerMeta meta(this, stringTypeName, objectTypeName, useExceptions, stringPool);
+            const_cast<Interface*>(node)->accept(&meta);
+        }
 
         writeln("};");
     }
@@ -446,7 +628,7 @@ public:
         if (node->isTypedef(node->getParent()))
         {
             Node* spec = node->getSpec();
-            if (dynamic_cast<ScopedName*>(spec))
+            if (dyn_cast<ScopedName>(spec))
                 return;
             write("typedef ");
         }
@@ -516,15 +698,17 @@ public:
 class MessengerInclude: public Visitor, public Formatter
 {
     const Node* currentNode;
+    const Interface* interface;     // not to include the header being generated
     std::string objectTypeName;
     bool useExceptions;
-    std::set<const Node*> includeSet;
+    NodeSet includeSet;
     bool overloaded;
 
 public:
     MessengerInclude(FILE* file, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
         Formatter(file, indent),
         currentNode(0),
+        interface(0),
         objectTypeName(objectTypeName),
         useExceptions(useExceptions),
         overloaded(false)
@@ -534,6 +718,7 @@ public:
     MessengerInclude(const Formatter* formatter, const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions) :
         Formatter(formatter),
         currentNode(0),
+        interface(0),
         objectTypeName(objectTypeName),
         useExceptions(useExceptions),
         overloaded(false)
@@ -556,7 +741,7 @@ public:
         {
             currentNode = resolved->getParent();
         }
-        if (!dynamic_cast<Interface*>(resolved))
+        if (!dyn_cast<Interface>(resolved))
         {
             resolved->accept(this);
         }
@@ -592,6 +777,15 @@ public:
         }
         assert(!(node->getAttr() & Interface::Supplemental) && !node->isLeaf());
 
+        // With -fminimal-includes, the header of the interface itself is not
+        // included, and the types only named in typedefs and constructors
+        // are left forward declared by MessengerImport.
+        bool minimal = getContext()->useMinimalIncludes;
+        if (minimal)
+        {
+            interface = node;
+        }
+
         if (node->getExtends())
         {
             for (NodeList::iterator i = node->getExtends()->begin();
@@ -625,25 +819,25 @@ public:
         std::multimap<uint32_t, OpDcl*> operations;
 
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
             const Node* saved = currentNode;
-            currentNode = *i;
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
+            currentNode = i->interface;
+            if (OpDcl* op = dyn_cast<OpDcl>(i->node))
+            {
+                if (!(op->getAttr() & OpDcl::UnnamedProperty))
+                    operations.insert(std::pair<uint32_t, OpDcl*>(op->getHash(), op));
+                if (op->getAttr() & (OpDcl::UnnamedProperty | OpDcl::Omittable | OpDcl::Caller))
+                    operations.insert(std::pair<uint32_t, OpDcl*>(0, op));
+            }
+            else
             {
-                if (OpDcl* op = dynamic_cast<OpDcl*>(*j))
+                Member* member = dyn_cast<Member>(i->node);
+                if (!minimal || (!isa<Interface>(i->node) && !(member && member->isTypedef(i->interface))))
                 {
-                    if (!(op->getAttr() & OpDcl::UnnamedProperty))
-                        operations.insert(std::pair<uint32_t, OpDcl*>(op->getHash(), op));
-                    if (op->getAttr() & (OpDcl::UnnamedProperty | OpDcl::Omittable | OpDcl::Caller))
-                        operations.insert(std::pair<uint32_t, OpDcl*>(0, op));
-                    continue;
+                    i->node->accept(this);
                 }
-                (*j)->accept(this);
             }
             currentNode = saved;
         }
@@ -677,7 +871,10 @@ public:
         }
 
 #ifdef USE_CONSTRUCTOR
-        visitChildren(constructor);
+        if (!minimal)
+        {
+            visitChildren(constructor);
+        }
 #endif
     }
 
@@ -733,11 +930,15 @@ public:
 
     void print()
     {
+        if (interface)
+        {
+            includeSet.erase(interface);
+        }
         if (includeSet.empty())
         {
             return;
         }
-        for (std::set<const Node*>::iterator i = includeSet.begin();
+        for (NodeSet::iterator i = includeSet.begin();
              i != includeSet.end();
              ++i)
         {
@@ -823,7 +1024,7 @@ class MessengerImport : public Visitor, public Formatter
 
     const Node* currentNode;
     bool printed;
-    std::set<const Node*> importSet;
+    NodeSet importSet;
     std::list<Node*> typedefList;
     std::set<Node*> typedefSet;
     bool importObjectArray;
@@ -858,7 +1059,7 @@ public:
         {
             currentNode = resolved->getParent();
         }
-        if (!dynamic_cast<Interface*>(resolved) && !dynamic_cast<ExceptDcl*>(resolved))
+        if (!dyn_cast<Interface>(resolved) && !dyn_cast<ExceptDcl>(resolved))
         {
             resolved->accept(this);
         }
@@ -933,14 +1134,11 @@ public:
         }
 #endif
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
-            currentNode = *i;
-            visitChildren(*i);
+            currentNode = i->interface;
+            i->node->accept(this);
         }
         currentNode = node->getParent();
 
@@ -990,11 +1188,11 @@ public:
             newline = true;
         }
 
-        for (std::set<const Node*>::iterator i = importSet.begin();
+        for (NodeSet::iterator i = importSet.begin();
              i != importSet.end();
              ++i)
         {
-            if (Module* module = dynamic_cast<Module*>((*i)->getParent()))
+            if (Module* module = dyn_cast<Module>((*i)->getParent()))
             {
                 std::string name = module->getPrefixedName() + "::" + (*i)->getName();
                 size_t pos = ns->enter(name);
@@ -1007,13 +1205,13 @@ public:
              i != typedefList.end();
              ++i)
         {
-            if (dynamic_cast<Module*>((*i)->getParent()))
+            if (dyn_cast<Module>((*i)->getParent()))
             {
                 ns->enter((*i)->getPrefixedName());
                 MessengerInterface messengerInterface(this, stringTypeName, objectTypeName, useExceptions);
-                if (Member* type = dynamic_cast<Member*>(*i))
+                if (Member* type = dyn_cast<Member>(*i))
                     messengerInterface.at(type);
-                else if (Enum* type = dynamic_cast<Enum*>(*i))
+                else if (Enum* type = dyn_cast<Enum>(*i))
                     messengerInterface.at(type);
                 newline = true;
             }
@@ -1025,13 +1223,18 @@ public:
         }
     }
 
+    const NodeSet& getImportSet() const
+    {
+        return importSet;
+    }
+
     void printExtra()
     {
         if (!importSet.empty())
         {
             write("\n");
         }
-        for (std::set<const Node*>::iterator i = importSet.begin();
+        for (NodeSet::iterator i = importSet.begin();
              i != importSet.end();
              ++i)
         {
@@ -1088,18 +1291,12 @@ public:
         }
         assert(!(node->getAttr() & Interface::Supplemental) && !node->isLeaf());
 
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
             const Node* saved = currentNode;
-            currentNode = *i;
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
-            {
-                visitInterfaceElement(*i, *j);
-            }
+            currentNode = i->interface;
+            visitInterfaceElement(i->interface, i->node);
             currentNode = saved;
         }
     }
@@ -1111,13 +1308,16 @@ class MessengerVisitor : public Visitor
     std::string objectTypeName;
     bool useExceptions;
     std::string indent;
+    const StringPool* stringPool;
 
 public:
-    MessengerVisitor(const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
+    MessengerVisitor(const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent,
+                     const StringPool* stringPool = 0) :
         stringTypeName(stringTypeName),
         objectTypeName(objectTypeName),
         useExceptions(useExceptions),
-        indent(indent)
+        indent(indent),
+        stringPool(stringPool)
     {
     }
 
@@ -1138,7 +1338,7 @@ public:
         }
 
         std::string prefixedName = node->getPrefixedName();
-        FILE* file = createFile(prefixedName, objectTypeName);
+        FILE* file = createFile(node, prefixedName, objectTypeName);
         if (!file)
         {
             return;
@@ -1162,7 +1362,7 @@ public:
 
         // postable
         fprintf(file, "\n#endif  // %s\n", included.c_str());
-        fclose(file);
+        closeOutput(file);
     }
 
     virtual void at(const Interface* node)
@@ -1174,7 +1374,7 @@ public:
         }
 
         std::string prefixedName = node->getPrefixedName();
-        FILE* file = createFile(prefixedName, objectTypeName);
+        FILE* file = createFile(node, prefixedName, objectTypeName);
         if (!file)
         {
             return;
@@ -1190,6 +1390,10 @@ public:
         {
             fprintf(file, "#include <type_traits>\n");
         }
+        if (getContext()->useMove)
+        {
+            fprintf(file, "#include <utility>\n");
+        }
 
         // body
 
@@ -1198,6 +1402,11 @@ public:
         include.at(node);
         include.print();
 
+        if (stringPool)
+        {
+            fprintf(file, "extern const char %s[];\n\n", stringPool->getName().c_str());
+        }
+
         MessengerNameSpace ns(file, indent);
 
         MessengerImport import(file, stringTypeName, objectTypeName, useExceptions, indent, &ns);
@@ -1207,7 +1416,7 @@ public:
 
         ns.enter(prefixedName);
 
-        MessengerInterface messengerInterface(file, stringTypeName, objectTypeName, useExceptions, indent);
+        MessengerInterface messengerInterface(file, stringTypeName, objectTypeName, useExceptions, indent, stringPool);
         messengerInterface.at(node);
 
         fprintf(file, "\n");
@@ -1216,27 +1425,227 @@ public:
 
         // postable
         fprintf(file, "\n#endif  // %s\n", included.c_str());
-        fclose(file);
+        closeOutput(file);
+    }
+};
+
+// Collect the interfaces that MessengerVisitor generates the headers for. If
+// an interface is defined more than once, only the last definition is kept
+// as its header overwrites the headers of the former definitions.
+class MessengerStringPoolBuilder : public Visitor
+{
+    std::vector<const Interface*> interfaces;
+
+public:
+    virtual void at(const Node* node)
+    {
+        if (1 < node->getRank())
+        {
+            return;
+        }
+        visitChildren(node);
+    }
+
+    virtual void at(const Interface* node)
+    {
+        if (1 < node->getRank() || node->isLeaf() ||
+            (node->getAttr() & Interface::Supplemental))
+        {
+            return;
+        }
+        for (std::vector<const Interface*>::iterator i = interfaces.begin(); i != interfaces.end(); ++i)
+        {
+            if ((*i)->getPrefixedName() == node->getPrefixedName())
+            {
+                interfaces.erase(i);
+                break;
+            }
+        }
+        interfaces.push_back(node);
+    }
+
+    void build(StringPool* pool)
+    {
+        for (std::vector<const Interface*>::const_iterator i = interfaces.begin(); i != interfaces.end(); ++i)
+        {
+            MessengerMetaRecords meta;
+            meta.at(*i);
+            pool->add(*i, meta.getRecords());
+        }
+        pool->build();
     }
 };
 
 int printMessenger(const char* stringTypeName, const char* objectTypeName,
-                   bool useExceptions, bool useVirtualBase, const char* indent)
+                   bool useExceptions, bool useVirtualBase, const char* indent, const StringPool* stringPool)
 {
-    Messenger::useVirtualBase = useVirtualBase;
-    MessengerVisitor visitor(stringTypeName, objectTypeName, useExceptions, indent);
+    getContext()->useVirtualBase = useVirtualBase;
+    MessengerVisitor visitor(stringTypeName, objectTypeName, useExceptions, indent, stringPool);
     getSpecification()->accept(&visitor);
     return 0;
 }
 
+void buildMessengerStringPool(StringPool* stringPool)
+{
+    MessengerStringPoolBuilder builder;
+    getSpecification()->accept(&builder);
+    builder.build(stringPool);
+}
+
 class MessengerSrcVisitor : public Visitor
 {
     std::string stringTypeName;
     std::string objectTypeName;
     bool useExceptions;
     std::string indent;
+    std::vector<const Interface*> interfaces;   // to be amalgamated with -unity
+
+    std::string getHeaderName(const Interface* node)
+    {
+        if (!node->isConstructor())
+        {
+            return createFileName(node->getPrefixedName(), objectTypeName);
+        }
+        return createFileName(node->getParent()->getPrefixedName(), objectTypeName);
+    }
+
+    static std::string getImpName(const Interface* node)
+    {
+        return "::org::w3c::dom::bootstrap::" + node->getName() + "Imp";
+    }
+
+    void printPreamble(FILE* file)
+    {
+        fprintf(file, "// Generated by esidl %s.\n\n", PACKAGE_VERSION);
+        fprintf(file, "#ifdef HAVE_CONFIG_H\n");
+        fprintf(file, "#include \"config.h\"\n");
+        fprintf(file, "#endif\n\n");
+    }
+
+    void printBody(FILE* file, MessengerNameSpace* ns, const Interface* node)
+    {
+        ns->enter(node->getPrefixedName());
+
+        {
+            SizeProbe probe(file, node, "MessengerStaticData");
+            MessengerStaticData messengerStaticData(file, stringTypeName, objectTypeName, useExceptions, indent);
+            messengerStaticData.at(node);
+        }
+        fprintf(file, "\n");
+
+        {
+            SizeProbe probe(file, node, "MessengerInvoke");
+            MessengerInvoke messengerInvoke(file, stringTypeName, objectTypeName, useExceptions, indent);
+            messengerInvoke.at(node);
+        }
+
+#ifdef USE_CONSTRUCTOR
+        if (Interface* constructor = node->getConstructor())
+        {
+            MessengerInvoke messengerInvoke(file, stringTypeName, objectTypeName, useExceptions, indent);
+            messengerInvoke.setConstructorMode(true);
+            messengerInvoke.at(constructor);
+        }
+#endif
+
+        if (getContext()->useMinimalIncludes)
+        {
+            // With -fminimal-includes, message_() of the implementation class
+            // is defined here rather than in the implementation header, so
+            // that the header does not need the types the dispatcher
+            // converts to and from Any, nor in the implementation source
+            // file, which is edited by hand.
+            std::string impName = getImpName(node);
+            std::string name = node->getPrefixedName();
+            if (name == Node::getBaseObjectName())
+            {
+                name.replace(2, name.length(), objectTypeName);
+            }
+            ns->enter(impName);
+            fprintf(file, "\n");
+            ns->writeln("Any %s::message_(uint32_t selector, const char* id, int argc, Any* argv) {",
+                        (node->getName() + "Imp").c_str());
+                ns->writeln("return %s::dispatch(this, selector, id, argc, argv);",
+                            getScopedName("::org::w3c::dom::bootstrap", name).c_str());
+            ns->writeln("}");
+        }
+    }
 
 public:
+    std::string getUnitDirectory(const Interface* node) const
+    {
+        std::string filename = createFileName(node->getPrefixedName(), objectTypeName);
+        return filename.substr(0, filename.rfind('/') + 1);
+    }
+
+    // Includes the headers once, and opens the namespace once, for all the
+    // interfaces in the unit.
+    void printUnit(const std::string& directory, const Unit& unit)
+    {
+        FILE* file = createUnitFile(directory, unit);
+        if (!file)
+        {
+            return;
+        }
+
+        printPreamble(file);
+        std::set<std::string> included;
+        for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+        {
+            std::string name = getHeaderName(*i);
+            if (included.insert(name).second)
+            {
+                fprintf(file, "#include <%s>\n", name.c_str());
+            }
+        }
+        if (getContext()->useMinimalIncludes)
+        {
+            for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+            {
+                fprintf(file, "#include <%s>\n", createFileName(getImpName(*i), objectTypeName).c_str());
+            }
+        }
+
+        MessengerNameSpace ns(file, indent);
+
+        std::set<std::string> imports;
+        for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+        {
+            MessengerImport import(file, stringTypeName, objectTypeName, useExceptions, indent, &ns);
+            import.at(*i);
+            const NodeSet& importSet = import.getImportSet();
+            for (NodeSet::const_iterator j = importSet.begin(); j != importSet.end(); ++j)
+            {
+                std::string name = createFileName((*j)->getPrefixedName(), objectTypeName);
+                if (!included.count(name))
+                {
+                    imports.insert(name);
+                }
+            }
+        }
+        if (!imports.empty())
+        {
+            fprintf(file, "\n");
+        }
+        for (std::set<std::string>::const_iterator i = imports.begin(); i != imports.end(); ++i)
+        {
+            fprintf(file, "#include <%s>\n", i->c_str());
+        }
+        fprintf(file, "\n");
+
+        for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+        {
+            if (i != unit.interfaces.begin())
+            {
+                fprintf(file, "\n");
+            }
+            printBody(file, &ns, *i);
+        }
+        ns.closeAll();
+
+        closeOutput(file);
+    }
+
     MessengerSrcVisitor(const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
         stringTypeName(stringTypeName),
         objectTypeName(objectTypeName),
@@ -1265,26 +1674,25 @@ public:
         {
             return;
         }
+        if (0 <= getContext()->unitySize)
+        {
+            interfaces.push_back(node);
+            return;
+        }
 
         std::string prefixedName = node->getPrefixedName();
-        FILE* file = createFile(prefixedName, objectTypeName, ".cpp");
+        FILE* file = createFile(node, prefixedName, objectTypeName, ".cpp");
         if (!file)
         {
             return;
         }
 
         // preamble
-        fprintf(file, "// Generated by esidl %s.\n\n", PACKAGE_VERSION);
-        fprintf(file, "#ifdef HAVE_CONFIG_H\n");
-        fprintf(file, "#include \"config.h\"\n");
-        fprintf(file, "#endif\n\n");
-        if (!node->isConstructor())
-        {
-            fprintf(file, "#include <%s>\n", createFileName(prefixedName, objectTypeName).c_str());
-        }
-        else
+        printPreamble(file);
+        fprintf(file, "#include <%s>\n", getHeaderName(node).c_str());
+        if (getContext()->useMinimalIncludes)
         {
-            fprintf(file, "#include <%s>\n", createFileName(node->getParent()->getPrefixedName(), objectTypeName).c_str());
+            fprintf(file, "#include <%s>\n", createFileName(getImpName(node), objectTypeName).c_str());
         }
 
         // body
@@ -1298,36 +1706,26 @@ public:
         import.printExtra();
         fprintf(file, "\n");
 
-        ns.enter(prefixedName);
-
-        MessengerStaticData messengerStaticData(file, stringTypeName, objectTypeName, useExceptions, indent);
-        messengerStaticData.at(node);
-        fprintf(file, "\n");
-
-        MessengerInvoke messengerInvoke(file, stringTypeName, objectTypeName, useExceptions, indent);
-        messengerInvoke.at(node);
-
-#ifdef USE_CONSTRUCTOR
-        if (Interface* constructor = node->getConstructor())
-        {
-            MessengerInvoke messengerInvoke(file, stringTypeName, objectTypeName, useExceptions, indent);
-            messengerInvoke.setConstructorMode(true);
-            messengerInvoke.at(constructor);
-        }
-#endif
+        printBody(file, &ns, node);
         ns.closeAll();
 
         // postable
-        fclose(file);
+        closeOutput(file);
+    }
+
+    void printUnits()
+    {
+        writeUnits(this, interfaces);
     }
 };
 
 int printMessengerSrc(const char* stringTypeName, const char* objectTypeName,
                       bool useExceptions, bool useVirtualBase, const char* indent)
 {
-    Messenger::useVirtualBase = useVirtualBase;
+    getContext()->useVirtualBase = useVirtualBase;
     MessengerSrcVisitor visitor(stringTypeName, objectTypeName, useExceptions, indent);
     getSpecification()->accept(&visitor);
+    visitor.printUnits();
     return 0;
 }
 
@@ -1356,6 +1754,7 @@ public:
             prefixedModuleName = currentNode->getPrefixedModuleName();
         }
         assert(!(node->getAttr() & Interface::Supplemental) && !node->isLeaf());
+        SizeProbe probe(getFile(), node, "MessengerImp");
 
         writetab();
         write("class %sImp : public ObjectMixin<%sImp",
@@ -1381,9 +1780,8 @@ public:
         indent();
 
         // Expand supplementals
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
+        const std::vector<const Interface*>& interfaceList = node->getExpandedSupplementals();
+        for (std::vector<const Interface*>::const_iterator i = interfaceList.begin();
              i != interfaceList.end();
              ++i)
         {
@@ -1399,10 +1797,20 @@ public:
 
         // Object
         writeln("// Object");
-        writeln("virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv) {");
-            writeln("return %s::dispatch(this, selector, id, argc, argv);",
-                    getScopedName(targetModuleName, getInterfaceName(node->getPrefixedName())).c_str());
-        writeln("}");
+        if (getContext()->useMinimalIncludes)
+        {
+            // Defined in the -messenger-src source file of the interface,
+            // which includes the definitions of the types the dispatcher
+            // converts to and from Any.
+            writeln("virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);");
+        }
+        else
+        {
+            writeln("virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv) {");
+                writeln("return %s::dispatch(this, selector, id, argc, argv);",
+                        getScopedName(targetModuleName, getInterfaceName(node->getPrefixedName())).c_str());
+            writeln("}");
+        }
 
 
         writeln("static const char* const getMetaData() {");
@@ -1487,7 +1895,7 @@ public:
 
         std::string prefixedName("::org::w3c::dom::bootstrap::");
         prefixedName += node->getName() + "Imp";
-        FILE* file = createFile(prefixedName, objectTypeName, ".h");
+        FILE* file = createFile(node, prefixedName, objectTypeName, ".h");
         if (!file)
         {
             return;
@@ -1532,12 +1940,15 @@ public:
         // body
         MessengerNameSpace ns(file, indent);
 
-        MessengerImport import(file, stringTypeName, objectTypeName, useExceptions, indent, &ns);
-        import.at(node);
-        // Include imported, i.e., forward declared, class definitions here
-        // so that template functions can be used without explicitly including
-        // the other generated files.
-        import.printExtra();
+        if (!getContext()->useMinimalIncludes)
+        {
+            MessengerImport import(file, stringTypeName, objectTypeName, useExceptions, indent, &ns);
+            import.at(node);
+            // Include imported, i.e., forward declared, class definitions here
+            // so that template functions can be used without explicitly including
+            // the other generated files.
+            import.printExtra();
+        }
         fprintf(file, "\n");
 
         ns.enter(prefixedName);
@@ -1549,14 +1960,14 @@ public:
 
         // postable
         fprintf(file, "\n#endif  // %s\n", included.c_str());
-        fclose(file);
+        closeOutput(file);
     }
 };
 
 int printMessengerImp(const char* stringTypeName, const char* objectTypeName,
                       bool useExceptions, bool useVirtualBase, const char* indent)
 {
-    Messenger::useVirtualBase = useVirtualBase;
+    getContext()->useVirtualBase = useVirtualBase;
     MessengerImpVisitor visitor(stringTypeName, objectTypeName, useExceptions, indent);
     getSpecification()->accept(&visitor);
     return 0;
@@ -1623,19 +2034,14 @@ public:
             }
         }
         assert(!(node->getAttr() & Interface::Supplemental) && !node->isLeaf());
+        SizeProbe probe(getFile(), node, "MessengerImpSrc");
 
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
-             i != interfaceList.end();
-             ++i)
+        const Interface::MergedMembers& members = node->getMergedMembers();
+        for (Interface::MergedMembers::const_iterator i = members.begin(); i != members.end(); ++i)
         {
             const Node* saved = currentNode;
-            currentNode = *i;
-            for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
-            {
-                visitInterfaceElement(*i, *j);
-            }
+            currentNode = i->interface;
+            visitInterfaceElement(i->interface, i->node);
             currentNode = saved;
         }
     }
@@ -1674,7 +2080,7 @@ public:
 
     virtual void at(const OpDcl* node)
     {
-        Interface* interface = dynamic_cast<Interface*>(node->getParent());
+        Interface* interface = dyn_cast<Interface>(node->getParent());
         assert(interface);
 
         writeln("");
@@ -1683,7 +2089,7 @@ public:
         noDefaultArgument = false;
         if (constructorMode)
         {
-            Interface* prototype = dynamic_cast<Interface*>(interface->getParent());
+            Interface* prototype = dyn_cast<Interface>(interface->getParent());
             if (prototype && prototype->getExtends())
             {
                 const char* separator = " : ";
@@ -1711,8 +2117,79 @@ class MessengerImpSrcVisitor : public Visitor
     std::string objectTypeName;
     bool useExceptions;
     std::string indent;
+    std::vector<const Interface*> interfaces;   // to be amalgamated with -unity
+
+    static std::string getPrefixedName(const Interface* node)
+    {
+        return "::org::w3c::dom::bootstrap::" + node->getName() + "Imp";
+    }
+
+    void printPreamble(FILE* file)
+    {
+        fprintf(file, "// Generated by esidl %s.\n", PACKAGE_VERSION);
+        fprintf(file, "// This file is expected to be modified for the Web IDL interface\n");
+        fprintf(file, "// implementation.  Permission to use, copy, modify and distribute\n");
+        fprintf(file, "// this file in any software license is hereby granted.\n\n");
+    }
 
 public:
+    std::string getUnitDirectory(const Interface* node) const
+    {
+        std::string filename = createFileName(getPrefixedName(node), objectTypeName);
+        return filename.substr(0, filename.rfind('/') + 1);
+    }
+
+    void printUnit(const std::string& directory, const Unit& unit)
+    {
+        FILE* file = createUnitFile(directory, unit);
+        if (!file)
+        {
+            return;
+        }
+
+        printPreamble(file);
+        for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+        {
+            fprintf(file, "#include \"%s.h\"\n", ((*i)->getName() + "Imp").c_str());
+        }
+
+        MessengerNameSpace ns(file, indent);
+
+        if (getContext()->useMinimalIncludes)
+        {
+            std::set<std::string> imports;
+            for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+            {
+                MessengerImport import(file, stringTypeName, objectTypeName, useExceptions, indent, &ns);
+                import.at(*i);
+                const NodeSet& importSet = import.getImportSet();
+                for (NodeSet::const_iterator j = importSet.begin(); j != importSet.end(); ++j)
+                {
+                    imports.insert(createFileName((*j)->getPrefixedName(), objectTypeName));
+                }
+            }
+            if (!imports.empty())
+            {
+                fprintf(file, "\n");
+            }
+            for (std::set<std::string>::const_iterator i = imports.begin(); i != imports.end(); ++i)
+            {
+                fprintf(file, "#include <%s>\n", i->c_str());
+            }
+        }
+        fprintf(file, "\n");
+
+        for (std::vector<const Interface*>::const_iterator i = unit.interfaces.begin(); i != unit.interfaces.end(); ++i)
+        {
+            ns.enter(getPrefixedName(*i));
+            MessengerImpSrc messengerImpSrc(file, stringTypeName, objectTypeName, useExceptions, indent);
+            messengerImpSrc.at(*i);
+        }
+        ns.closeAll();
+
+        closeOutput(file);
+    }
+
     MessengerImpSrcVisitor(const std::string& stringTypeName, const std::string& objectTypeName, bool useExceptions, const std::string& indent) :
         stringTypeName(stringTypeName),
         objectTypeName(objectTypeName),
@@ -1741,25 +2218,35 @@ public:
         {
             return;
         }
+        if (0 <= getContext()->unitySize)
+        {
+            interfaces.push_back(node);
+            return;
+        }
 
-        std::string prefixedName("::org::w3c::dom::bootstrap::");
-        prefixedName += node->getName() + "Imp";
-        FILE* file = createFile(prefixedName, objectTypeName, ".cpp");
+        std::string prefixedName = getPrefixedName(node);
+        FILE* file = createFile(node, prefixedName, objectTypeName, ".cpp");
         if (!file)
         {
             return;
         }
 
         // preamble
-        fprintf(file, "// Generated by esidl %s.\n", PACKAGE_VERSION);
-        fprintf(file, "// This file is expected to be modified for the Web IDL interface\n");
-        fprintf(file, "// implementation.  Permission to use, copy, modify and distribute\n");
-        fprintf(file, "// this file in any software license is hereby granted.\n\n");
-        fprintf(file, "#include \"%s.h\"\n\n", (node->getName() + "Imp").c_str());
+        printPreamble(file);
+        fprintf(file, "#include \"%s.h\"\n", (node->getName() + "Imp").c_str());
 
         // body
         MessengerNameSpace ns(file, indent);
 
+        if (getContext()->useMinimalIncludes)
+        {
+            // The header only forward declares the imported classes.
+            MessengerImport import(file, stringTypeName, objectTypeName, useExceptions, indent, &ns);
+            import.at(node);
+            import.printExtra();
+        }
+        fprintf(file, "\n");
+
         ns.enter(prefixedName);
 
         MessengerImpSrc messengerImpSrc(file, stringTypeName, objectTypeName, useExceptions, indent);
@@ -1768,15 +2255,21 @@ public:
         ns.closeAll();
 
         // postable
-        fclose(file);
+        closeOutput(file);
+    }
+
+    void printUnits()
+    {
+        writeUnits(this, interfaces);
     }
 };
 
 int printMessengerImpSrc(const char* stringTypeName, const char* objectTypeName,
                          bool useExceptions, bool useVirtualBase, const char* indent)
 {
-    Messenger::useVirtualBase = useVirtualBase;
+    getContext()->useVirtualBase = useVirtualBase;
     MessengerImpSrcVisitor visitor(stringTypeName, objectTypeName, useExceptions, indent);
     getSpecification()->accept(&visitor);
+    visitor.printUnits();
     return 0;
 }
@@ -26,25 +26,41 @@
  * http://dev.w3.org/2006/webapi/WebIDL/
  */
 
-%{
+%code requires
+{
 
 #include "esidl.h"
 
-extern FILE* yyin;
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
 
-void yyerror(const char* message, ...);
+}
 
-extern "C" int yywrap()
+%code provides
 {
-    return 1;
-}
 
-static long stdinOffset;
-static long stdinLine;
+int yylex(YYSTYPE* yylval, YYLTYPE* yylloc, yyscan_t scanner);
+int yylex_init_extra(Context* context, yyscan_t* scanner);
+int yylex_destroy(yyscan_t scanner);
+void yyset_in(FILE* in, yyscan_t scanner);
 
-%}
+int yyparse(yyscan_t scanner);
+void yyerror(YYLTYPE* location, yyscan_t scanner, const char* message);
 
+}
+
+%define api.pure full
 %locations
+%lex-param { yyscan_t scanner }
+%parse-param { yyscan_t scanner }
+
+%initial-action
+{
+    @$.first_line = @$.last_line = 1;
+    @$.first_column = @$.last_column = 0;
+}
 
 %union
 {
@@ -56,12 +72,6 @@ static long stdinLine;
     std::list<std::string>* nameList;
 }
 
-%{
-
-int yylex();
-
-%}
-
 %token ANY
 %token ATTRIBUTE
 %token BOOLEAN
@@ -260,7 +270,7 @@ Module :
                 Node* node = getCurrent()->search($2);
                 if (node)
                 {
-                    if (Module* module = dynamic_cast<Module*>(node))
+                    if (Module* module = dyn_cast<Module>(node))
                     {
                         setCurrent(module);
                     }
@@ -269,7 +279,7 @@ Module :
                         fprintf(stderr, "%d.%d-%d.%d: '%s' is not a valid module name.\n",
                                 @1.first_line, @1.first_column, @2.last_line, @2.last_column,
                                 $2);
-                        exit(EXIT_FAILURE);
+                        throw CompilationError();
                     }
                 }
                 else
@@ -296,10 +306,10 @@ CallbackOrInterface :
         {
             if ($2)
             {
-                if (Interface* node = dynamic_cast<Interface*>($2)) {
+                if (Interface* node = dyn_cast<Interface>($2)) {
                     node->setAttr(node->getAttr() | Interface::Callback);
                     $$ = $2;
-                } else if (OpDcl* op = dynamic_cast<OpDcl*>($2)) {
+                } else if (OpDcl* op = dyn_cast<OpDcl>($2)) {
                     Node* node = op->getParent();
                     node->setAttr(node->getAttr() | Interface::CallbackIsFunctionOnly);
                     $$ = node;
@@ -360,7 +370,7 @@ Interface :
             setCurrent(getCurrent()->getParent());
             if (Node::getFlatNamespace() && getCurrent() == getSpecification())
             {
-                setCurrent(dynamic_cast<Module*>(getSpecification()->search(Node::getFlatNamespace())));
+                setCurrent(dyn_cast<Module>(getSpecification()->search(Node::getFlatNamespace())));
             }
         }
     ;
@@ -398,7 +408,7 @@ PartialInterface :
             setCurrent(getCurrent()->getParent());
             if (Node::getFlatNamespace() && getCurrent() == getSpecification())
             {
-                setCurrent(dynamic_cast<Module*>(getSpecification()->search(Node::getFlatNamespace())));
+                setCurrent(dyn_cast<Module>(getSpecification()->search(Node::getFlatNamespace())));
             }
         }
     ;
@@ -457,7 +467,7 @@ Dictionary :
             setCurrent(getCurrent()->getParent());
             if (Node::getFlatNamespace() && getCurrent() == getSpecification())
             {
-                setCurrent(dynamic_cast<Module*>(getSpecification()->search(Node::getFlatNamespace())));
+                setCurrent(dyn_cast<Module>(getSpecification()->search(Node::getFlatNamespace())));
             }
         }
     ;
@@ -513,7 +523,7 @@ PartialDictionary :
             setCurrent(getCurrent()->getParent());
             if (Node::getFlatNamespace() && getCurrent() == getSpecification())
             {
-                setCurrent(dynamic_cast<Module*>(getSpecification()->search(Node::getFlatNamespace())));
+                setCurrent(dyn_cast<Module>(getSpecification()->search(Node::getFlatNamespace())));
             }
         }
     ;
@@ -604,7 +614,7 @@ Enum :
             setCurrent(getCurrent()->getParent());
             if (Node::getFlatNamespace() && getCurrent() == getSpecification())
             {
-                setCurrent(dynamic_cast<Module*>(getSpecification()->search(Node::getFlatNamespace())));
+                setCurrent(dyn_cast<Module>(getSpecification()->search(Node::getFlatNamespace())));
             }
         }
     ;
@@ -656,7 +666,7 @@ CallbackRest :
             setCurrent(getCurrent()->getParent()->getParent());
             if (Node::getFlatNamespace() && getCurrent() == getSpecification())
             {
-                setCurrent(dynamic_cast<Module*>(getSpecification()->search(Node::getFlatNamespace())));
+                setCurrent(dyn_cast<Module>(getSpecification()->search(Node::getFlatNamespace())));
             }
 
             free($1);
@@ -668,7 +678,7 @@ Typedef :
         {
             Member* m = new Member($3);
             // In flat namespace mode, even a valid typedef can define a new type for the spec using the exactly same name.
-            if (!dynamic_cast<ScopedName*>($2) || m->getQualifiedName() != $2->getQualifiedName())
+            if (!dyn_cast<ScopedName>($2) || m->getQualifiedName() != $2->getQualifiedName())
             {
                 m->setSpec($2);
                 m->setTypedef(true);
@@ -947,7 +957,7 @@ Operation :
                 }
                 if ($1 & OpDcl::IndexMask)
                 {
-                    Node* spec = dynamic_cast<ParamDcl*>(*(op->begin()))->getSpec();
+                    Node* spec = dyn_cast<ParamDcl>(*(op->begin()))->getSpec();
                     op->check(spec->getName() == "unsigned long" || spec->getName() == "string",
                               "The first argument MUST be an unsigned long or a DOMString.");
                 }
@@ -1792,8 +1802,8 @@ Preprocessor :
             }
             if (strcmp($3, "\"<stdin>\"") == 0)
             {
-                stdinLine = atol($2);
-                yylloc.last_line = stdinLine - stdinOffset;
+                getContext()->stdinLine = atol($2);
+                yylloc.last_line = getContext()->stdinLine - getContext()->stdinOffset;
             }
             else
             {
@@ -1813,7 +1823,7 @@ Preprocessor :
             free($3);
             free($4);
             $$ = 0;
-            stdinOffset = stdinLine;
+            getContext()->stdinOffset = getContext()->stdinLine;
             yylloc.last_line = 1;
         }
     ;
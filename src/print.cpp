@@ -148,7 +148,7 @@ public:
             printf(", ");
             node->getMax()->accept(this);
         }
-        else if (dynamic_cast<SequenceType*>(node->getSpec()))  // avoid >>
+        else if (dyn_cast<SequenceType>(node->getSpec()))  // avoid >>
         {
             printf(" ");
         }
@@ -248,11 +248,11 @@ public:
         printf("%s", node->getName().c_str());
         if (Node* details = node->getDetails())
         {
-            if (ScopedName* scopedName = dynamic_cast<ScopedName*>(details))
+            if (ScopedName* scopedName = dyn_cast<ScopedName>(details))
             {
                 printf(" = %s", scopedName->getName().c_str());
             }
-            // TODO: else if (OpDcl* op = dynamic_cast<OpDcl*>(details))
+            // TODO: else if (OpDcl* op = dyn_cast<OpDcl>(details))
         }
     }
 };
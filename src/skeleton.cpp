@@ -59,7 +59,8 @@ public:
              interface && !interface->isBaseObject();
              interface = interface->getSuper())
         {
-            interface->collectSupplementals(&interfaceList);
+            const std::vector<const Interface*>& list = interface->getExpandedSupplementals();
+            interfaceList.insert(interfaceList.begin(), list.begin(), list.end());
         }
 
         writeln("class %s_Impl : public %s {", node->getName().c_str(), node->getName().c_str());
@@ -75,11 +76,11 @@ public:
             {
                 for (NodeList::iterator i = interface->begin(); i != interface->end(); ++i)
                 {
-                    if (Attribute* attr = dynamic_cast<Attribute*>(*i))
+                    if (Attribute* attr = dyn_cast<Attribute>(*i))
                     {
                         idSet.insert(attr->getName());
                     }
-                    else if (OpDcl* op = dynamic_cast<OpDcl*>(*i))
+                    else if (OpDcl* op = dyn_cast<OpDcl>(*i))
                     {
                         if ((op->getAttr() & OpDcl::IndexMask) && (op->getAttr() & OpDcl::Omittable))
                         {
@@ -112,11 +113,11 @@ public:
                 currentNode = interface;
                 for (NodeList::iterator i = interface->begin(); i != interface->end(); ++i)
                 {
-                    if (Attribute* attr = dynamic_cast<Attribute*>(*i))
+                    if (Attribute* attr = dyn_cast<Attribute>(*i))
                     {
                         attr->accept(this);
                     }
-                    else if (OpDcl* op = dynamic_cast<OpDcl*>(*i))
+                    else if (OpDcl* op = dyn_cast<OpDcl>(*i))
                     {
                         optionalStage = 0;
                         do
@@ -158,9 +159,9 @@ public:
 
         if (node->isPutForwards())
         {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(scope));
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(scope));
             assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
             assert(forwards);
             spec = forwards->getSpec();
             scope = target;
@@ -172,7 +173,7 @@ public:
 
     virtual void at(const OpDcl* node)
     {
-        Interface* interface = dynamic_cast<Interface*>(node->getParent());
+        Interface* interface = dyn_cast<Interface>(node->getParent());
         assert(interface);
 
         writetab();
@@ -246,9 +247,9 @@ public:
         filename.insert(begin, getFileName(node->getName()));
         filename.insert(begin, "_");
         filename = getOutputFilename(filename.c_str(), "skeleton.h");
-        printf("# %s in %s\n", filename.c_str(), moduleName.c_str());
+        logOutput("# %s in %s\n", filename.c_str(), moduleName.c_str());
 
-        FILE* file = fopen(filename.c_str(), "w");
+        FILE* file = openOutput(filename, node);
         if (!file)
         {
             return;
@@ -273,7 +274,7 @@ public:
         {
             size_t next = moduleName.find("::", pos + 2);
             fprintf(file, "namespace %s\n{\n\n",
-                    moduleName.substr(pos + 2, (next == std::string::npos) ? std::string::npos : next - pos).c_str());
+                    moduleName.substr(pos + 2, (next == std::string::npos) ? std::string::npos : next - pos - 2).c_str());
             pos += 2;
         }
 
@@ -281,17 +282,17 @@ public:
         SkeletonImpl.at(node);
         SkeletonImpl.flush();
 
-        pos = std::string::npos;
-        while (pos && (pos = moduleName.rfind("::", pos)) != std::string::npos)
+        pos = moduleName.size();
+        while (0 < pos && (pos = moduleName.rfind("::", pos - 1)) != std::string::npos)
         {
             size_t next = moduleName.find("::", pos + 2);
             fprintf(file, "\n}  // namespace %s\n",
-                    moduleName.substr(pos + 2, (next == std::string::npos) ? std::string::npos : next - pos).c_str());
+                    moduleName.substr(pos + 2, (next == std::string::npos) ? std::string::npos : next - pos - 2).c_str());
         }
 
         fprintf(file, "\n#endif  // %s\n", included.c_str());
 
-        fclose(file);
+        closeOutput(file);
     }
 };
 
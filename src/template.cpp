@@ -58,8 +58,8 @@ class TemplateVisitor : public Cxx
 
 public:
     TemplateVisitor(const char* source, FILE* file, const char* stringTypeName = "char*", const char* objectTypeName = "object",
-                    bool useExceptions = true, const char* indent = "es") :
-        Cxx(source, file, stringTypeName, objectTypeName, useExceptions, indent)
+                    bool useExceptions = true, const char* indent = "es", const char* stringViewTypeName = "") :
+        Cxx(source, file, stringTypeName, objectTypeName, useExceptions, indent, stringViewTypeName)
     {
     }
 
@@ -73,6 +73,7 @@ public:
         {
             return;
         }
+        SizeProbe probe(getFile(), node, "TemplateVisitor");
 
         writeln("template<class P, Any (*invoke)(P, const char*, unsigned, unsigned, unsigned, Any*), class O = %s, unsigned B = 0>",
                 node->getName().c_str());
@@ -115,10 +116,9 @@ public:
         writeln("public:");
         indent();
 
-        std::list<const Interface*> interfaceList;
-        node->collectSupplementals(&interfaceList);
+        const std::vector<const Interface*>& interfaceList = node->getExpandedSupplementals();
         methodNumber = 0;
-        for (std::list<const Interface*>::const_iterator i = interfaceList.begin();
+        for (std::vector<const Interface*>::const_iterator i = interfaceList.begin();
              i != interfaceList.end();
              ++i)
         {
@@ -129,11 +129,11 @@ public:
             writeln("// %s", (*i)->getName().c_str());
             for (NodeList::iterator j = (*i)->begin(); j != (*i)->end(); ++j)
             {
-                if (Attribute* attr = dynamic_cast<Attribute*>(*j))
+                if (Attribute* attr = dyn_cast<Attribute>(*j))
                 {
                     attr->accept(this);
                 }
-                else if (OpDcl* op = dynamic_cast<OpDcl*>(*j))
+                else if (OpDcl* op = dyn_cast<OpDcl>(*j))
                 {
                     optionalStage = 0;
                     do
@@ -232,9 +232,9 @@ public:
 
         if (node->isPutForwards())
         {
-            Interface* target = dynamic_cast<Interface*>(dynamic_cast<ScopedName*>(spec)->search(scope));
+            Interface* target = dyn_cast<Interface>(dyn_cast<ScopedName>(spec)->search(scope));
             assert(target);
-            Attribute* forwards = dynamic_cast<Attribute*>(target->search(node->getPutForwards()));
+            Attribute* forwards = dyn_cast<Attribute>(target->search(node->getPutForwards()));
             assert(forwards);
             spec = forwards->getSpec();
             scope = target;
@@ -282,7 +282,7 @@ public:
 
     virtual void at(const OpDcl* node)
     {
-        Interface* interface = dynamic_cast<Interface*>(node->getParent());
+        Interface* interface = dyn_cast<Interface>(node->getParent());
         assert(interface);
 
         writetab();
@@ -312,7 +312,7 @@ public:
                  paramIndex < getParamCount();
                  ++i, ++paramIndex)
             {
-                ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+                ParamDcl* param = dyn_cast<ParamDcl>(*i);
                 assert(param);
                 Node* paramSpec = param->getSpec();
                 if (param->isVariadic() || paramSpec->isSequence(node))
@@ -338,7 +338,7 @@ public:
                  paramIndex < getParamCount();
                  ++i, ++paramIndex)
             {
-                ParamDcl* param = dynamic_cast<ParamDcl*>(*i);
+                ParamDcl* param = dyn_cast<ParamDcl>(*i);
                 assert(param);
                 Node* paramSpec = param->getSpec();
                 if (param->isVariadic() || paramSpec->isSequence(node))
@@ -398,13 +398,13 @@ public:
     }
 };
 
-void printTemplate(const char* source, const char* stringTypeName, const char* objectTypeName,
+void printTemplate(const char* source, const char* stringTypeName, const char* stringViewTypeName, const char* objectTypeName,
                    bool useExceptions, bool isystem, const char* indent)
 {
     std::string filename = getOutputFilename(source, "template.h");
-    printf("# %s\n", filename.c_str());
+    logOutput("# %s\n", filename.c_str());
 
-    FILE* file = fopen(filename.c_str(), "w");
+    FILE* file = openOutput(filename, source);
     if (!file)
     {
         return;
@@ -426,10 +426,10 @@ void printTemplate(const char* source, const char* stringTypeName, const char* o
         fprintf(file, "#include \"%s\"\n\n", header.c_str());
     }
 
-    TemplateVisitor visitor(source, file, stringTypeName, objectTypeName, useExceptions, indent);
+    TemplateVisitor visitor(source, file, stringTypeName, objectTypeName, useExceptions, indent, stringViewTypeName);
     getSpecification()->accept(&visitor);
 
     fprintf(file, "#endif  // %s\n", included.c_str());
 
-    fclose(file);
+    closeOutput(file);
 }
@@ -0,0 +1,328 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "watcher.h"
+
+#include <sys/inotify.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <set>
+
+namespace
+{
+
+double getTime()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+bool readFile(const std::string& filename, std::string& contents)
+{
+    FILE* file = fopen(filename.c_str(), "r");
+    if (!file)
+    {
+        return false;
+    }
+    contents.clear();
+    char buffer[4096];
+    size_t size;
+    while (0 < (size = fread(buffer, 1, sizeof buffer, file)))
+    {
+        contents.append(buffer, size);
+    }
+    fclose(file);
+    return true;
+}
+
+void splitPath(const std::string& path, std::string& dir, std::string& name)
+{
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos)
+    {
+        dir = ".";
+        name = path;
+    }
+    else
+    {
+        dir = (slash == 0) ? "/" : path.substr(0, slash);
+        name = path.substr(slash + 1);
+    }
+}
+
+}  // namespace
+
+Watcher::Watcher(const Compiler::Options& options, const std::vector<std::string>& files, Compiler::Target target) :
+    options(options),
+    files(files),
+    target(target),
+    compiler(0),
+    inputs(files.begin(), files.end())
+{
+}
+
+Watcher::~Watcher()
+{
+    delete compiler;
+}
+
+// Compiles the IDL files from scratch with a new Compiler.
+bool Watcher::compile(Compiler::Outputs& result)
+{
+    delete compiler;
+    compiler = new Compiler(options);
+    if (!compiler->parse(files) || !compiler->resolve() || !compiler->generate(target, &result))
+    {
+        delete compiler;
+        compiler = 0;
+        return false;
+    }
+    return true;
+}
+
+unsigned Watcher::write(const Compiler::Outputs& result)
+{
+    // Write the files through the default context under the same root as
+    // the compiler would.
+    getContext()->outputRoot = options.outputRoot;
+    unsigned count = 0;
+    for (Compiler::Outputs::const_iterator i = result.begin(); i != result.end(); ++i)
+    {
+        Compiler::Outputs::const_iterator previous = outputs.find(i->first);
+        if (previous != outputs.end())
+        {
+            if (previous->second == i->second)
+            {
+                continue;
+            }
+        }
+        else if (i->first != "-")
+        {
+            // Leave the files written by an earlier run of esidl untouched.
+            std::string contents;
+            if (readFile(options.outputRoot.empty() ? i->first : options.outputRoot + '/' + i->first, contents) &&
+                contents == i->second)
+            {
+                continue;
+            }
+        }
+
+        if (i->first == "-")
+        {
+            fwrite(i->second.data(), 1, i->second.size(), stdout);
+            fflush(stdout);
+        }
+        else
+        {
+            logOutput("# %s\n", i->first.c_str());
+            FILE* file = openOutput(i->first);
+            if (!file)
+            {
+                fprintf(stderr, "esidl: cannot write '%s'\n", i->first.c_str());
+                continue;
+            }
+            fwrite(i->second.data(), 1, i->second.size(), file);
+            closeOutput(file);
+        }
+        ++count;
+    }
+
+    // Remove the files the last compilation has written but this one has
+    // not, like the units of -unity no longer needed.
+    for (Compiler::Outputs::const_iterator i = outputs.begin(); i != outputs.end(); ++i)
+    {
+        if (i->first != "-" && !result.count(i->first) &&
+            unlink((options.outputRoot.empty() ? i->first : options.outputRoot + '/' + i->first).c_str()) == 0)
+        {
+            logOutput("# %s removed\n", i->first.c_str());
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool Watcher::update()
+{
+    std::map<std::string, std::string> current;
+    for (std::set<std::string>::const_iterator i = inputs.begin(); i != inputs.end(); ++i)
+    {
+        // A file being replaced by an editor may be missing for a moment;
+        // the compilation reports it if it stays missing.
+        readFile(*i, current[*i]);
+    }
+    if (!sources.empty() && current == sources)
+    {
+        return true;
+    }
+    std::vector<std::string> modified;
+    for (std::map<std::string, std::string>::const_iterator i = current.begin(); i != current.end(); ++i)
+    {
+        std::map<std::string, std::string>::const_iterator previous = sources.find(i->first);
+        if (previous == sources.end() || previous->second != i->second)
+        {
+            modified.push_back(i->first);
+        }
+    }
+    sources.swap(current);
+
+    double start = getTime();
+    Compiler::Outputs result;
+    bool updated = false;
+    if (compiler)
+    {
+        result = outputs;
+        updated = compiler->update(modified, target, &result);
+        if (!updated)
+        {
+            delete compiler;
+            compiler = 0;
+            result.clear();
+        }
+    }
+    if (!updated && !compile(result))
+    {
+        // Keep watching the files included by the last successful
+        // compilation.
+        fprintf(stderr, "esidl: compilation failed; the outputs are left unchanged\n");
+        return false;
+    }
+    std::set<std::string> included;
+    compiler->getSources(&included);
+    if (included != inputs)
+    {
+        inputs.swap(included);
+        inputs.insert(files.begin(), files.end());
+        for (std::set<std::string>::const_iterator i = inputs.begin(); i != inputs.end(); ++i)
+        {
+            if (sources.find(*i) == sources.end())
+            {
+                readFile(*i, sources[*i]);
+            }
+        }
+        for (std::map<std::string, std::string>::iterator i = sources.begin(); i != sources.end(); )
+        {
+            if (inputs.count(i->first))
+            {
+                ++i;
+            }
+            else
+            {
+                sources.erase(i++);
+            }
+        }
+    }
+    unsigned count = write(result);
+    fflush(stdout);
+    fprintf(stderr, "esidl: %u of %zu files updated in %.3f sec%s\n", count, result.size(), getTime() - start,
+            updated ? "" : " (full compilation)");
+    outputs.swap(result);
+    return true;
+}
+
+// Watches the directories of the inputs rather than the files themselves,
+// since many editors save a file by renaming a new one over it.
+bool Watcher::watch(int fd)
+{
+    bool result = true;
+    for (std::set<std::string>::const_iterator i = inputs.begin(); i != inputs.end(); ++i)
+    {
+        if (!tried.insert(*i).second)
+        {
+            continue;
+        }
+        std::string dir;
+        std::string name;
+        splitPath(*i, dir, name);
+        int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd == -1)
+        {
+            fprintf(stderr, "esidl: cannot watch '%s': %s\n", dir.c_str(), strerror(errno));
+            result = false;
+            continue;
+        }
+        watched.insert(std::make_pair(wd, name));
+    }
+    return result;
+}
+
+int Watcher::run()
+{
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd == -1)
+    {
+        fprintf(stderr, "esidl: cannot initialize inotify: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    if (!watch(fd))
+    {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    update();
+    for (;;)
+    {
+        // Watch the files newly included as well. A directory that cannot
+        // be watched is reported once, and its files are checked when the
+        // other files change.
+        watch(fd);
+
+        int timeout = -1;
+        for (;;)
+        {
+            // Once a watched file has been modified, wait for the other
+            // files saved at the same time before compiling them.
+            pollfd pfd = { fd, POLLIN, 0 };
+            int n = poll(&pfd, 1, timeout);
+            if (n == 0)
+            {
+                break;
+            }
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                fprintf(stderr, "esidl: %s\n", strerror(errno));
+                close(fd);
+                return EXIT_FAILURE;
+            }
+            char buffer[4096] __attribute__ ((aligned(__alignof__(inotify_event))));
+            ssize_t size = read(fd, buffer, sizeof buffer);
+            if (size <= 0)
+            {
+                continue;
+            }
+            for (char* p = buffer; p < buffer + size; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len)
+            {
+                inotify_event* event = reinterpret_cast<inotify_event*>(p);
+                if (0 < event->len && watched.find(std::make_pair(event->wd, std::string(event->name))) != watched.end())
+                {
+                    timeout = 100;
+                }
+            }
+        }
+        update();
+    }
+}
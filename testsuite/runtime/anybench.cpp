@@ -0,0 +1,444 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// anybench - counts the memory allocations per call made through the code
+// esidl generates for the messenger targets, with and without -fmove.
+//
+// Usage: anybench [-t SECONDS]
+//
+// The runtime of the messenger targets is not a part of esidl, so this
+// program defines a minimal Any holding a string. The Any in namespace copy
+// can only be copied; the Any in namespace move can also be moved and has
+// the rvalue accessors the code generated with -fmove relies on. The stubs
+// in each namespace are written as esidl generates them for
+//
+//     interface Document {
+//         attribute DOMString title;
+//         DOMString normalize(any value);
+//     };
+//
+// with -string std::u16string, the latter with -fmove. Each benchmark is
+// repeated with a doubling iteration count until it runs for at least
+// SECONDS (0.5 by default), and the time and the allocations per call are
+// reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace
+{
+
+unsigned long allocations;
+
+}  // namespace
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    if (void* p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+
+// Long enough not to fit in the small string buffer.
+const std::u16string title(u"A title long enough to be allocated on the heap");
+
+const int GETTER_ = -1;
+const int SETTER_ = -2;
+
+namespace copy
+{
+
+class Any
+{
+    std::u16string value;
+
+public:
+    Any()
+    {
+    }
+
+    Any(const Any& other) :
+        value(other.value)
+    {
+    }
+
+    Any(const std::u16string& value) :
+        value(value)
+    {
+    }
+
+    Any& operator=(const Any& other)
+    {
+        value = other.value;
+        return *this;
+    }
+
+    std::u16string toString() const
+    {
+        return value;
+    }
+};
+
+class DocumentImp
+{
+    std::u16string title;
+
+public:
+    std::u16string getTitle()
+    {
+        return title;
+    }
+
+    void setTitle(const std::u16string& title)
+    {
+        this->title = title;
+    }
+
+    std::u16string normalize(Any value)
+    {
+        return value.toString();
+    }
+};
+
+Any dispatch(DocumentImp* self, unsigned selector, int argumentCount, Any* arguments)
+{
+    switch (selector)
+    {
+    case 0x1:
+        if (argumentCount == GETTER_)
+            return self->getTitle();
+        if (argumentCount == SETTER_)
+        {
+            self->setTitle(arguments[0].toString());
+            return Any();
+        }
+        return Any();
+    case 0x2:
+        if (argumentCount == 1)
+        {
+            return self->normalize(arguments[0]);
+        }
+        return Any();
+    default:
+        return Any();
+    }
+}
+
+class Document
+{
+    DocumentImp* self;
+
+    Any message_(unsigned selector, const char* id, int argumentCount, Any* arguments)
+    {
+        return dispatch(self, selector, argumentCount, arguments);
+    }
+
+public:
+    Document(DocumentImp* self) :
+        self(self)
+    {
+    }
+
+    std::u16string getTitle()
+    {
+        return message_(0x1, "title", GETTER_, 0).toString();
+    }
+
+    void setTitle(const std::u16string& title)
+    {
+        Any argument_ = title;
+        message_(0x1, "title", SETTER_, &argument_);
+    }
+
+    std::u16string normalize(Any value)
+    {
+        Any arguments_[1];
+        arguments_[0] = value;
+        return message_(0x2, "normalize", 1, arguments_).toString();
+    }
+};
+
+}  // namespace copy
+
+namespace move
+{
+
+class Any
+{
+    std::u16string value;
+
+public:
+    Any()
+    {
+    }
+
+    Any(const Any& other) :
+        value(other.value)
+    {
+    }
+
+    Any(Any&& other) :
+        value(std::move(other.value))
+    {
+    }
+
+    Any(const std::u16string& value) :
+        value(value)
+    {
+    }
+
+    Any(std::u16string&& value) :
+        value(std::move(value))
+    {
+    }
+
+    Any& operator=(const Any& other)
+    {
+        value = other.value;
+        return *this;
+    }
+
+    Any& operator=(Any&& other)
+    {
+        value = std::move(other.value);
+        return *this;
+    }
+
+    std::u16string toString() const &
+    {
+        return value;
+    }
+
+    std::u16string toString() &&
+    {
+        return std::move(value);
+    }
+};
+
+class DocumentImp
+{
+    std::u16string title;
+
+public:
+    std::u16string getTitle()
+    {
+        return title;
+    }
+
+    void setTitle(const std::u16string& title)
+    {
+        this->title = title;
+    }
+
+    std::u16string normalize(Any value)
+    {
+        return std::move(value).toString();
+    }
+};
+
+Any dispatch(DocumentImp* self, unsigned selector, int argumentCount, Any* arguments)
+{
+    switch (selector)
+    {
+    case 0x1:
+        if (argumentCount == GETTER_)
+            return self->getTitle();
+        if (argumentCount == SETTER_)
+        {
+            self->setTitle(std::move(arguments[0]).toString());
+            return Any();
+        }
+        return Any();
+    case 0x2:
+        if (argumentCount == 1)
+        {
+            return self->normalize(std::move(arguments[0]));
+        }
+        return Any();
+    default:
+        return Any();
+    }
+}
+
+class Document
+{
+    DocumentImp* self;
+
+    Any message_(unsigned selector, const char* id, int argumentCount, Any* arguments)
+    {
+        return dispatch(self, selector, argumentCount, arguments);
+    }
+
+public:
+    Document(DocumentImp* self) :
+        self(self)
+    {
+    }
+
+    std::u16string getTitle()
+    {
+        return message_(0x1, "title", GETTER_, 0).toString();
+    }
+
+    void setTitle(const std::u16string& title)
+    {
+        Any argument_ = title;
+        message_(0x1, "title", SETTER_, &argument_);
+    }
+
+    std::u16string normalize(Any value)
+    {
+        Any arguments_[1] =
+        {
+            std::move(value)
+        };
+        return message_(0x2, "normalize", 1, arguments_).toString();
+    }
+};
+
+}  // namespace move
+
+// Accumulates the results so that the compiler cannot optimize the calls
+// away.
+volatile unsigned long sink;
+
+double getTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+template <class D, class I>
+void getTitle(unsigned long iterations)
+{
+    I imp;
+    D document(&imp);
+    document.setTitle(title);
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        sink += document.getTitle().size();
+    }
+}
+
+template <class D, class I>
+void setTitle(unsigned long iterations)
+{
+    I imp;
+    D document(&imp);
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        document.setTitle(title);
+    }
+    sink += document.getTitle().size();
+}
+
+template <class D, class I, class A>
+void normalize(unsigned long iterations)
+{
+    I imp;
+    D document(&imp);
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        sink += document.normalize(A(title)).size();
+    }
+}
+
+// Each benchmark makes the specified number of calls.
+typedef void (*Function)(unsigned long iterations);
+
+struct Benchmark
+{
+    const char* name;
+    Function function;
+};
+
+const Benchmark benchmarks[] =
+{
+    { "BM_GetString/copy", getTitle<copy::Document, copy::DocumentImp> },
+    { "BM_GetString/move", getTitle<move::Document, move::DocumentImp> },
+    { "BM_SetString/copy", setTitle<copy::Document, copy::DocumentImp> },
+    { "BM_SetString/move", setTitle<move::Document, move::DocumentImp> },
+    { "BM_PassAny/copy", normalize<copy::Document, copy::DocumentImp, copy::Any> },
+    { "BM_PassAny/move", normalize<move::Document, move::DocumentImp, move::Any> },
+};
+
+void run(const Benchmark& benchmark, double minTime)
+{
+    unsigned long iterations = 1;
+    unsigned long count;
+    double elapsed;
+    for (;;)
+    {
+        count = allocations;
+        double start = getTime();
+        benchmark.function(iterations);
+        elapsed = getTime() - start;
+        count = allocations - count;
+        if (minTime <= elapsed)
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+    printf("%-28s %12.2f ns %12.2f %12lu\n",
+           benchmark.name, elapsed * 1000000000.0 / iterations,
+           static_cast<double>(count) / iterations, iterations);
+    fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    double minTime = 0.5;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            minTime = atof(argv[++i]);
+        }
+    }
+
+    printf("%-28s %15s %12s %12s\n", "Benchmark", "Time/call", "Allocs/call", "Calls");
+    printf("-------------------------------------------------------------------\n");
+    for (size_t i = 0; i < sizeof benchmarks / sizeof benchmarks[0]; ++i)
+    {
+        run(benchmarks[i], minTime);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Copyright 2013 Esrille Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Generates the module units for moduleb.idl, which includes modulea.idl,
+# with both files on the command line, and compiles them in the order
+# listed in modules.txt. Each definition must be emitted only once.
+
+: ${CXX:=c++}
+: ${srcdir:=.}
+esidl=`pwd`/../../esidl
+dir=cxxmodule.dir
+
+# Skip the test unless the compiler supports C++20 modules.
+echo 'export module probe;' > cxxmodule-probe.cppm
+if ! $CXX -std=c++20 -fmodules-ts -x c++ -c cxxmodule-probe.cppm -o cxxmodule-probe.o 2>/dev/null
+then
+    rm -rf cxxmodule-probe.cppm cxxmodule-probe.o gcm.cache
+    exit 77
+fi
+rm -rf cxxmodule-probe.cppm cxxmodule-probe.o gcm.cache
+
+srcdir=`cd $srcdir && pwd`
+rm -rf $dir && mkdir $dir && cd $dir || exit 1
+$esidl -I $srcdir -cxx-module -module-prelude moduleprelude.h \
+    $srcdir/modulea.idl $srcdir/moduleb.idl || exit 1
+for unit in `cat modules.txt`
+do
+    $CXX -std=c++20 -fmodules-ts -I $srcdir -x c++ -c $unit -o `basename $unit .cppm`.o || exit 1
+done
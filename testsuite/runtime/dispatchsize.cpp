@@ -0,0 +1,215 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// dispatchsize - sends messages through the dispatchers esidl generates for
+// dispatchsize.idl, with or without -fdispatch-table.
+//
+// Usage: dispatchsize
+//
+// The program is built twice from this file, as dispatchsize-template
+// over the headers generated without -fdispatch-table and as
+// dispatchsize-table over the headers generated with it; 'make size'
+// checks that both print the same results, and reports the size of both
+// object files. As in the bootstrap namespace, each implementation class
+// in dispatchsize.h overrides message_() with the dispatcher of its
+// interface, which instantiates the dispatchers of the base interfaces for
+// the class, too.
+
+#include "dispatchsize.h"
+
+#include <stdlib.h>
+
+#include <org/w3c/dom/sample/HTMLDivElement.h>
+#include <org/w3c/dom/sample/HTMLSpanElement.h>
+#include <org/w3c/dom/sample/HTMLAnchorElement.h>
+#include <org/w3c/dom/sample/HTMLImageElement.h>
+#include <org/w3c/dom/sample/HTMLInputElement.h>
+
+using namespace org::w3c::dom;
+
+namespace bootstrap
+{
+
+Any NodeImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::Node::dispatch(this, selector, id, argc, argv);
+}
+
+Any ElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::Element::dispatch(this, selector, id, argc, argv);
+}
+
+Any HTMLElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::HTMLElement::dispatch(this, selector, id, argc, argv);
+}
+
+Any HTMLDivElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::HTMLDivElement::dispatch(this, selector, id, argc, argv);
+}
+
+Any HTMLSpanElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::HTMLSpanElement::dispatch(this, selector, id, argc, argv);
+}
+
+Any HTMLAnchorElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::HTMLAnchorElement::dispatch(this, selector, id, argc, argv);
+}
+
+Any HTMLImageElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::HTMLImageElement::dispatch(this, selector, id, argc, argv);
+}
+
+Any HTMLInputElementImp::message_(uint32_t selector, const char* id, int argc, Any* argv)
+{
+    return sample::HTMLInputElement::dispatch(this, selector, id, argc, argv);
+}
+
+}  // namespace bootstrap
+
+namespace
+{
+
+// The hash esidl computes for the selector of a member.
+uint32_t one_at_a_time(const char* key)
+{
+    uint32_t hash = 0;
+    for (; *key; ++key)
+    {
+        hash += *key;
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return hash;
+}
+
+void send(Imp* imp, const char* name, int argumentCount, Any* arguments = 0)
+{
+    Any result = imp->message_(name ? one_at_a_time(name) : 0, name, argumentCount, arguments);
+    printf("  %s %d: %s\n", name ? name : "", argumentCount, result.toString().c_str());
+}
+
+void set(Imp* imp, const char* name, const Any& value)
+{
+    Any argument = value;
+    send(imp, name, SETTER_, &argument);
+}
+
+void test(Imp* imp)
+{
+    static const char* const interfaces[] =
+    {
+        "::org::w3c::dom::sample::Node",
+        "::org::w3c::dom::sample::Element",
+        "::org::w3c::dom::sample::HTMLElement",
+        "::org::w3c::dom::sample::HTMLDivElement",
+        "::org::w3c::dom::sample::HTMLAnchorElement",
+        "::org::w3c::dom::sample::HTMLInputElement",
+    };
+    for (size_t i = 0; i < sizeof interfaces / sizeof interfaces[0]; ++i)
+    {
+        Any result = imp->message_(0, interfaces[i], IS_KIND_OF_, 0);
+        printf("  %s: %s\n", interfaces[i], result.toString().c_str());
+    }
+
+    send(imp, "ELEMENT_NODE", GETTER_);
+    send(imp, "nodeType", GETTER_);
+    send(imp, "nodeName", GETTER_);
+    send(imp, "tagName", GETTER_);
+    set(imp, "textContent", std::string("Hello"));
+    send(imp, "hasChildNodes", 0);
+    send(imp, "normalize", 0);
+    set(imp, "id", std::string("main"));
+    set(imp, "className", std::string("note"));
+    Any arguments[2] = { std::string("title"), std::string("Sample") };
+    send(imp, "setAttribute", 2, arguments);
+    send(imp, "getAttribute", 1, arguments);
+    send(imp, "hasAttribute", 1, arguments);
+    send(imp, "title", GETTER_);
+    send(imp, "removeAttribute", 1, arguments);
+    send(imp, "hasAttribute", 1, arguments);
+    arguments[0] = std::string("id");
+    send(imp, "getAttribute", 1, arguments);
+    send(imp, "className", GETTER_);
+    arguments[0] = true;
+    send(imp, "scroll", 1, arguments);
+    arguments[0] = 10.0;
+    arguments[1] = 20.0;
+    send(imp, "scroll", 2, arguments);
+    send(imp, "scroll", 3, arguments);
+    set(imp, "lang", std::string("en"));
+    send(imp, "lang", GETTER_);
+    set(imp, "hidden", true);
+    send(imp, "hidden", GETTER_);
+    set(imp, "tabIndex", 3);
+    send(imp, "tabIndex", GETTER_);
+    send(imp, "click", 0);
+    send(imp, "focus", 0);
+    arguments[0] = true;
+    send(imp, "focus", 1, arguments);
+    send(imp, "blur", 0);
+    send(imp, "blur", HAS_OPERATION_);
+
+    set(imp, "align", std::string("center"));
+    send(imp, "align", GETTER_);
+    set(imp, "href", std::string("http://www.example.com/"));
+    send(imp, "href", HAS_PROPERTY_);
+    send(imp, 0, STRINGIFY_);
+    set(imp, "target", std::string("_blank"));
+    send(imp, "target", GETTER_);
+    set(imp, "src", std::string("sample.png"));
+    set(imp, "width", 640u);
+    set(imp, "height", 480u);
+    send(imp, "src", GETTER_);
+    send(imp, "width", GETTER_);
+    send(imp, "height", GETTER_);
+    set(imp, "value", std::string("text"));
+    set(imp, "checked", true);
+    send(imp, "value", GETTER_);
+    send(imp, "checked", GETTER_);
+    send(imp, "select", 0);
+}
+
+}  // namespace
+
+int main()
+{
+    std::shared_ptr<Imp> imps[] =
+    {
+        std::make_shared<bootstrap::NodeImp>(),
+        std::make_shared<bootstrap::ElementImp>("section"),
+        std::make_shared<bootstrap::HTMLElementImp>("p"),
+        std::make_shared<bootstrap::HTMLDivElementImp>(),
+        std::make_shared<bootstrap::HTMLSpanElementImp>(),
+        std::make_shared<bootstrap::HTMLAnchorElementImp>(),
+        std::make_shared<bootstrap::HTMLImageElementImp>(),
+        std::make_shared<bootstrap::HTMLInputElementImp>(),
+    };
+    for (size_t i = 0; i < sizeof imps / sizeof imps[0]; ++i)
+    {
+        printf("imp %u\n", static_cast<unsigned>(i));
+        test(imps[i].get());
+    }
+    return EXIT_SUCCESS;
+}
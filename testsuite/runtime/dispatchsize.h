@@ -0,0 +1,306 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DISPATCHSIZE_H_INCLUDED
+#define DISPATCHSIZE_H_INCLUDED
+
+// The runtime of the messenger targets is not a part of esidl, so
+// dispatchsize defines a minimal Any, Imp and Object to include the
+// generated headers with, and the implementation classes of the interfaces
+// in dispatchsize.idl as the messenger-imp target declares them.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+const int GETTER_ = -1;
+const int SETTER_ = -2;
+const int HAS_PROPERTY_ = -3;
+const int HAS_OPERATION_ = -4;
+const int IS_KIND_OF_ = -5;
+const int STRINGIFY_ = -6;
+
+class Any
+{
+    enum Type
+    {
+        Undefined,
+        Boolean,
+        Number,
+        String
+    };
+
+    Type type;
+    double number;
+    std::string string;
+
+public:
+    Any() :
+        type(Undefined),
+        number(0.0)
+    {
+    }
+
+    Any(bool value) :
+        type(Boolean),
+        number(value)
+    {
+    }
+
+    Any(int value) :
+        type(Number),
+        number(value)
+    {
+    }
+
+    Any(unsigned int value) :
+        type(Number),
+        number(value)
+    {
+    }
+
+    Any(double value) :
+        type(Number),
+        number(value)
+    {
+    }
+
+    Any(const std::string& value) :
+        type(String),
+        number(0.0),
+        string(value)
+    {
+    }
+
+    operator bool() const
+    {
+        return number != 0.0;
+    }
+
+    operator int() const
+    {
+        return static_cast<int>(number);
+    }
+
+    operator unsigned int() const
+    {
+        return static_cast<unsigned int>(number);
+    }
+
+    operator double() const
+    {
+        return number;
+    }
+
+    std::string toString() const
+    {
+        char buffer[32];
+        switch (type)
+        {
+        case Boolean:
+            return number ? "true" : "false";
+        case Number:
+            snprintf(buffer, sizeof buffer, "%g", number);
+            return buffer;
+        case String:
+            return '"' + string + '"';
+        default:
+            return "undefined";
+        }
+    }
+};
+
+class Imp
+{
+public:
+    virtual ~Imp()
+    {
+    }
+
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv) = 0;
+};
+
+class Object
+{
+    std::shared_ptr<Imp> pimpl;
+
+public:
+    Object()
+    {
+    }
+
+    explicit Object(Imp* pimpl) :
+        pimpl(pimpl)
+    {
+    }
+
+    Object(const std::shared_ptr<Imp>& pimpl) :
+        pimpl(pimpl)
+    {
+    }
+
+    Object& operator=(const std::shared_ptr<Imp>& pimpl)
+    {
+        this->pimpl = pimpl;
+        return *this;
+    }
+
+    Any message_(uint32_t selector, const char* id, int argc, Any* argv)
+    {
+        return pimpl->message_(selector, id, argc, argv);
+    }
+};
+
+namespace bootstrap
+{
+
+class NodeImp : public Imp
+{
+    std::string textContent;
+
+public:
+    // Node
+    unsigned short getNodeType();
+    std::string getNodeName();
+    std::string getTextContent();
+    void setTextContent(const std::string& textContent);
+    bool hasChildNodes();
+    void normalize();
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class ElementImp : public NodeImp
+{
+    std::string tagName;
+    std::map<std::string, std::string> attributes;
+
+public:
+    ElementImp(const std::string& tagName);
+    // Element
+    std::string getTagName();
+    std::string getId();
+    void setId(const std::string& id);
+    std::string getClassName();
+    void setClassName(const std::string& className);
+    std::string getAttribute(const std::string& name);
+    void setAttribute(const std::string& name, const std::string& value);
+    void removeAttribute(const std::string& name);
+    bool hasAttribute(const std::string& name);
+    void scroll(bool alignToTop);
+    void scroll(double x, double y);
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class HTMLElementImp : public ElementImp
+{
+    bool hidden;
+    int tabIndex;
+
+public:
+    HTMLElementImp(const std::string& tagName);
+    // HTMLElement
+    std::string getTitle();
+    void setTitle(const std::string& title);
+    std::string getLang();
+    void setLang(const std::string& lang);
+    bool getHidden();
+    void setHidden(bool hidden);
+    int getTabIndex();
+    void setTabIndex(int tabIndex);
+    void click();
+    void focus();
+    void focus(bool preventScroll);
+    void blur();
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class HTMLDivElementImp : public HTMLElementImp
+{
+public:
+    HTMLDivElementImp();
+    // HTMLDivElement
+    std::string getAlign();
+    void setAlign(const std::string& align);
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class HTMLSpanElementImp : public HTMLElementImp
+{
+public:
+    HTMLSpanElementImp();
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class HTMLAnchorElementImp : public HTMLElementImp
+{
+public:
+    HTMLAnchorElementImp();
+    // HTMLAnchorElement
+    std::string getHref();
+    void setHref(const std::string& href);
+    std::string getTarget();
+    void setTarget(const std::string& target);
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class HTMLImageElementImp : public HTMLElementImp
+{
+    unsigned int width;
+    unsigned int height;
+
+public:
+    HTMLImageElementImp();
+    // HTMLImageElement
+    std::string getSrc();
+    void setSrc(const std::string& src);
+    unsigned int getWidth();
+    void setWidth(unsigned int width);
+    unsigned int getHeight();
+    void setHeight(unsigned int height);
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+class HTMLInputElementImp : public HTMLElementImp
+{
+    std::string value;
+    bool checked;
+
+public:
+    HTMLInputElementImp();
+    // HTMLInputElement
+    std::string getValue();
+    void setValue(const std::string& value);
+    bool getChecked();
+    void setChecked(bool checked);
+    void select();
+    // Object
+    virtual Any message_(uint32_t selector, const char* id, int argc, Any* argv);
+};
+
+}  // namespace bootstrap
+
+#endif  // DISPATCHSIZE_H_INCLUDED
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The implementation classes of dispatchsize, which are defined apart from
+// the dispatchers as in the messenger-imp-src target so that the members
+// called from the dispatchers are not inlined into them.
+
+#include "dispatchsize.h"
+
+namespace bootstrap
+{
+
+unsigned short NodeImp::getNodeType()
+{
+    return 1;
+}
+
+std::string NodeImp::getNodeName()
+{
+    return "#node";
+}
+
+std::string NodeImp::getTextContent()
+{
+    return textContent;
+}
+
+void NodeImp::setTextContent(const std::string& textContent)
+{
+    this->textContent = textContent;
+}
+
+bool NodeImp::hasChildNodes()
+{
+    return !textContent.empty();
+}
+
+void NodeImp::normalize()
+{
+    printf("  normalize()\n");
+}
+
+ElementImp::ElementImp(const std::string& tagName) :
+    tagName(tagName)
+{
+}
+
+std::string ElementImp::getTagName()
+{
+    return tagName;
+}
+
+std::string ElementImp::getId()
+{
+    return getAttribute("id");
+}
+
+void ElementImp::setId(const std::string& id)
+{
+    setAttribute("id", id);
+}
+
+std::string ElementImp::getClassName()
+{
+    return getAttribute("class");
+}
+
+void ElementImp::setClassName(const std::string& className)
+{
+    setAttribute("class", className);
+}
+
+std::string ElementImp::getAttribute(const std::string& name)
+{
+    std::map<std::string, std::string>::const_iterator i = attributes.find(name);
+    return (i != attributes.end()) ? i->second : "";
+}
+
+void ElementImp::setAttribute(const std::string& name, const std::string& value)
+{
+    attributes[name] = value;
+}
+
+void ElementImp::removeAttribute(const std::string& name)
+{
+    attributes.erase(name);
+}
+
+bool ElementImp::hasAttribute(const std::string& name)
+{
+    return attributes.find(name) != attributes.end();
+}
+
+void ElementImp::scroll(bool alignToTop)
+{
+    printf("  scroll(%d)\n", alignToTop);
+}
+
+void ElementImp::scroll(double x, double y)
+{
+    printf("  scroll(%g, %g)\n", x, y);
+}
+
+HTMLElementImp::HTMLElementImp(const std::string& tagName) :
+    ElementImp(tagName),
+    hidden(false),
+    tabIndex(-1)
+{
+}
+
+std::string HTMLElementImp::getTitle()
+{
+    return getAttribute("title");
+}
+
+void HTMLElementImp::setTitle(const std::string& title)
+{
+    setAttribute("title", title);
+}
+
+std::string HTMLElementImp::getLang()
+{
+    return getAttribute("lang");
+}
+
+void HTMLElementImp::setLang(const std::string& lang)
+{
+    setAttribute("lang", lang);
+}
+
+bool HTMLElementImp::getHidden()
+{
+    return hidden;
+}
+
+void HTMLElementImp::setHidden(bool hidden)
+{
+    this->hidden = hidden;
+}
+
+int HTMLElementImp::getTabIndex()
+{
+    return tabIndex;
+}
+
+void HTMLElementImp::setTabIndex(int tabIndex)
+{
+    this->tabIndex = tabIndex;
+}
+
+void HTMLElementImp::click()
+{
+    printf("  click()\n");
+}
+
+void HTMLElementImp::focus()
+{
+    printf("  focus()\n");
+}
+
+void HTMLElementImp::focus(bool preventScroll)
+{
+    printf("  focus(%d)\n", preventScroll);
+}
+
+void HTMLElementImp::blur()
+{
+    printf("  blur()\n");
+}
+
+HTMLDivElementImp::HTMLDivElementImp() :
+    HTMLElementImp("div")
+{
+}
+
+std::string HTMLDivElementImp::getAlign()
+{
+    return getAttribute("align");
+}
+
+void HTMLDivElementImp::setAlign(const std::string& align)
+{
+    setAttribute("align", align);
+}
+
+HTMLSpanElementImp::HTMLSpanElementImp() :
+    HTMLElementImp("span")
+{
+}
+
+HTMLAnchorElementImp::HTMLAnchorElementImp() :
+    HTMLElementImp("a")
+{
+}
+
+std::string HTMLAnchorElementImp::getHref()
+{
+    return getAttribute("href");
+}
+
+void HTMLAnchorElementImp::setHref(const std::string& href)
+{
+    setAttribute("href", href);
+}
+
+std::string HTMLAnchorElementImp::getTarget()
+{
+    return getAttribute("target");
+}
+
+void HTMLAnchorElementImp::setTarget(const std::string& target)
+{
+    setAttribute("target", target);
+}
+
+HTMLImageElementImp::HTMLImageElementImp() :
+    HTMLElementImp("img"),
+    width(0),
+    height(0)
+{
+}
+
+std::string HTMLImageElementImp::getSrc()
+{
+    return getAttribute("src");
+}
+
+void HTMLImageElementImp::setSrc(const std::string& src)
+{
+    setAttribute("src", src);
+}
+
+unsigned int HTMLImageElementImp::getWidth()
+{
+    return width;
+}
+
+void HTMLImageElementImp::setWidth(unsigned int width)
+{
+    this->width = width;
+}
+
+unsigned int HTMLImageElementImp::getHeight()
+{
+    return height;
+}
+
+void HTMLImageElementImp::setHeight(unsigned int height)
+{
+    this->height = height;
+}
+
+HTMLInputElementImp::HTMLInputElementImp() :
+    HTMLElementImp("input"),
+    checked(false)
+{
+}
+
+std::string HTMLInputElementImp::getValue()
+{
+    return value;
+}
+
+void HTMLInputElementImp::setValue(const std::string& value)
+{
+    this->value = value;
+}
+
+bool HTMLInputElementImp::getChecked()
+{
+    return checked;
+}
+
+void HTMLInputElementImp::setChecked(bool checked)
+{
+    this->checked = checked;
+}
+
+void HTMLInputElementImp::select()
+{
+    printf("  select()\n");
+}
+
+}  // namespace bootstrap
@@ -19,9 +19,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-bool testInterface(const char* info, const char* qualifiedName, const char* name)
+bool testInterface(const Reflect::Interface& interface, const char* name)
 {
-    Reflect::Interface interface(info, qualifiedName);
     printf("'%s' '%s' '%s' %d %d %d\n",
            interface.getQualifiedModuleName().c_str(),
            interface.getName().c_str(),
@@ -49,11 +48,46 @@ bool testInterface(const char* info, const char* qualifiedName, const char* name
     return true;
 }
 
+bool testInterface(const char* info, const char* qualifiedName, const char* name)
+{
+    return testInterface(Reflect::Interface(info, qualifiedName), name);
+}
+
+// The same interface in the form generated with -string-pool, where 'X' and
+// 'createInstance' are pooled ahead of the interface
+const char pool[] =
+    /* 0 */ "1X"
+    /* 2 */ "14createInstance"
+    /* 18 */ "I1Y"
+    /* 21 */ "X22@"
+    /* 25 */ "F0v1x"
+    /* 30 */ "F0v1y"
+    /* 35 */ "Cs1K-2 "
+    /* 42 */ "N0v43@\0";
+
+bool testPooledInterface(const char* qualifiedName, const char* name)
+{
+    Reflect::Interface interface(pool + 18, qualifiedName);
+    if (interface.getQualifiedSuperName() != "X" ||
+        interface.getMethodCount() != 2 ||
+        interface.getMethod(1).getName() != "y" ||
+        interface.getConstant(0).getValue() != -2 ||
+        interface.getConstructor(0).getName() != "createInstance")
+    {
+        return false;
+    }
+    return testInterface(interface, name);
+}
+
 int main()
 {
     if (!testInterface("I1Y" "X1X" "F0v1x" "F0v1y" "Cs1K-2 " "N0v14createInstance", "::A::Y", "Y"))
     {
         return 1;
     }
+    if (!testPooledInterface("::A::Y", "Y"))
+    {
+        return 1;
+    }
     return 0;
 }
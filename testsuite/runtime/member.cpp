@@ -0,0 +1,57 @@
+/*
+ * Copyright 2009 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "reflect.h"
+
+#include <stdio.h>
+
+// A member table as generated into the messenger headers: the triples of
+// (selector, depth, number) sorted by selector.
+static const unsigned memberTable[] = {
+    0x1234, 1, 0,
+    0x5678, 0, 3,
+    0x9abc, 2, 1,
+    0xdef0, 0, 2,
+};
+
+bool testMember(unsigned selector, unsigned depth, unsigned number)
+{
+    const unsigned* entry = Reflect::findMember(memberTable, 4, selector);
+    if (!entry)
+    {
+        printf("0x%x not found\n", selector);
+        return false;
+    }
+    printf("0x%x %u %u\n", entry[0], entry[1], entry[2]);
+    return entry[0] == selector && entry[1] == depth && entry[2] == number;
+}
+
+int main()
+{
+    if (!testMember(0x1234, 1, 0) || !testMember(0x5678, 0, 3) ||
+        !testMember(0x9abc, 2, 1) || !testMember(0xdef0, 0, 2))
+    {
+        return 1;
+    }
+    if (Reflect::findMember(memberTable, 4, 0x1000) ||
+        Reflect::findMember(memberTable, 4, 0x6000) ||
+        Reflect::findMember(memberTable, 4, 0xffff) ||
+        Reflect::findMember(0, 0, 0x1234))
+    {
+        return 1;
+    }
+    return 0;
+}
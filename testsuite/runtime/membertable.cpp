@@ -0,0 +1,94 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Looks up the members of the interfaces in membertable.idl in the member
+// tables esidl -fmember-table has generated for them. membertable.sh copies
+// the initializers of the tables into A.table, B.table and C.table.
+
+#include "reflect.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const unsigned tableA[] =
+#include "A.table"
+
+static const unsigned tableB[] =
+#include "B.table"
+
+static const unsigned tableC[] =
+#include "C.table"
+
+// The selector of a member, i.e., the one-at-a-time hash of its name as
+// computed by esidl.
+static uint32_t getSelector(const char* name)
+{
+    uint32_t hash = 0;
+    for (size_t i = 0; i < strlen(name); ++i)
+    {
+        hash += name[i];
+        hash += (hash << 10);
+        hash ^= (hash >> 6);
+    }
+    hash += (hash << 3);
+    hash ^= (hash >> 11);
+    hash += (hash << 15);
+    return hash;
+}
+
+static bool testMember(const char* interface, const unsigned* table, unsigned size,
+                       const char* name, unsigned depth, unsigned number)
+{
+    const unsigned* entry = Reflect::findMember(table, size / 3, getSelector(name));
+    if (!entry)
+    {
+        printf("%s::%s not found\n", interface, name);
+        return false;
+    }
+    printf("%s::%s %u %u\n", interface, name, entry[1], entry[2]);
+    return entry[1] == depth && entry[2] == number;
+}
+
+#define TEST_MEMBER(interface, name, depth, number) \
+    testMember(#interface, table##interface, sizeof table##interface / sizeof(unsigned), name, depth, number)
+
+int main()
+{
+    // The members of A are numbered from zero. B overrides f, and C
+    // overrides g; the members of each interface are numbered after those
+    // of its base interface.
+    if (!TEST_MEMBER(A, "x", 0, 0) || !TEST_MEMBER(A, "f", 0, 1) || !TEST_MEMBER(A, "g", 0, 2) ||
+        !TEST_MEMBER(B, "x", 1, 0) || !TEST_MEMBER(B, "f", 0, 3) || !TEST_MEMBER(B, "g", 1, 2) ||
+        !TEST_MEMBER(B, "y", 0, 4) ||
+        !TEST_MEMBER(C, "x", 2, 0) || !TEST_MEMBER(C, "f", 1, 3) || !TEST_MEMBER(C, "g", 0, 5) ||
+        !TEST_MEMBER(C, "y", 1, 4) || !TEST_MEMBER(C, "z", 0, 6))
+    {
+        return 1;
+    }
+    if (sizeof tableA / sizeof(unsigned) != 3 * 3 ||
+        sizeof tableB / sizeof(unsigned) != 4 * 3 ||
+        sizeof tableC / sizeof(unsigned) != 5 * 3)
+    {
+        printf("unexpected table sizes\n");
+        return 1;
+    }
+    if (Reflect::findMember(tableA, 3, getSelector("y")) ||
+        Reflect::findMember(tableB, 4, getSelector("z")))
+    {
+        return 1;
+    }
+    return 0;
+}
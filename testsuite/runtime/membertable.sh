@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# Copyright 2013 Esrille Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Generates the messenger headers for membertable.idl with -fmember-table,
+# and looks up the inherited and the overridden members in the generated
+# member tables with membertable.cpp. Then checks that esidl rejects
+# membercollision.idl, in which two members of an interface have the same
+# selector.
+
+: ${CXX:=c++}
+: ${srcdir:=.}
+esidl=`pwd`/../../esidl
+dir=membertable.dir
+
+srcdir=`cd $srcdir && pwd`
+rm -rf $dir && mkdir $dir && cd $dir || exit 1
+$esidl -messenger -fmember-table -string std::string $srcdir/membertable.idl > /dev/null || exit 1
+for interface in A B C
+do
+    sed -n '/static const unsigned memberTable\[\] =/,/};/p' org/w3c/dom/membertable/$interface.h |
+        sed 1d > $interface.table
+    test -s $interface.table || exit 1
+done
+$CXX -iquote $srcdir/../../include -I . -o membertable $srcdir/membertable.cpp || exit 1
+./membertable || exit 1
+
+if $esidl -messenger -fmember-table -string std::string $srcdir/membercollision.idl > /dev/null 2> collision.log
+then
+    echo "membercollision.idl has not been rejected"
+    exit 1
+fi
+cat collision.log
+grep -q "'m11524' and 'm15200' of 'Q' have the same selector" collision.log
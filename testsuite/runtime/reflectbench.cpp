@@ -0,0 +1,265 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// reflectbench - measures the Reflect decoders over the reflection data of
+// dom/html5.idl.
+//
+// Usage: reflectbench [-t SECONDS] [FILTER]
+//
+// Each benchmark decodes every interface in html5meta.h, which reflectmeta
+// generates at build time, and is repeated with a doubling iteration count
+// until it runs for at least SECONDS (0.5 by default). The benchmarks whose
+// names contain FILTER are run, and the time per operation is reported in
+// nanoseconds as Google Benchmark does.
+
+#include "reflect.h"
+#include "html5meta.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+namespace
+{
+
+// Decoded once before the benchmarks run.
+std::vector<Reflect::Interface> interfaces;
+std::vector<Reflect::Method> methods;
+std::vector<const char*> types;
+
+// Accumulates the decoded values so that the compiler cannot optimize the
+// decoders away.
+volatile unsigned long sink;
+
+double getTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+// Each benchmark runs the specified number of passes over the interfaces
+// and returns the number of operations performed in a pass.
+typedef unsigned long (*Function)(unsigned long iterations);
+
+unsigned long constructInterfaces(unsigned long iterations)
+{
+    unsigned long ops = 0;
+    unsigned long value = 0;
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        ops = 0;
+        for (const char* const* info = metaData; *info; ++info, ++ops)
+        {
+            Reflect::Interface interface(*info);
+            value += interface.getMethodCount() + interface.getConstantCount();
+        }
+    }
+    sink += value;
+    return ops;
+}
+
+unsigned long enumerateMethods(unsigned long iterations)
+{
+    unsigned long ops = 0;
+    unsigned long value = 0;
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        ops = 0;
+        for (std::vector<Reflect::Interface>::const_iterator i = interfaces.begin(); i != interfaces.end(); ++i)
+        {
+            for (unsigned j = 0; j < i->getMethodCount(); ++j, ++ops)
+            {
+                Reflect::Method method = i->getMethod(j);
+                value += method.getType() + method.getReturnType().getType() + method.getParameterCount();
+            }
+        }
+    }
+    sink += value;
+    return ops;
+}
+
+unsigned long iterateParameters(unsigned long iterations)
+{
+    unsigned long ops = 0;
+    unsigned long value = 0;
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        ops = 0;
+        for (std::vector<Reflect::Method>::const_iterator i = methods.begin(); i != methods.end(); ++i)
+        {
+            Reflect::Parameter param = i->listParameter();
+            while (param.next())
+            {
+                value += param.getType().getType();
+                ++ops;
+            }
+        }
+    }
+    sink += value;
+    return ops;
+}
+
+unsigned long lookUpConstants(unsigned long iterations)
+{
+    unsigned long ops = 0;
+    double value = 0.0;
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        ops = 0;
+        for (std::vector<Reflect::Interface>::const_iterator i = interfaces.begin(); i != interfaces.end(); ++i)
+        {
+            for (unsigned j = 0; j < i->getConstantCount(); ++j, ++ops)
+            {
+                value += i->getConstant(j).getValue();
+            }
+        }
+    }
+    sink += static_cast<unsigned long>(value);
+    return ops;
+}
+
+// Collects the return and the parameter types of the operations, the
+// getters, the setters and the constructors in the reflection data.
+void collectTypes(const char* info, std::vector<const char*>& types)
+{
+    const char* p = Reflect::skipName(info + 1);
+    while (*p == Reflect::kExtends || *p == Reflect::kImplements)
+    {
+        p = Reflect::skipName(p + 1);
+    }
+    while (p && *p)
+    {
+        switch (*p)
+        {
+        case Reflect::kConstant:
+            p = Reflect::Constant::skip(p);
+            break;
+        case Reflect::kOperation:
+        case Reflect::kGetter:
+        case Reflect::kSetter:
+        case Reflect::kConstructor:
+            {
+                const char* type = Reflect::skipDigits(Reflect::Method::skipSpecial(p + 1));
+                types.push_back(type);
+                for (type = Reflect::skipName(Reflect::skipType(type)); Reflect::isParam(type); type = Reflect::skipName(Reflect::skipType(type)))
+                {
+                    types.push_back(type);
+                }
+                p = Reflect::Method::skip(p);
+            }
+            break;
+        default:
+            p = 0;
+            break;
+        }
+    }
+}
+
+unsigned long skipTypes(unsigned long iterations)
+{
+    unsigned long ops = 0;
+    unsigned long value = 0;
+    for (unsigned long n = 0; n < iterations; ++n)
+    {
+        ops = 0;
+        for (std::vector<const char*>::const_iterator i = types.begin(); i != types.end(); ++i, ++ops)
+        {
+            value += Reflect::skipType(*i) - *i;
+        }
+    }
+    sink += value;
+    return ops;
+}
+
+struct Benchmark
+{
+    const char* name;
+    Function function;
+};
+
+const Benchmark benchmarks[] =
+{
+    { "BM_InterfaceConstruction", constructInterfaces },
+    { "BM_MethodEnumeration", enumerateMethods },
+    { "BM_ParameterIteration", iterateParameters },
+    { "BM_ConstantLookup", lookUpConstants },
+    { "BM_SkipType", skipTypes },
+};
+
+void run(const Benchmark& benchmark, double minTime)
+{
+    unsigned long iterations = 1;
+    unsigned long ops;
+    double elapsed;
+    for (;;)
+    {
+        double start = getTime();
+        ops = benchmark.function(iterations);
+        elapsed = getTime() - start;
+        if (minTime <= elapsed || ops == 0)
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+    double total = static_cast<double>(ops) * iterations;
+    printf("%-28s %12.2f ns %12lu %12lu\n",
+           benchmark.name, (0 < total) ? elapsed * 1000000000.0 / total : 0.0, ops, iterations);
+    fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    double minTime = 0.5;
+    const char* filter = "";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            minTime = atof(argv[++i]);
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    for (const char* const* info = metaData; *info; ++info)
+    {
+        interfaces.push_back(Reflect::Interface(*info));
+        for (unsigned j = 0; j < interfaces.back().getMethodCount(); ++j)
+        {
+            methods.push_back(interfaces.back().getMethod(j));
+        }
+        collectTypes(*info, types);
+    }
+    printf("%zu interfaces\n", interfaces.size());
+    printf("%-28s %15s %12s %12s\n", "Benchmark", "Time/op", "Ops/pass", "Passes");
+    printf("-------------------------------------------------------------------\n");
+    for (size_t i = 0; i < sizeof benchmarks / sizeof benchmarks[0]; ++i)
+    {
+        if (strstr(benchmarks[i].name, filter))
+        {
+            run(benchmarks[i], minTime);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 Esrille Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// reflectmeta - prints the reflection data of the interfaces defined in an
+// IDL file as a C++ array of string literals for reflectbench.
+//
+// Usage: reflectmeta -select NAME [-I DIR]... FILE...
+//
+// Every FILE is compiled as esidl would, and the reflection data of each
+// interface defined in the file whose name ends with NAME is printed in the
+// same form as the info() function of the generated C++ headers.
+
+#include "compiler.h"
+#include "formatter.h"
+#include "info.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+
+bool endsWith(const std::string& s, const std::string& suffix)
+{
+    return suffix.size() <= s.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const char* select = 0;
+    Compiler::Options options;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-select") == 0 && i + 1 < argc)
+        {
+            select = argv[++i];
+        }
+        else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc)
+        {
+            options.cppOptions.push_back(argv[i]);
+            options.cppOptions.push_back(argv[++i]);
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (!select || files.empty())
+    {
+        fprintf(stderr, "Usage: reflectmeta -select NAME [-I DIR]... FILE...\n");
+        return EXIT_FAILURE;
+    }
+
+    Compiler compiler(options);
+    if (!compiler.parse(files) || !compiler.resolve())
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("// Generated by reflectmeta from %s. Do not edit.\n\n", select);
+    printf("static const char* const metaData[] =\n{");
+    fflush(stdout);
+    Formatter formatter(stdout, "es");
+    formatter.indent();
+    unsigned count = 0;
+    const std::vector<const Interface*>& interfaces = compiler.getDependencyGraph().getInterfaces();
+    for (std::vector<const Interface*>::const_iterator i = interfaces.begin(); i != interfaces.end(); ++i)
+    {
+        const Interface* interface = *i;
+        if (interface->isConstructor() ||
+            (interface->getAttr() & Interface::Supplemental) ||
+            !endsWith(interface->getSource(), select))
+        {
+            continue;
+        }
+        printf("\n    // %s", interface->getQualifiedName().c_str());
+        fflush(stdout);
+        Info info(&formatter);
+        const_cast<Interface*>(interface)->accept(&info);
+        info.flush();
+        printf(",\n");
+        ++count;
+    }
+    printf("    0\n};\n");
+    if (count == 0)
+    {
+        fprintf(stderr, "reflectmeta: no interface is defined in '%s'\n", select);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -38,5 +38,14 @@ int main()
     {
         return 1;
     }
+    if (!testSequence("Q*f", 'f') || !Reflect::Sequence("Q*f").isSpan())
+    {
+        return 1;
+    }
+    const char* span = "Q*8d";
+    if (Reflect::skipType(span) != span + 4 || Reflect::Sequence(span).getMax() != 8)
+    {
+        return 1;
+    }
     return 0;
 }